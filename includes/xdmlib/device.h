@@ -30,6 +30,7 @@
 #include "xdmlib/navigational_connectivity.h"
 #include "xdmlib/profiles.h"
 #include "xdmlib/vendor_info.h"
+#include "xmpmeta/xml/serializer.h"
 #include "xmpmeta/xmp_data.h"
 
 namespace xmpmeta {
@@ -75,6 +76,11 @@ class Device {
   // Saves Device metadata to a .xml file.
   bool SerializeToXmlFile(const char* filename);
 
+  // Writes the text of the extended XMP section that SerializeToXmp would
+  // create to xmp, without building an XML tree. The text has no XML
+  // declaration.
+  bool SerializeToXmpString(string* xmp) const;
+
   // Disallow copying.
   Device(const Device&) = delete;
   void operator=(const Device&) = delete;
@@ -92,6 +98,8 @@ class Device {
   // Parses Device fields and XDM children elements from xmlDocPtr.
   bool ParseFields(const xmlDocPtr& xmp);
   bool Serialize(xmlDocPtr* xmlDoc);
+  // Serializes Device fields and XDM children elements.
+  bool SerializeFields(xml::Serializer* device_serializer) const;
 
   // Keep a reference to the XML namespaces, so that they are created only once
   // when Device is constructed.
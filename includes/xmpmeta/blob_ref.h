@@ -0,0 +1,75 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_BLOB_REF_H_
+#define XMPMETA_BLOB_REF_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+
+namespace xmpmeta {
+
+// Receives data in pieces, in order. Returns false to stop the producer.
+typedef std::function<bool(const char* data, size_t length)> ByteSink;
+
+// A reference to the base64-encoded value of a property, such as GImage:Data,
+// where it lies in the extended XMP of a JPEG. The extended XMP is split over
+// several JPEG sections, so the value may be split into several segments.
+// The segments point into the JPEG data, which must outlive the reference.
+// Finding the value with FindExtendedXmpBlob() costs a SAX parse of the
+// extended XMP, but no XML tree or copy of the value.
+class BlobRef {
+ public:
+  struct Segment {
+    const char* data;
+    size_t length;
+  };
+
+  BlobRef();
+
+  // Appends the next segment of the encoded value.
+  void AddSegment(const char* data, size_t length);
+
+  // Removes all segments.
+  void Clear();
+
+  const std::vector<Segment>& Segments() const;
+
+  // Returns the length of the encoded value.
+  size_t EncodedLength() const;
+
+  // Decodes the value, passing the decoded bytes to the sink in blocks of a
+  // bounded size. Returns false if the value is not valid base64 or the sink
+  // returns false.
+  bool Decode(const ByteSink& sink) const;
+
+  // Decodes the value into output, which is allocated only once.
+  bool DecodeToString(string* output) const;
+
+  // Decodes the value into the given file, a block at a time, so that memory
+  // use does not grow with the size of the value. The file is removed if
+  // decoding fails.
+  bool DecodeToFile(const string& filename) const;
+
+ private:
+  std::vector<Segment> segments_;
+  size_t encoded_length_;
+};
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_BLOB_REF_H_
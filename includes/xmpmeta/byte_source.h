@@ -0,0 +1,75 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_BYTE_SOURCE_H_
+#define XMPMETA_BYTE_SOURCE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "base/integral_types.h"
+#include "base/port.h"
+
+namespace xmpmeta {
+
+// A range of bytes in a ByteSource.
+struct ByteRange {
+  size_t offset = 0;
+  size_t length = 0;
+};
+
+// Reads up to length bytes starting at offset into buffer, and returns the
+// number of bytes read. Fewer bytes are read only at the end of the data or
+// on failure.
+typedef std::function<size_t(size_t offset, size_t length, char* buffer)>
+    ByteSourceReader;
+
+// Random access to the bytes of a JPEG file, wherever they are stored.
+// Parsing from a ByteSource reads only the byte ranges it needs, so remote
+// data can be fetched with range requests.
+class ByteSource {
+ public:
+  virtual ~ByteSource() {}
+
+  // Returns the total number of bytes in the source.
+  virtual size_t Size() const = 0;
+
+  // Reads up to length bytes starting at offset into buffer, and returns the
+  // number of bytes read, which is less than length only at the end of the
+  // source or on failure.
+  virtual size_t ReadAt(size_t offset, size_t length, char* buffer) = 0;
+
+  // Reads from a buffer of the given size. The buffer is not copied, and must
+  // outlive the source.
+  static std::unique_ptr<ByteSource> FromMemory(const uint8* buffer,
+                                                size_t size);
+
+  // Reads from a file with positioned reads (pread).
+  // Returns null if the file could not be opened.
+  static std::unique_ptr<ByteSource> FromFile(const string& filename);
+
+  // Reads from a memory-mapped file.
+  // Returns null if the file could not be opened or mapped.
+  static std::unique_ptr<ByteSource> FromMappedFile(const string& filename);
+
+  // Reads the size bytes of the source with the given reader, for instance
+  // from range requests to an object store.
+  static std::unique_ptr<ByteSource> FromReader(size_t size,
+                                                const ByteSourceReader& reader);
+};
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_BYTE_SOURCE_H_
@@ -19,6 +19,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "base/integral_types.h"
+#include "xmpmeta/blob_ref.h"
 #include "xmpmeta/xmp_data.h"
 #include "xmpmeta/xml/serializer.h"
 
@@ -46,9 +48,25 @@ class GImage {
 
   // Creates a GImage by extracting XMP metadata from a JPEG and parsing it. If
   // using XMP for other things as well, FromXmp() should be used instead to
-  // prevent redundant extraction of XMP from the JPEG.
+  // prevent redundant extraction of XMP from the JPEG. The file name must end
+  // in .jpg or .jpeg, as for ReadXmpHeader().
   static std::unique_ptr<GImage> FromJpegFile(const string& filename);
 
+  // Locates the base64-encoded GImage data in the extended XMP of the JPEG data
+  // in the buffer, without building an XML tree of the extended XMP or
+  // copying the data. The data can then be decoded straight into its
+  // destination with BlobRef::Decode(). Checking where the data lies still
+  // takes a SAX parse of the whole extended XMP, and a pass over the data (see
+  // FindExtendedXmpBlob()). Returns false if there is no GImage metadata, or if
+  // the data cannot be located in place, in which case FromXmp() can still
+  // read it.
+  static bool FindData(const uint8* buffer, size_t size, BlobRef* data_ref);
+
+  // Same as above, but also sets the mime type of the data, which is read from
+  // the standard XMP.
+  static bool FindData(const uint8* buffer, size_t size, string* mime,
+                       BlobRef* data_ref);
+
   // Determines whether the requisite fields are present in the XMP metadata.
   // Only the Mime field is checked in order to make this fast. Therefore,
   // extended XMP is not needed.
@@ -58,6 +76,10 @@ class GImage {
   // already extracted metadata.
   static bool IsPresent(const string& filename);
 
+  // Same as above but scans the XML content of a standard XMP packet, e.g. one
+  // found with FindStandardXmpPacket(), without building a tree of it.
+  static bool IsPresent(const char* xmp_packet, size_t length);
+
   // Returns the GImage data, which has been base-64 decoded but is still
   // encoded according to the mime type of the GImage.
   const string& GetData() const;
@@ -82,6 +104,19 @@ class GImage {
   string mime_;
 };
 
+// Decodes the GImage data of the JPEG file into the output file as the data
+// is read, holding no more than a fixed-size block of it in memory at a time,
+// rather than all of it as GImage::FromJpegFile() does. The rest of the
+// extended XMP is still parsed to check where the data lies, so the memory
+// used grows with the size of its other properties, but not with that of the
+// data. If the data cannot be located in place (see GImage::FindData()), the
+// extended XMP is parsed and all of the data is decoded before it is written.
+// The JPEG file name must end in .jpg or .jpeg, as for ReadXmpHeader(), and
+// the output file must not be the JPEG file. Returns false if either does not
+// hold, if the JPEG has no GImage data, or if the output cannot be written.
+bool ExtractGImageToFile(const string& jpeg_filename,
+                         const string& output_filename);
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_GIMAGE_H_
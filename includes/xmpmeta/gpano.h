@@ -19,6 +19,7 @@
 #include <string>
 #include <unordered_map>
 
+#include "base/integral_types.h"
 #include "xmpmeta/pano_meta_data.h"
 #include "xmpmeta/xmp_data.h"
 #include "xmpmeta/xml/serializer.h"
@@ -42,11 +43,29 @@ class GPano {
   // fails. Extended XMP is not needed.
   static std::unique_ptr<GPano> FromXmp(const XmpData& xmp);
 
-  // Creates a GPano by extracting XMP metadata from a JPEG and parsing it. If
-  // using XMP for other things as well, FromXmp() should be used instead to
-  // prevent redundant extraction of XMP from the JPEG.
+  // Creates a GPano by extracting XMP metadata from a JPEG and parsing it with
+  // ReadPanoMetaData(). As with ReadXmpHeader(), the file name must have a
+  // .jpg or .jpeg extension. If using XMP for other things as well, FromXmp()
+  // should be used instead to prevent redundant extraction of XMP from the
+  // JPEG.
   static std::unique_ptr<GPano> FromJpegFile(const string& filename);
 
+  // Reads the GPano fields straight from the standard XMP packet of the JPEG
+  // data in the buffer into meta_data, scanning the packet once without
+  // building an XML tree. Gives the same result as ReadXmpFromMemory()
+  // followed by FromXmp(), at a fraction of the cost, and is meant for callers
+  // that only need the panorama metadata: the whole packet must be well
+  // formed, and the fields are read from its first rdf:Description element.
+  // Returns false, leaving meta_data untouched, if there is no valid GPano
+  // metadata.
+  static bool ReadPanoMetaData(const uint8* buffer, size_t size,
+                               PanoMetaData* meta_data);
+
+  // Same as above, but scans an XMP packet that has already been extracted
+  // from the JPEG.
+  static bool ParsePanoMetaData(const char* xmp_packet, size_t length,
+                                PanoMetaData* meta_data);
+
   // Returns the GPano data formatted as PanoMetaData.
   const PanoMetaData& GetPanoMetaData() const;
 
@@ -18,7 +18,9 @@
 #include <string>
 #include <vector>
 
+#include "base/integral_types.h"
 #include "base/port.h"
+#include "xmpmeta/byte_source.h"
 
 namespace xmpmeta {
 
@@ -37,6 +39,40 @@ struct Section {
   string data;
 };
 
+// A view of a section in a JPEG image that is held in memory. Unlike Section,
+// the section's data is not copied; it points into the parsed buffer, which
+// must outlive the view.
+struct SectionView {
+  // Returns true if the section's marker matches an APP1 marker.
+  bool IsMarkerApp1() const;
+
+  int marker = 0;
+  bool is_image_section = false;
+  // Location of the section's data in the parsed buffer, excluding the marker
+  // and length bytes.
+  size_t offset = 0;
+  size_t length = 0;
+  // Points to the first byte of the section's data in the parsed buffer.
+  const char* data = nullptr;
+};
+
+// The location of a section in a JPEG file, without its data.
+struct SectionIndex {
+  // Returns true if the section's marker matches an APP1 marker.
+  bool IsMarkerApp1() const;
+
+  // Returns true if this is the image data that follows the start of scan.
+  bool IsImageSection() const;
+
+  int marker = 0;
+  // Offset of the section's data from the start of the JPEG data, excluding
+  // the marker and length bytes.
+  size_t file_offset = 0;
+  // Length of the section's data. For the image section, this extends to the
+  // end of the file.
+  size_t length = 0;
+};
+
 struct ParseOptions {
   // If set to true, keeps only the EXIF and XMP sections (with
   // marker kApp1) and ignores others. Otherwise, keeps everything including
@@ -55,10 +91,46 @@ struct ParseOptions {
 };
 
 
-// Parses the JPEG image file.
+// Parses the JPEG image file. The stream is only read forward, never seeked,
+// so it may be a pipe or socket. If options.read_meta_only is set, reading
+// stops at the start of the image data.
 std::vector<Section> Parse(const ParseOptions& options,
                            std::istream* input_stream);
 
+// Parses a JPEG image that has already been read into memory. No section data
+// is copied; the returned views point into buffer.
+std::vector<SectionView> ParseSectionViews(const ParseOptions& options,
+                                           const uint8* buffer, size_t size);
+
+// Parses a JPEG image from a byte source, reading only the section headers
+// and the data of the sections that are returned. If fetched_ranges is not
+// null, the byte ranges read from the source are appended to it in order,
+// with adjacent ranges merged.
+std::vector<Section> Parse(const ParseOptions& options, ByteSource* source,
+                           std::vector<ByteRange>* fetched_ranges);
+
+// Returns the locations of all sections in the JPEG image, up to and
+// including the image section. No section data is read; the stream is seeked
+// past each section, and its position is restored before returning. Offsets
+// are relative to the stream's position when this is called.
+std::vector<SectionIndex> IndexSections(std::istream* input_stream);
+
+// Same as above, for a JPEG image that has already been read into memory.
+std::vector<SectionIndex> IndexSections(const uint8* buffer, size_t size);
+
+// Reads the data of the given section from the stream, which must be
+// positioned where it was when the section was indexed. Restores the stream
+// position before returning. Returns false if the data could not be read.
+bool ReadSectionData(const SectionIndex& section, std::istream* input_stream,
+                     string* data);
+
+// Returns the start of image marker, which begins every JPEG file.
+string GetStartOfImageMarker();
+
+// Returns the marker and, unless it is the image section, the 2-byte length
+// that precede a section's data of the given length in a JPEG file.
+string GetSectionHeader(int marker, bool is_image_section, size_t length);
+
 // Writes JPEG data sections to a file.
 void WriteSections(const std::vector<Section>& sections,
                    std::ostream* output_stream);
@@ -0,0 +1,85 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XMP_BATCH_H_
+#define XMPMETA_XMP_BATCH_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+#include "xmpmeta/xmp_data.h"
+
+namespace xmpmeta {
+
+struct BatchOptions {
+  // Number of worker threads. If zero, one per hardware thread is used.
+  int num_threads = 0;
+
+  // If true, the extended XMP sections are not read.
+  bool skip_extended = false;
+
+  // If true, the extended XMP sections are read but only parsed on the first
+  // call to XmpData::ExtendedSection(). Ignored if skip_extended is set.
+  bool lazy_extended = false;
+
+  // If true, only the presence of GPano and GImage metadata is reported, and
+  // the XMP data is not returned. The standard XMP packet is scanned for the
+  // properties without building a tree of it, and the extended sections are
+  // never read.
+  bool presence_only = false;
+};
+
+// The result of extracting XMP from one file.
+struct BatchFileResult {
+  // True if the XMP was read. With presence_only, true if the standard XMP
+  // packet was found; it is not checked to be well formed.
+  bool success = false;
+
+  // The XMP data. Null if presence_only was set or the XMP was not read.
+  std::unique_ptr<XmpData> xmp_data;
+
+  // Whether the file has GPano (photo sphere) and GImage metadata.
+  bool has_gpano = false;
+  bool has_gimage = false;
+
+  // Time spent reading and parsing this file.
+  double seconds = 0;
+};
+
+struct BatchResult {
+  // One result per input path, in the same order.
+  std::vector<BatchFileResult> files;
+
+  // Number of files whose XMP was read.
+  int num_succeeded = 0;
+
+  // Elapsed time for the whole batch.
+  double wall_seconds = 0;
+
+  // Sum and maximum of the time spent on each file, across all threads.
+  double total_file_seconds = 0;
+  double max_file_seconds = 0;
+};
+
+// Extracts the XMP metadata of the given JPEG files in parallel. The files
+// are spread over a pool of worker threads, which steal work from each other
+// when they run out, so a few slow files do not hold up the batch.
+BatchResult ExtractXmpBatch(const std::vector<string>& paths,
+                            const BatchOptions& options);
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XMP_BATCH_H_
@@ -15,6 +15,10 @@
 #ifndef XMPMETA_XMP_DATA_H_
 #define XMPMETA_XMP_DATA_H_
 
+#include <functional>
+#include <memory>
+#include <mutex>
+
 #include <libxml/tree.h>
 
 namespace xmpmeta {
@@ -28,19 +32,38 @@ class XmpData {
   ~XmpData();
 
   // Frees any allocated resources and resets the xmlDocPtrs to null.
+  // Drops the extended section loader, if any, without running it.
   void Reset();
 
   // The standard XMP section.
   const xmlDocPtr StandardSection() const;
   xmlDocPtr* MutableStandardSection();
 
-  // The extended XMP section.
+  // The extended XMP section. If a loader has been set, the first call to
+  // either method runs it to parse the section. Concurrent first calls are
+  // safe, and wait for the one that runs the loader.
   const xmlDocPtr ExtendedSection() const;
   xmlDocPtr* MutableExtendedSection();
 
+  // Sets a function that returns the parsed extended section, or null if it
+  // cannot be parsed, to be run on the first access to the extended section.
+  // Frees the current extended section. Must not be called concurrently with
+  // any other method.
+  void SetExtendedSectionLoader(const std::function<xmlDocPtr()>& loader);
+
+  // Disallow copying.
+  XmpData(const XmpData&) = delete;
+  void operator=(const XmpData&) = delete;
+
  private:
+  // Runs the extended section loader if it has not been run yet.
+  void LoadExtendedSection() const;
+
   xmlDocPtr xmp_;
-  xmlDocPtr xmp_extended_;
+  mutable xmlDocPtr xmp_extended_;
+  mutable std::function<xmlDocPtr()> extended_loader_;
+  // Null unless a loader has been set.
+  std::unique_ptr<std::once_flag> extended_loaded_;
 };
 
 }  // namespace xmpmeta
@@ -17,25 +17,104 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
 
+#include "base/integral_types.h"
 #include "base/port.h"
+#include "xmpmeta/blob_ref.h"
+#include "xmpmeta/byte_source.h"
 #include "xmpmeta/xmp_data.h"
 
 namespace xmpmeta {
 
+// How to read the extended XMP section.
+enum class ExtendedXmp {
+  // Parse the extended section along with the standard one.
+  kParse,
+  // Do not read the extended section.
+  kSkip,
+  // Only locate the extended section, and parse it on the first call to
+  // XmpData::ExtendedSection(). Whatever data the extended section is parsed
+  // from is kept until then. Reading fails if the extended section cannot be
+  // found, but if it cannot be parsed, ExtendedSection() returns null.
+  kLazy,
+};
+
 // Populates a XmpData from the header of the JPEG file.
 bool ReadXmpHeader(const string& filename, bool skip_extended,
                    XmpData* xmp_data);
 
+// Same as above, but reads the extended section as given. With
+// ExtendedXmp::kLazy, callers that may or may not need the extended section,
+// e.g. to check GImage::IsPresent() before reading the image, only pay for
+// parsing it when they do. The file stays mapped until it is parsed.
+bool ReadXmpHeader(const string& filename, ExtendedXmp extended,
+                   XmpData* xmp_data);
+
 // Populates a XmpData from the header of JPEG file that has already been read
 // into memory.
 bool ReadXmpFromMemory(const string& jpeg_contents, bool skip_extended,
                        XmpData* xmp_data);
 
+// Same as above, but reads the JPEG file contents from a buffer of the given
+// size. The buffer is not copied.
+bool ReadXmpFromMemory(const uint8* buffer, size_t size, bool skip_extended,
+                       XmpData* xmp_data);
+
+// Returns true if the file name has a .jpg or .jpeg extension, in any case,
+// which ReadXmpHeader() requires of the files it reads.
+bool HasJpegExtension(const string& filename);
+
+// Finds the standard XMP packet of the JPEG data in the buffer without parsing
+// it. On success, points xmp_packet at the XML content of the packet, which
+// lies inside the buffer, and sets its length. This lets callers that need
+// only a few properties scan the packet rather than build an XML tree of it.
+bool FindStandardXmpPacket(const uint8* buffer, size_t size,
+                           const char** xmp_packet, size_t* xmp_packet_length);
+
+// Locates the value of the given property in the extended XMP of the JPEG
+// data in the buffer, without building a tree of the extended XMP or copying
+// the value. xmp_data must hold the standard section read from the same
+// buffer, e.g. with ReadXmpFromMemory() and skip_extended set, which names the
+// extended sections. This is meant for large base64 values such as
+// GImage:Data, which can then be decoded straight from the buffer with
+// BlobRef::Decode(). The property is looked up as DeserializerImpl does, in
+// the first rdf:Description element: the extended XMP is parsed with a SAX
+// parser, with the text of the value left out so that the parser does not hold
+// it, and the characters of the value are checked in place. Returns false if
+// the property is not found, or if its text is not its value, e.g. because it
+// holds entity references or a CDATA section; the extended XMP must then be
+// parsed to read the value.
+bool FindExtendedXmpBlob(const uint8* buffer, size_t size,
+                         const XmpData& xmp_data, const string& prefix,
+                         const string& name, BlobRef* blob);
+
 // Populates a XmpData from the header of the given stream (stream data is
-// in JPEG format).
+// in JPEG format). The stream is only read up to the image data, and is never
+// seeked, so it may be a pipe or socket.
 bool ReadXmpHeader(std::istream* input_stream, bool skip_extended,
                    XmpData* xmp_data);
+
+// Populates a XmpData from the header of the JPEG data in the byte source.
+// Only the section headers and the XMP sections are read; the image data is
+// never fetched. If fetched_ranges is not null, the byte ranges read from the
+// source are appended to it.
+bool ReadXmpFromSource(ByteSource* source, bool skip_extended,
+                       XmpData* xmp_data,
+                       std::vector<ByteRange>* fetched_ranges);
+
+// Same as above, but reads the extended section as given. With
+// ExtendedXmp::kLazy, the extended sections are read from the source but kept
+// unparsed until the first call to XmpData::ExtendedSection().
+bool ReadXmpFromSource(ByteSource* source, ExtendedXmp extended,
+                       XmpData* xmp_data,
+                       std::vector<ByteRange>* fetched_ranges);
+
+// Same as FindStandardXmpPacket(), but for the JPEG data in the byte source.
+// Only the section headers and the standard XMP section are read, and the
+// XML content of the packet is copied into xmp_packet.
+bool ReadStandardXmpPacket(ByteSource* source, string* xmp_packet);
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_XMP_PARSER_H_
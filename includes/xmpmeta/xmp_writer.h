@@ -24,6 +24,15 @@
 
 namespace xmpmeta {
 
+// Options for writing XMP data to a JPEG image.
+struct XmpWriteOptions {
+  // Number of bytes of whitespace padding to reserve in the standard XMP
+  // section, so that it can later grow by up to that much with
+  // UpdateXmpInPlace. The padding is reduced to what fits in the section. If
+  // zero, the standard section is written without an XMP packet wrapper.
+  size_t padding_size = 0;
+};
+
 // Creates a new XmpData object and initializes the boilerplate for the
 // standard XMP section.
 // The extended section is initialized only if create_extended is true.
@@ -43,6 +52,33 @@ bool WriteLeftEyeAndXmpMeta(const string& left_data, const string& filename,
 bool AddXmpMetaToJpegStream(std::istream* input_jpeg_stream,
                             const XmpData& xmp_data,
                             std::ostream* output_jpeg_stream);
+bool AddXmpMetaToJpegStream(std::istream* input_jpeg_stream,
+                            const XmpData& xmp_data,
+                            const XmpWriteOptions& options,
+                            std::ostream* output_jpeg_stream);
+
+// Writes a copy of a JPEG file with new XMP data to the output file, which
+// must differ from the input file. The image data is copied between the files
+// without being read into memory where the platform allows it.
+// Returns false if the input file is not a JPEG file, the output file is the
+// input file, or either file could not be opened. The output file is written
+// in full or not at all.
+bool AddXmpMetaToJpegFile(const string& input_filename,
+                          const XmpData& xmp_data,
+                          const string& output_filename);
+bool AddXmpMetaToJpegFile(const string& input_filename,
+                          const XmpData& xmp_data,
+                          const XmpWriteOptions& options,
+                          const string& output_filename);
+
+// Replaces the standard XMP section of a JPEG file with the given XMP data by
+// overwriting it in place, without rewriting the rest of the file. The new
+// XMP is wrapped in an XMP packet padded to the size of the old section.
+// Returns false, leaving the file unchanged, if there is no standard XMP
+// section, if the new data does not fit in it, or if the extended section
+// differs from the one in the file; the file must then be rewritten with
+// AddXmpMetaToJpegFile.
+bool UpdateXmpInPlace(const string& filename, const XmpData& xmp_data);
 
 }  // namespace xmpmeta
 
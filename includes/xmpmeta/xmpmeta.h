@@ -16,6 +16,8 @@
 #define XMPMETA_PUBLIC_XMPMETA_H_
 
 #include "xmpmeta/base64.h"
+#include "xmpmeta/blob_ref.h"
+#include "xmpmeta/byte_source.h"
 #include "xmpmeta/gaudio.h"
 #include "xmpmeta/gimage.h"
 #include "xmpmeta/md5.h"
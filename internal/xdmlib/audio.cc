@@ -19,6 +19,7 @@
 #include "xmpmeta/base64.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -31,6 +32,9 @@ const char kMimeMp4[] = "audio/mp4";
 
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/audio/";
 
+// The properties read by ParseAudioFields.
+const char* const kPropertyNames[] = {kMime, kData};
+
 }  // namespace
 
 // Private constructor.
@@ -94,10 +98,13 @@ bool Audio::Serialize(Serializer* serializer) const {
 
 // Private methods.
 bool Audio::ParseAudioFields(const Deserializer& deserializer) {
-  if (!deserializer.ParseString(XdmConst::Audio(), kMime, &mime_)) {
+  const char* prefix = XdmConst::Audio();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
+  if (!properties.ParseString(prefix, kMime, &mime_)) {
     return false;
   }
-  return deserializer.ParseBase64(XdmConst::Audio(), kData , &data_);
+  return properties.ParseBase64(prefix, kData, &data_);
 }
 
 }  // namespace xdm
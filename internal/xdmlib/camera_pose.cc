@@ -17,9 +17,11 @@
 #include <math.h>
 
 #include "glog/logging.h"
+#include "strings/numbers.h"
 #include "xdmlib/const.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -36,6 +38,11 @@ const char kRotationAngle[] = "RotationAngle";
 const char kTimestamp[] = "Timestamp";
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/camerapose/";
 
+// The properties read by ParseCameraPoseFields.
+const char* const kPropertyNames[] = {
+    kPositionX,     kPositionY,     kPositionZ,     kRotationAxisX,
+    kRotationAxisY, kRotationAxisZ, kRotationAngle, kTimestamp};
+
 const std::vector<double>
 NormalizeAxisAngle(const std::vector<double>& coords) {
   if (coords.size() < 4) {
@@ -129,29 +136,29 @@ bool CameraPose::Serialize(Serializer* serializer) const {
   bool success = true;
   if (position_.size() == 3) {
     success &=
-        serializer->WriteProperty(XdmConst::CameraPose(), kPositionX,
-                                  std::to_string(position_[0])) &&
-        serializer->WriteProperty(XdmConst::CameraPose(), kPositionY,
-                                  std::to_string(position_[1])) &&
-        serializer->WriteProperty(XdmConst::CameraPose(), kPositionZ,
-                                  std::to_string(position_[2]));
+        serializer->WriteDoubleProperty(XdmConst::CameraPose(), kPositionX,
+                                        position_[0]) &&
+        serializer->WriteDoubleProperty(XdmConst::CameraPose(), kPositionY,
+                                        position_[1]) &&
+        serializer->WriteDoubleProperty(XdmConst::CameraPose(), kPositionZ,
+                                        position_[2]);
   }
 
   if (orientation_.size() == 4) {
     success &=
-        serializer->WriteProperty(XdmConst::CameraPose(), kRotationAxisX,
-                                  std::to_string(orientation_[0])) &&
-        serializer->WriteProperty(XdmConst::CameraPose(), kRotationAxisY,
-                                  std::to_string(orientation_[1])) &&
-        serializer->WriteProperty(XdmConst::CameraPose(), kRotationAxisZ,
-                                  std::to_string(orientation_[2])) &&
-        serializer->WriteProperty(XdmConst::CameraPose(), kRotationAngle,
-                                  std::to_string(orientation_[3]));
+        serializer->WriteDoubleProperty(XdmConst::CameraPose(), kRotationAxisX,
+                                        orientation_[0]) &&
+        serializer->WriteDoubleProperty(XdmConst::CameraPose(), kRotationAxisY,
+                                        orientation_[1]) &&
+        serializer->WriteDoubleProperty(XdmConst::CameraPose(), kRotationAxisZ,
+                                        orientation_[2]) &&
+        serializer->WriteDoubleProperty(XdmConst::CameraPose(), kRotationAngle,
+                                        orientation_[3]);
   }
 
   if (timestamp_ >= 0) {
     serializer->WriteProperty(XdmConst::CameraPose(), kTimestamp,
-                              std::to_string(timestamp_));
+                              SimpleItoa(timestamp_));
   }
 
   return success;
@@ -159,29 +166,31 @@ bool CameraPose::Serialize(Serializer* serializer) const {
 
 // Private methods.
 bool CameraPose::ParseCameraPoseFields(const Deserializer& deserializer) {
+  const char* prefix = XdmConst::CameraPose();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
   double x, y, z;
-  const string& prefix = XdmConst::CameraPose();
   // If a position field is present, the rest must be as well.
-  if (deserializer.ParseDouble(prefix, kPositionX, &x)) {
-    if (!deserializer.ParseDouble(prefix, kPositionY, &y)) {
+  if (properties.ParseDouble(prefix, kPositionX, &x)) {
+    if (!properties.ParseDouble(prefix, kPositionY, &y)) {
       return false;
     }
-    if (!deserializer.ParseDouble(prefix, kPositionZ, &z)) {
+    if (!properties.ParseDouble(prefix, kPositionZ, &z)) {
       return false;
     }
     position_ = { x, y, z };
   }
 
   // Same for orientation.
-  if (deserializer.ParseDouble(prefix, kRotationAxisX, &x)) {
-    if (!deserializer.ParseDouble(prefix, kRotationAxisY, &y)) {
+  if (properties.ParseDouble(prefix, kRotationAxisX, &x)) {
+    if (!properties.ParseDouble(prefix, kRotationAxisY, &y)) {
       return false;
     }
-    if (!deserializer.ParseDouble(prefix, kRotationAxisZ, &z)) {
+    if (!properties.ParseDouble(prefix, kRotationAxisZ, &z)) {
       return false;
     }
     double angle;
-    if (!deserializer.ParseDouble(prefix, kRotationAngle, &angle)) {
+    if (!properties.ParseDouble(prefix, kRotationAngle, &angle)) {
       return false;
     }
     std::vector<double> axis_angle = { x, y, z, angle };
@@ -192,7 +201,7 @@ bool CameraPose::ParseCameraPoseFields(const Deserializer& deserializer) {
     return false;
   }
 
-  deserializer.ParseLong(prefix, kTimestamp, &timestamp_);
+  properties.ParseLong(prefix, kTimestamp, &timestamp_);
   return true;
 }
 
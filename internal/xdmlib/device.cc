@@ -23,19 +23,21 @@
 #include "xdmlib/vendor_info.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
-#include "xmpmeta/xml/search.h"
+#include "xmpmeta/xml/node_index.h"
 #include "xmpmeta/xml/serializer_impl.h"
+#include "xmpmeta/xml/stream_serializer.h"
 #include "xmpmeta/xml/utils.h"
 #include "xmpmeta/xmp_data.h"
 #include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xmp_writer.h"
 
-using xmpmeta::xml::DepthFirstSearch;
 using xmpmeta::xml::Deserializer;
 using xmpmeta::xml::DeserializerImpl;
 using xmpmeta::xml::GetFirstDescriptionElement;
+using xmpmeta::xml::NodeIndex;
 using xmpmeta::xml::Serializer;
 using xmpmeta::xml::SerializerImpl;
+using xmpmeta::xml::StreamSerializer;
 using xmpmeta::xml::ToXmlChar;
 using xmpmeta::xml::XmlConst;
 
@@ -140,6 +142,33 @@ bool Device::SerializeToXmlFile(const char* filename) {
   return xmlSaveFile(filename, xmp_data->ExtendedSection()) != -1;
 }
 
+bool Device::SerializeToXmpString(string* xmp) const {
+  if (xmp == nullptr) {
+    LOG(ERROR) << "Output string is null";
+    return false;
+  }
+  std::unordered_map<string, string> namespaces;
+  GetNamespaces(&namespaces);
+  std::unique_ptr<StreamSerializer> serializer =
+      StreamSerializer::FromXmpDescription(namespaces, xmp);
+  if (serializer == nullptr) {
+    return false;
+  }
+
+  // As in Serialize, the Device node has no prefix.
+  std::unique_ptr<Serializer> device_serializer =
+      serializer->CreateSerializer("", XdmConst::Device());
+  if (device_serializer == nullptr) {
+    LOG(ERROR) << "Could not create a serializer for the Device node";
+    return false;
+  }
+  if (!SerializeFields(device_serializer.get())) {
+    return false;
+  }
+  serializer->Finish();
+  return true;
+}
+
 // Private methods.
 bool Device::Serialize(xmlDocPtr* xmlDoc) {
   xmlNodePtr root_node = GetFirstDescriptionElement(*xmlDoc);
@@ -164,34 +193,37 @@ bool Device::Serialize(xmlDocPtr* xmlDoc) {
 
   // Set up serialization on the first description node in the extended section.
   SerializerImpl device_serializer(namespaces_, device_node);
+  return SerializeFields(&device_serializer);
+}
 
+bool Device::SerializeFields(Serializer* device_serializer) const {
   // Serialize fields.
-  if (!device_serializer.WriteProperty(XdmConst::Device(), kRevision,
-                                       revision_)) {
+  if (!device_serializer->WriteProperty(XdmConst::Device(), kRevision,
+                                        revision_)) {
     return false;
   }
 
   // Serialize elements.
   if (device_pose_) {
     std::unique_ptr<Serializer> pose_serializer =
-        device_serializer.CreateSerializer(
+        device_serializer->CreateSerializer(
             XdmConst::Namespace(XdmConst::DevicePose()),
             XdmConst::DevicePose());
     if (!device_pose_->Serialize(pose_serializer.get())) {
       return false;
     }
   }
-  if (profiles_ && !profiles_->Serialize(&device_serializer)) {
+  if (profiles_ && !profiles_->Serialize(device_serializer)) {
     return false;
   }
-  if (cameras_ && !cameras_->Serialize(&device_serializer)) {
+  if (cameras_ && !cameras_->Serialize(device_serializer)) {
     return false;
   }
 
   if (vendor_info_) {
     std::unique_ptr<Serializer> vendor_info_serializer =
-        device_serializer.CreateSerializer(XdmConst::Device(),
-                                           XdmConst::VendorInfo());
+        device_serializer->CreateSerializer(XdmConst::Device(),
+                                            XdmConst::VendorInfo());
     if (!vendor_info_->Serialize(vendor_info_serializer.get())) {
       return false;
     }
@@ -199,8 +231,8 @@ bool Device::Serialize(xmlDocPtr* xmlDoc) {
 
   if (mesh_) {
     std::unique_ptr<Serializer> mesh_serializer =
-        device_serializer.CreateSerializer(XdmConst::Device(),
-                                           XdmConst::Mesh());
+        device_serializer->CreateSerializer(XdmConst::Device(),
+                                            XdmConst::Mesh());
     if (!mesh_->Serialize(mesh_serializer.get())) {
       return false;
     }
@@ -208,7 +240,7 @@ bool Device::Serialize(xmlDocPtr* xmlDoc) {
 
   if (navigational_connectivity_) {
     std::unique_ptr<Serializer> navigational_connectivity_serializer =
-        device_serializer.CreateSerializer(
+        device_serializer->CreateSerializer(
             XdmConst::Device(), XdmConst::NavigationalConnectivity());
     if (!navigational_connectivity_->Serialize(
             navigational_connectivity_serializer.get())) {
@@ -260,12 +292,18 @@ bool Device::ParseFields(const xmlDocPtr& xmlDoc) {
   // Find and parse the Device node.
   // Only these two fields are required to be present; the rest are optional.
   // TODO(miraleung): Search for Device by namespace.
-  xmlNodePtr device_node = DepthFirstSearch(xmlDoc, XdmConst::Device());
+  // The index replaces the traversals of the tree done for each property of
+  // each element, which add up for devices with many cameras.
+  std::unique_ptr<NodeIndex> index = NodeIndex::FromDoc(xmlDoc);
+  if (index == nullptr) {
+    return false;
+  }
+  xmlNodePtr device_node = index->Find("", XdmConst::Device());
   if (device_node == nullptr) {
     LOG(ERROR) << "No device node found";
     return false;
   }
-  const DeserializerImpl deserializer(device_node);
+  const DeserializerImpl deserializer(device_node, index.get());
   if (!deserializer.ParseString(XdmConst::Device(), kRevision, &revision_)) {
     return false;
   }
@@ -17,9 +17,11 @@
 #include <math.h>
 
 #include "glog/logging.h"
+#include "strings/numbers.h"
 #include "xdmlib/const.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -36,6 +38,11 @@ const char kRotationAngle[] = "RotationAngle";
 const char kTimestamp[] = "Timestamp";
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/devicepose/";
 
+// The properties read by ParseDevicePoseFields.
+const char* const kPropertyNames[] = {
+    kLatitude,      kLongitude,     kAltitude,      kRotationAxisX,
+    kRotationAxisY, kRotationAxisZ, kRotationAngle, kTimestamp};
+
 const std::vector<double>
 NormalizeAxisAngle(const std::vector<double>& coords) {
   if (coords.size() < 4) {
@@ -129,29 +136,29 @@ bool DevicePose::Serialize(Serializer* serializer) const {
   bool success = true;
   if (position_.size() == 3) {
     success &=
-        serializer->WriteProperty(XdmConst::DevicePose(), kLatitude,
-                                  std::to_string(position_[0])) &&
-        serializer->WriteProperty(XdmConst::DevicePose(), kLongitude,
-                                   std::to_string(position_[1])) &&
-        serializer->WriteProperty(XdmConst::DevicePose(), kAltitude,
-                                  std::to_string(position_[2]));
+        serializer->WriteDoubleProperty(XdmConst::DevicePose(), kLatitude,
+                                        position_[0]) &&
+        serializer->WriteDoubleProperty(XdmConst::DevicePose(), kLongitude,
+                                        position_[1]) &&
+        serializer->WriteDoubleProperty(XdmConst::DevicePose(), kAltitude,
+                                        position_[2]);
   }
 
   if (orientation_.size() == 4) {
     success &=
-        serializer->WriteProperty(XdmConst::DevicePose(), kRotationAxisX,
-                                  std::to_string(orientation_[0])) &&
-        serializer->WriteProperty(XdmConst::DevicePose(), kRotationAxisY,
-                                  std::to_string(orientation_[1])) &&
-        serializer->WriteProperty(XdmConst::DevicePose(), kRotationAxisZ,
-                                  std::to_string(orientation_[2])) &&
-        serializer->WriteProperty(XdmConst::DevicePose(), kRotationAngle,
-                                  std::to_string(orientation_[3]));
+        serializer->WriteDoubleProperty(XdmConst::DevicePose(), kRotationAxisX,
+                                        orientation_[0]) &&
+        serializer->WriteDoubleProperty(XdmConst::DevicePose(), kRotationAxisY,
+                                        orientation_[1]) &&
+        serializer->WriteDoubleProperty(XdmConst::DevicePose(), kRotationAxisZ,
+                                        orientation_[2]) &&
+        serializer->WriteDoubleProperty(XdmConst::DevicePose(), kRotationAngle,
+                                        orientation_[3]);
   }
 
   if (timestamp_ >= 0) {
     serializer->WriteProperty(XdmConst::DevicePose(), kTimestamp,
-                              std::to_string(timestamp_));
+                              SimpleItoa(timestamp_));
   }
 
   return success;
@@ -159,13 +166,16 @@ bool DevicePose::Serialize(Serializer* serializer) const {
 
 // Private methods.
 bool DevicePose::ParseDevicePoseFields(const Deserializer& deserializer) {
+  const char* prefix = XdmConst::DevicePose();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
   double lat, lon, alt;
   // If a position field is present, the rest must be as well.
-  if (deserializer.ParseDouble(XdmConst::DevicePose(), kLatitude, &lat)) {
-    if (!deserializer.ParseDouble(XdmConst::DevicePose(), kLongitude, &lon)) {
+  if (properties.ParseDouble(prefix, kLatitude, &lat)) {
+    if (!properties.ParseDouble(prefix, kLongitude, &lon)) {
       return false;
     }
-    if (!deserializer.ParseDouble(XdmConst::DevicePose(), kAltitude, &alt)) {
+    if (!properties.ParseDouble(prefix, kAltitude, &alt)) {
       return false;
     }
     position_ = { lat, lon, alt };
@@ -173,18 +183,15 @@ bool DevicePose::ParseDevicePoseFields(const Deserializer& deserializer) {
 
   // Same for orientation.
   double x, y, z;
-  if (deserializer.ParseDouble(XdmConst::DevicePose(), kRotationAxisX, &x)) {
-    if (!deserializer.ParseDouble(XdmConst::DevicePose(), kRotationAxisY,
-                                  &y)) {
+  if (properties.ParseDouble(prefix, kRotationAxisX, &x)) {
+    if (!properties.ParseDouble(prefix, kRotationAxisY, &y)) {
       return false;
     }
-    if (!deserializer.ParseDouble(XdmConst::DevicePose(), kRotationAxisZ,
-                                  &z)) {
+    if (!properties.ParseDouble(prefix, kRotationAxisZ, &z)) {
       return false;
     }
     double angle;
-    if (!deserializer.ParseDouble(XdmConst::DevicePose(), kRotationAngle,
-                                  &angle)) {
+    if (!properties.ParseDouble(prefix, kRotationAngle, &angle)) {
       return false;
     }
     std::vector<double> axis_angle = { x, y, z, angle };
@@ -195,7 +202,7 @@ bool DevicePose::ParseDevicePoseFields(const Deserializer& deserializer) {
     return false;
   }
 
-  deserializer.ParseLong(XdmConst::DevicePose(), kTimestamp, &timestamp_);
+  properties.ParseLong(prefix, kTimestamp, &timestamp_);
   return true;
 }
 
@@ -16,6 +16,7 @@
 
 #include <libxml/tree.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -177,6 +178,33 @@ void ExpectProfileEquals(const Profile& profile_1, const Profile& profile_2) {
   EXPECT_THAT(indices_1, ElementsAreArray(indices_2));
 }
 
+// Returns the XMP text with the attributes of the rdf:Description element,
+// whose order depends on a hash map in the XML tree, sorted.
+string SortDescriptionAttributes(const string& xmp) {
+  const string description_tag = "<rdf:Description ";
+  const size_t start = xmp.find(description_tag);
+  if (start == string::npos) {
+    return xmp;
+  }
+  const size_t end = xmp.find('>', start);
+  std::vector<string> attributes;
+  size_t attribute_start = start + description_tag.size();
+  while (attribute_start < end) {
+    size_t attribute_end = std::min(xmp.find(' ', attribute_start), end);
+    attributes.push_back(
+        xmp.substr(attribute_start, attribute_end - attribute_start));
+    attribute_start = attribute_end + 1;
+  }
+  std::sort(attributes.begin(), attributes.end());
+  string sorted_xmp = xmp.substr(0, start + description_tag.size());
+  for (const string& attribute : attributes) {
+    sorted_xmp.append(attribute);
+    sorted_xmp.push_back(' ');
+  }
+  sorted_xmp.append(xmp.substr(end));
+  return sorted_xmp;
+}
+
 TEST(Device, FromData) {
   std::vector<std::unique_ptr<Camera>> camera_list;
   int num_cameras = 3;
@@ -321,6 +349,29 @@ TEST(Device, Serialize) {
   EXPECT_EQ(expected_xdm_data, XmlDocToString(xmp_data->ExtendedSection()));
 }
 
+TEST(Device, SerializeToXmpString) {
+  std::vector<std::unique_ptr<Camera>> camera_list;
+  camera_list.emplace_back(CreateCamera());
+  camera_list.emplace_back(CreateCamera());
+  std::unique_ptr<Device> device = Device::FromData(
+      "1.02", CreateDevicePose(), CreateProfiles(),
+      Cameras::FromCameraArray(&camera_list), CreateVendorInfo(),
+      CreateMesh(), CreateNavigationalConnectivity());
+  ASSERT_NE(nullptr, device);
+
+  string xmp;
+  ASSERT_TRUE(device->SerializeToXmpString(&xmp));
+
+  // The text is the same as that of the XML tree, without the XML
+  // declaration, except for the order of the rdf:Description attributes.
+  std::unique_ptr<XmpData> xmp_data = CreateXmpData(true);
+  ASSERT_TRUE(device->SerializeToXmp(xmp_data.get()));
+  string expected_xmp = XmlDocToString(xmp_data->ExtendedSection());
+  expected_xmp.erase(0, expected_xmp.find('\n') + 1);
+  EXPECT_EQ(SortDescriptionAttributes(expected_xmp),
+            SortDescriptionAttributes(xmp));
+}
+
 TEST(Device, ReadMetadata) {
   std::unique_ptr<XmpData> xmp_data = CreateXmpData(true);
   xmlNodePtr description_node =
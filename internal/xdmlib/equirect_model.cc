@@ -15,9 +15,11 @@
 #include "xdmlib/equirect_model.h"
 
 #include "glog/logging.h"
+#include "strings/numbers.h"
 #include "xdmlib/const.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -36,6 +38,11 @@ const char kFullImageHeight[] = "FullImageHeightPixels";
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/equirectmodel/";
 const char kNodeNamespaceHref[] = "http://ns.xdm.org/photos/1.0/imagingmodel/";
 
+// The properties read by ParseFields.
+const char* const kPropertyNames[] = {
+    kCroppedLeft,        kCroppedTop,     kCroppedImageWidth,
+    kCroppedImageHeight, kFullImageWidth, kFullImageHeight};
+
 std::unique_ptr<EquirectModel> ParseFields(const Deserializer& deserializer) {
   int cropped_left;
   int cropped_top;
@@ -43,16 +50,17 @@ std::unique_ptr<EquirectModel> ParseFields(const Deserializer& deserializer) {
   int cropped_image_height;
   int full_image_width;
   int full_image_height;
-  const string& prefix = XdmConst::EquirectModel();
-  // Short-circuiting ensures unnecessary reads will not be performed.
-  if (!deserializer.ParseInt(prefix, kCroppedLeft, &cropped_left) ||
-      !deserializer.ParseInt(prefix, kCroppedTop, &cropped_top) ||
-      !deserializer.ParseInt(prefix, kCroppedImageWidth,
-                             &cropped_image_width) ||
-      !deserializer.ParseInt(prefix, kCroppedImageHeight,
-                             &cropped_image_height) ||
-      !deserializer.ParseInt(prefix, kFullImageWidth, &full_image_width) ||
-      !deserializer.ParseInt(prefix, kFullImageHeight, &full_image_height)) {
+  const char* prefix = XdmConst::EquirectModel();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
+  if (!properties.ParseInt(prefix, kCroppedLeft, &cropped_left) ||
+      !properties.ParseInt(prefix, kCroppedTop, &cropped_top) ||
+      !properties.ParseInt(prefix, kCroppedImageWidth,
+                           &cropped_image_width) ||
+      !properties.ParseInt(prefix, kCroppedImageHeight,
+                           &cropped_image_height) ||
+      !properties.ParseInt(prefix, kFullImageWidth, &full_image_width) ||
+      !properties.ParseInt(prefix, kFullImageHeight, &full_image_height)) {
     return nullptr;
   }
   return EquirectModel::FromData(
@@ -116,17 +124,17 @@ bool EquirectModel::Serialize(Serializer* serializer) const {
 
   // Short-circuiting ensures unnecessary writes will not be performed.
   if (!serializer->WriteProperty(XdmConst::EquirectModel(), kCroppedLeft,
-                                 std::to_string(cropped_origin_.x)) ||
+                                 SimpleItoa(cropped_origin_.x)) ||
       !serializer->WriteProperty(XdmConst::EquirectModel(), kCroppedTop,
-                                 std::to_string(cropped_origin_.y)) ||
+                                 SimpleItoa(cropped_origin_.y)) ||
       !serializer->WriteProperty(XdmConst::EquirectModel(), kCroppedImageWidth,
-                                 std::to_string(cropped_size_.width)) ||
+                                 SimpleItoa(cropped_size_.width)) ||
       !serializer->WriteProperty(XdmConst::EquirectModel(), kCroppedImageHeight,
-                                 std::to_string(cropped_size_.height)) ||
+                                 SimpleItoa(cropped_size_.height)) ||
       !serializer->WriteProperty(XdmConst::EquirectModel(), kFullImageWidth,
-                                 std::to_string(full_size_.width)) ||
+                                 SimpleItoa(full_size_.width)) ||
       !serializer->WriteProperty(XdmConst::EquirectModel(), kFullImageHeight,
-                                 std::to_string(full_size_.height))) {
+                                 SimpleItoa(full_size_.height))) {
     return false;
   }
   return true;
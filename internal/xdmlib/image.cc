@@ -19,6 +19,7 @@
 #include "xmpmeta/base64.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -31,6 +32,9 @@ const char kImageId[] = "ImageId";
 
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/image/";
 
+// The properties read by ParseImageFields.
+const char* const kPropertyNames[] = {kMime, kData, kImageId};
+
 }  // namespace
 
 // Private constructor.
@@ -108,12 +112,15 @@ bool Image::Serialize(Serializer* serializer) const {
 
 // Private methods.
 bool Image::ParseImageFields(const Deserializer& deserializer) {
-  if (!deserializer.ParseString(XdmConst::Image(), kMime, &mime_)) {
+  const char* prefix = XdmConst::Image();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
+  if (!properties.ParseString(prefix, kMime, &mime_)) {
     return false;
   }
 
-  return (deserializer.ParseString(XdmConst::Image(), kImageId, &image_id_) ||
-          deserializer.ParseBase64(XdmConst::Image(), kData, &data_));
+  return (properties.ParseString(prefix, kImageId, &image_id_) ||
+          properties.ParseBase64(prefix, kData, &data_));
 }
 
 }  // namespace xdm
@@ -21,6 +21,7 @@
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -37,6 +38,11 @@ const char kSoftware[] = "Software";
 
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/mesh/";
 
+// The properties read by ParseFields.
+const char* const kPropertyNames[] = {kVertexCount, kVertexPosition,
+                                      kFaceCount,   kFaceIndices,
+                                      kMetric,      kSoftware};
+
 }  // namespace
 
 // Private constructor.
@@ -148,28 +154,30 @@ bool Mesh::Serialize(Serializer* serializer) const {
 
 // Private methods.
 bool Mesh::ParseFields(const Deserializer& deserializer) {
+  const char* prefix = XdmConst::Mesh();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
   // Required fields.
-  if (!deserializer.ParseInt(XdmConst::Mesh(), kVertexCount, &vertex_count_)) {
+  if (!properties.ParseInt(prefix, kVertexCount, &vertex_count_)) {
     return false;
   }
-  if (!deserializer.ParseFloatArrayBase64(XdmConst::Mesh(), kVertexPosition,
-                                          vertex_position_)) {
+  if (!properties.ParseFloatArrayBase64(prefix, kVertexPosition,
+                                        vertex_position_)) {
     return false;
   }
-  if (!deserializer.ParseInt(XdmConst::Mesh(), kFaceCount, &face_count_)) {
+  if (!properties.ParseInt(prefix, kFaceCount, &face_count_)) {
     return false;
   }
-  if (!deserializer.ParseIntArrayBase64(XdmConst::Mesh(), kFaceIndices,
-                                        face_indicies_)) {
+  if (!properties.ParseIntArrayBase64(prefix, kFaceIndices, face_indicies_)) {
     return false;
   }
 
   // Optional fields.
-  if (!deserializer.ParseBoolean(XdmConst::Mesh(), kMetric, &metric_)) {
+  if (!properties.ParseBoolean(prefix, kMetric, &metric_)) {
     // Set it to the default value.
     metric_ = false;
   }
-  deserializer.ParseString(XdmConst::Mesh(), kSoftware, &software_);
+  properties.ParseString(prefix, kSoftware, &software_);
   return true;
 }
 
@@ -21,6 +21,7 @@
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -36,6 +37,10 @@ const char kSoftware[] = "Software";
 
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/pointcloud/";
 
+// The properties read by ParseFields.
+const char* const kPropertyNames[] = {kCount, kColor, kPosition, kMetric,
+                                      kSoftware};
+
 }  // namespace
 
 // Private constructor.
@@ -134,22 +139,24 @@ bool PointCloud::Serialize(Serializer* serializer) const {
 
 // Private methods.
 bool PointCloud::ParseFields(const Deserializer& deserializer) {
+  const char* prefix = XdmConst::PointCloud();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
   // Required fields.
-  if (!deserializer.ParseInt(XdmConst::PointCloud(), kCount, &count_)) {
+  if (!properties.ParseInt(prefix, kCount, &count_)) {
     return false;
   }
-  if (!deserializer.ParseBase64(XdmConst::PointCloud(), kPosition,
-                                &position_)) {
+  if (!properties.ParseBase64(prefix, kPosition, &position_)) {
     return false;
   }
 
   // Optional fields.
-  if (!deserializer.ParseBoolean(XdmConst::PointCloud(), kMetric, &metric_)) {
+  if (!properties.ParseBoolean(prefix, kMetric, &metric_)) {
     // Set it to the default value.
     metric_ = false;
   }
-  deserializer.ParseBase64(XdmConst::PointCloud(), kColor, &color_);
-  deserializer.ParseString(XdmConst::PointCloud(), kSoftware, &software_);
+  properties.ParseBase64(prefix, kColor, &color_);
+  properties.ParseString(prefix, kSoftware, &software_);
   return true;
 }
 
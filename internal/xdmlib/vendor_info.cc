@@ -21,6 +21,7 @@
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::xml::Deserializer;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::Serializer;
 
 namespace xmpmeta {
@@ -34,6 +35,9 @@ const char kNotes[] = "Notes";
 
 const char kNamespaceHref[] = "http://ns.xdm.org/photos/1.0/vendorinfo/";
 
+// The properties read by ParseFields.
+const char* const kPropertyNames[] = {kModel, kManufacturer, kNotes};
+
 }  // namespace
 
 // Private constructor.
@@ -107,15 +111,17 @@ bool VendorInfo::Serialize(Serializer* serializer) const {
 
 // Private methods.
 bool VendorInfo::ParseFields(const Deserializer& deserializer) {
+  const char* prefix = XdmConst::VendorInfo();
+  PropertySet properties(kPropertyNames);
+  deserializer.ParseProperties(prefix, &properties);
   // Required field.
-  if (!deserializer.ParseString(XdmConst::VendorInfo(), kManufacturer,
-                                &manufacturer_)) {
+  if (!properties.ParseString(prefix, kManufacturer, &manufacturer_)) {
     return false;
   }
 
   // Optional fields.
-  deserializer.ParseString(XdmConst::VendorInfo(), kModel, &model_);
-  deserializer.ParseString(XdmConst::VendorInfo(), kNotes, &notes_);
+  properties.ParseString(prefix, kModel, &model_);
+  properties.ParseString(prefix, kNotes, &notes_);
   return true;
 }
 
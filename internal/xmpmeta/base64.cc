@@ -14,9 +14,33 @@
 
 #include "xmpmeta/base64.h"
 
+#include "strings/ascii_ctype.h"
 #include "strings/escaping.h"
 
 namespace xmpmeta {
+namespace {
+
+// Returns the 6-bit value of a regular or web-safe base64 character, or -1.
+int Base64CharValue(unsigned char c) {
+  if (c >= 'A' && c <= 'Z') {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9') {
+    return c - '0' + 52;
+  }
+  if (c == '+' || c == '-') {
+    return 62;
+  }
+  if (c == '/' || c == '_') {
+    return 63;
+  }
+  return -1;
+}
+
+}  // namespace
 
 // Decodes the base64-encoded input range.
 bool DecodeBase64(const string& data, string* output) {
@@ -90,4 +114,73 @@ bool DecodeFloatArrayBase64(const string& data, std::vector<float>& output) {
   return !output.empty();
 }
 
+const size_t Base64Decoder::kBlockSize;
+
+Base64Decoder::Base64Decoder(const ByteSink& sink)
+    : sink_(sink), bits_(0), num_chars_(0), num_padding_(0), block_length_(0) {}
+
+bool Base64Decoder::Decode(const char* data, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    const unsigned char c = data[i];
+    const int value = Base64CharValue(c);
+    if (value < 0) {
+      if (c == '=' || c == '.') {
+        ++num_padding_;
+      } else if (!ascii_isspace(c)) {
+        return false;
+      }
+      continue;
+    }
+    if (num_padding_ > 0) {
+      return false;
+    }
+    bits_ = (bits_ << 6) | value;
+    if (++num_chars_ < 4) {
+      continue;
+    }
+    // Kept a multiple of 3, so a whole group always fits.
+    if (block_length_ == kBlockSize && !Flush()) {
+      return false;
+    }
+    block_[block_length_++] = static_cast<char>(bits_ >> 16);
+    block_[block_length_++] = static_cast<char>(bits_ >> 8);
+    block_[block_length_++] = static_cast<char>(bits_);
+    bits_ = 0;
+    num_chars_ = 0;
+  }
+  return true;
+}
+
+bool Base64Decoder::Finish() {
+  // A partial group of 2 or 3 characters holds 1 or 2 more bytes, and may be
+  // followed by the padding that completes the group.
+  if (num_chars_ == 1 ||
+      (num_padding_ > 0 &&
+       (num_chars_ == 0 || num_padding_ != 4 - num_chars_))) {
+    return false;
+  }
+  if (block_length_ + 2 > kBlockSize && !Flush()) {
+    return false;
+  }
+  if (num_chars_ == 2) {
+    block_[block_length_++] = static_cast<char>(bits_ >> 4);
+  } else if (num_chars_ == 3) {
+    block_[block_length_++] = static_cast<char>(bits_ >> 10);
+    block_[block_length_++] = static_cast<char>(bits_ >> 2);
+  }
+  bits_ = 0;
+  num_chars_ = 0;
+  num_padding_ = 0;
+  return Flush();
+}
+
+bool Base64Decoder::Flush() {
+  if (block_length_ == 0) {
+    return true;
+  }
+  const size_t length = block_length_;
+  block_length_ = 0;
+  return sink_(block_, length);
+}
+
 }  // namespace xmpmeta
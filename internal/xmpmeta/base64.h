@@ -19,7 +19,9 @@
 #include <string>
 #include <vector>
 
+#include "base/integral_types.h"
 #include "base/port.h"
+#include "xmpmeta/blob_ref.h"
 
 namespace xmpmeta {
 // Decodes the base64-encoded input range. Supports decoding of both web-safe
@@ -42,6 +44,45 @@ bool EncodeFloatArrayBase64(const std::vector<float>& data, string* output);
 // Base64-decodes the given float array.
 bool DecodeFloatArrayBase64(const string& data, std::vector<float>& output);
 
+// Decodes base64 text that arrives in pieces, passing the decoded bytes to a
+// sink in blocks of at most kBlockSize bytes, so that the text and its
+// decoding never need to be held in memory in full. Accepts the same input as
+// DecodeBase64: regular or web-safe base64, with whitespace anywhere and with
+// or without trailing padding.
+class Base64Decoder {
+ public:
+  static const size_t kBlockSize = 3 * 4096;
+
+  explicit Base64Decoder(const ByteSink& sink);
+
+  // Decodes the next piece of the text. Returns false if the text is not
+  // valid base64 or the sink returns false.
+  bool Decode(const char* data, size_t length);
+
+  // Decodes the end of the text and passes the rest of the decoded bytes to
+  // the sink. Returns false if the text is not valid base64 or the sink
+  // returns false.
+  bool Finish();
+
+  // Disallow copying.
+  Base64Decoder(const Base64Decoder&) = delete;
+  void operator=(const Base64Decoder&) = delete;
+
+ private:
+  // Passes the decoded bytes in the block to the sink.
+  bool Flush();
+
+  const ByteSink sink_;
+  // Bits of the characters of the current 4-character group.
+  uint32 bits_;
+  int num_chars_;
+  // Number of padding characters seen, after which only whitespace and more
+  // padding may follow.
+  int num_padding_;
+  char block_[kBlockSize];
+  size_t block_length_;
+};
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_BASE64_H_
@@ -14,8 +14,10 @@
 
 #include "xmpmeta/base64.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -91,5 +93,73 @@ TEST(Base64, EncodeAndDecodeFloatArrayBase64) {
   EXPECT_EQ(data, decoded);
 }
 
+// Decodes the text with a Base64Decoder, feeding it piece_size characters at a
+// time.
+bool DecodeInPieces(const string& text, size_t piece_size, string* output) {
+  output->clear();
+  Base64Decoder decoder([output](const char* data, size_t length) {
+    EXPECT_LE(length, Base64Decoder::kBlockSize);
+    output->append(data, length);
+    return true;
+  });
+  for (size_t i = 0; i < text.size(); i += piece_size) {
+    if (!decoder.Decode(text.data() + i,
+                        std::min(piece_size, text.size() - i))) {
+      return false;
+    }
+  }
+  return decoder.Finish();
+}
+
+TEST(Base64, StreamDecodeBase64) {
+  string data;
+  for (size_t i = 0; i < 3 * Base64Decoder::kBlockSize + 2; i++) {
+    data.push_back(static_cast<char>(i * 7));
+  }
+  string encoded;
+  ASSERT_TRUE(EncodeBase64(data, &encoded));
+
+  for (const size_t piece_size : {1, 3, 4, 5, 1000, 100000}) {
+    string decoded;
+    ASSERT_TRUE(DecodeInPieces(encoded, piece_size, &decoded)) << piece_size;
+    EXPECT_EQ(data, decoded) << piece_size;
+  }
+}
+
+TEST(Base64, StreamDecodeBase64MatchesDecodeBase64) {
+  const std::vector<string> valid = {
+      "", "YQ", "YQ==", "YWI", "YWI=", "YWJj", " Y W\nJ j ", "YQ= =",
+      "-_-_", "+/+/", "YQ.."};
+  for (const string& text : valid) {
+    string expected;
+    ASSERT_TRUE(DecodeBase64(text, &expected)) << text;
+    string decoded;
+    ASSERT_TRUE(DecodeInPieces(text, 1, &decoded)) << text;
+    EXPECT_EQ(expected, decoded) << text;
+  }
+
+  const std::vector<string> invalid = {"Y", "YQ=", "YWI==", "YQ==YQ==", "Y$Q",
+                                       "===="};
+  for (const string& text : invalid) {
+    string decoded;
+    EXPECT_FALSE(DecodeInPieces(text, 1, &decoded)) << text;
+  }
+}
+
+TEST(Base64, StreamDecodeBase64SinkStops) {
+  string encoded;
+  ASSERT_TRUE(EncodeBase64(string(2 * Base64Decoder::kBlockSize, 'x'),
+                           &encoded));
+  int num_calls = 0;
+  Base64Decoder decoder([&num_calls](const char* /* data */,
+                                     size_t /* length */) {
+    ++num_calls;
+    return false;
+  });
+  EXPECT_FALSE(decoder.Decode(encoded.data(), encoded.size()) &&
+               decoder.Finish());
+  EXPECT_EQ(1, num_calls);
+}
+
 }  // namespace
 }  // namespace xmpmeta
@@ -0,0 +1,86 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/blob_ref.h"
+
+#include <cstdio>
+
+#include "glog/logging.h"
+#include "xmpmeta/base64.h"
+
+namespace xmpmeta {
+
+BlobRef::BlobRef() : encoded_length_(0) {}
+
+void BlobRef::AddSegment(const char* data, size_t length) {
+  Segment segment;
+  segment.data = data;
+  segment.length = length;
+  segments_.push_back(segment);
+  encoded_length_ += length;
+}
+
+void BlobRef::Clear() {
+  segments_.clear();
+  encoded_length_ = 0;
+}
+
+const std::vector<BlobRef::Segment>& BlobRef::Segments() const {
+  return segments_;
+}
+
+size_t BlobRef::EncodedLength() const { return encoded_length_; }
+
+bool BlobRef::Decode(const ByteSink& sink) const {
+  Base64Decoder decoder(sink);
+  for (const Segment& segment : segments_) {
+    if (!decoder.Decode(segment.data, segment.length)) {
+      return false;
+    }
+  }
+  return decoder.Finish();
+}
+
+bool BlobRef::DecodeToString(string* output) const {
+  output->clear();
+  // Every 4 characters decode to at most 3 bytes.
+  output->reserve(encoded_length_ / 4 * 3 + 3);
+  if (!Decode([output](const char* data, size_t length) {
+        output->append(data, length);
+        return true;
+      })) {
+    output->clear();
+    return false;
+  }
+  return true;
+}
+
+bool BlobRef::DecodeToFile(const string& filename) const {
+  FILE* file = fopen(filename.c_str(), "wb");
+  if (file == nullptr) {
+    LOG(WARNING) << "Could not open file for writing: " << filename;
+    return false;
+  }
+  bool success = Decode([file](const char* data, size_t length) {
+    return fwrite(data, 1, length, file) == length;
+  });
+  success = (fclose(file) == 0) && success;
+  if (!success) {
+    LOG(WARNING) << "Could not decode data to file: " << filename;
+    remove(filename.c_str());
+  }
+  return success;
+}
+
+}  // namespace xmpmeta
@@ -0,0 +1,190 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/byte_source.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#include "glog/logging.h"
+#include "xmpmeta/file.h"
+
+namespace xmpmeta {
+namespace {
+
+// Copies from the given range of a buffer of the given size.
+size_t ReadFromBuffer(const uint8* buffer, size_t size, size_t offset,
+                      size_t length, char* output) {
+  if (offset >= size) {
+    return 0;
+  }
+  length = std::min(length, size - offset);
+  memcpy(output, buffer + offset, length);
+  return length;
+}
+
+class MemoryByteSource : public ByteSource {
+ public:
+  MemoryByteSource(const uint8* buffer, size_t size)
+      : buffer_(buffer), size_(size) {}
+
+  size_t Size() const override { return size_; }
+
+  size_t ReadAt(size_t offset, size_t length, char* buffer) override {
+    return ReadFromBuffer(buffer_, size_, offset, length, buffer);
+  }
+
+ private:
+  const uint8* buffer_;
+  const size_t size_;
+};
+
+class MappedFileByteSource : public ByteSource {
+ public:
+  explicit MappedFileByteSource(std::unique_ptr<MemoryMappedFile> file)
+      : file_(std::move(file)) {}
+
+  size_t Size() const override { return file_->size(); }
+
+  size_t ReadAt(size_t offset, size_t length, char* buffer) override {
+    return ReadFromBuffer(file_->data(), file_->size(), offset, length, buffer);
+  }
+
+ private:
+  const std::unique_ptr<MemoryMappedFile> file_;
+};
+
+class FileByteSource : public ByteSource {
+ public:
+#ifdef _WIN32
+  FileByteSource(FILE* file, size_t size) : file_(file), size_(size) {}
+  ~FileByteSource() override { fclose(file_); }
+#else
+  FileByteSource(int fd, size_t size) : fd_(fd), size_(size) {}
+  ~FileByteSource() override { close(fd_); }
+#endif  // _WIN32
+
+  size_t Size() const override { return size_; }
+
+  size_t ReadAt(size_t offset, size_t length, char* buffer) override {
+#ifdef _WIN32
+    if (fseek(file_, offset, SEEK_SET) != 0) {
+      return 0;
+    }
+    return fread(buffer, 1, length, file_);
+#else
+    size_t total = 0;
+    while (total < length) {
+      const ssize_t num_read =
+          pread(fd_, buffer + total, length - total, offset + total);
+      if (num_read < 0 && errno == EINTR) {
+        continue;
+      }
+      if (num_read <= 0) {
+        break;
+      }
+      total += num_read;
+    }
+    return total;
+#endif  // _WIN32
+  }
+
+ private:
+#ifdef _WIN32
+  FILE* file_;
+#else
+  const int fd_;
+#endif  // _WIN32
+  const size_t size_;
+};
+
+class ReaderByteSource : public ByteSource {
+ public:
+  ReaderByteSource(size_t size, const ByteSourceReader& reader)
+      : size_(size), reader_(reader) {}
+
+  size_t Size() const override { return size_; }
+
+  size_t ReadAt(size_t offset, size_t length, char* buffer) override {
+    if (offset >= size_) {
+      return 0;
+    }
+    return reader_(offset, std::min(length, size_ - offset), buffer);
+  }
+
+ private:
+  const size_t size_;
+  const ByteSourceReader reader_;
+};
+
+}  // namespace
+
+std::unique_ptr<ByteSource> ByteSource::FromMemory(const uint8* buffer,
+                                                   size_t size) {
+  return std::unique_ptr<ByteSource>(new MemoryByteSource(buffer, size));
+}
+
+std::unique_ptr<ByteSource> ByteSource::FromFile(const string& filename) {
+#ifdef _WIN32
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (file == nullptr) {
+    LOG(WARNING) << "Couldn't read file: " << filename;
+    return nullptr;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  if (size < 0) {
+    LOG(WARNING) << "Couldn't get the size of file: " << filename;
+    fclose(file);
+    return nullptr;
+  }
+  return std::unique_ptr<ByteSource>(new FileByteSource(file, size));
+#else
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(WARNING) << "Couldn't read file: " << filename;
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    LOG(WARNING) << "Couldn't stat file: " << filename;
+    close(fd);
+    return nullptr;
+  }
+  return std::unique_ptr<ByteSource>(new FileByteSource(fd, file_stat.st_size));
+#endif  // _WIN32
+}
+
+std::unique_ptr<ByteSource> ByteSource::FromMappedFile(const string& filename) {
+  std::unique_ptr<MemoryMappedFile> file = MemoryMappedFile::FromFile(filename);
+  if (file == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<ByteSource>(new MappedFileByteSource(std::move(file)));
+}
+
+std::unique_ptr<ByteSource> ByteSource::FromReader(
+    size_t size, const ByteSourceReader& reader) {
+  return std::unique_ptr<ByteSource>(new ReaderByteSource(size, reader));
+}
+
+}  // namespace xmpmeta
@@ -0,0 +1,93 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/byte_source.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/file.h"
+#include "xmpmeta/test_util.h"
+
+namespace xmpmeta {
+namespace {
+
+const char kContents[] = "byte\0source contents";
+const size_t kContentsSize = sizeof(kContents) - 1;
+
+// Checks reads from the source, which holds kContents.
+void CheckByteSource(ByteSource* source) {
+  ASSERT_NE(nullptr, source);
+  ASSERT_EQ(kContentsSize, source->Size());
+
+  char buffer[kContentsSize];
+  ASSERT_EQ(kContentsSize, source->ReadAt(0, kContentsSize, buffer));
+  EXPECT_EQ(string(kContents, kContentsSize), string(buffer, kContentsSize));
+
+  ASSERT_EQ(6u, source->ReadAt(5, 6, buffer));
+  EXPECT_EQ("source", string(buffer, 6));
+
+  // Reads are cut short at the end of the source.
+  ASSERT_EQ(8u, source->ReadAt(kContentsSize - 8, 100, buffer));
+  EXPECT_EQ("contents", string(buffer, 8));
+  EXPECT_EQ(0u, source->ReadAt(kContentsSize, 1, buffer));
+}
+
+TEST(ByteSource, FromMemory) {
+  std::unique_ptr<ByteSource> source = ByteSource::FromMemory(
+      reinterpret_cast<const uint8*>(kContents), kContentsSize);
+  CheckByteSource(source.get());
+}
+
+TEST(ByteSource, FromFile) {
+  const string filename = TempFileAbsolutePath("byte_source.txt");
+  WriteStringToFileOrDie(string(kContents, kContentsSize), filename);
+  std::unique_ptr<ByteSource> source = ByteSource::FromFile(filename);
+  CheckByteSource(source.get());
+}
+
+TEST(ByteSource, FromMappedFile) {
+  const string filename = TempFileAbsolutePath("byte_source.txt");
+  WriteStringToFileOrDie(string(kContents, kContentsSize), filename);
+  std::unique_ptr<ByteSource> source = ByteSource::FromMappedFile(filename);
+  CheckByteSource(source.get());
+}
+
+TEST(ByteSource, FromReader) {
+  // Serve the reads from a file, as a stand-in for remote range reads.
+  const string filename = TempFileAbsolutePath("byte_source.txt");
+  WriteStringToFileOrDie(string(kContents, kContentsSize), filename);
+  std::shared_ptr<ByteSource> file = ByteSource::FromFile(filename);
+  ASSERT_NE(nullptr, file);
+  int num_reads = 0;
+  std::unique_ptr<ByteSource> source = ByteSource::FromReader(
+      file->Size(), [file, &num_reads](size_t offset, size_t length,
+                                       char* buffer) {
+        ++num_reads;
+        return file->ReadAt(offset, length, buffer);
+      });
+  CheckByteSource(source.get());
+  // The read past the end does not reach the reader.
+  EXPECT_EQ(3, num_reads);
+}
+
+TEST(ByteSource, MissingFile) {
+  const string filename = TempFileAbsolutePath("does_not_exist.txt");
+  EXPECT_EQ(nullptr, ByteSource::FromFile(filename));
+  EXPECT_EQ(nullptr, ByteSource::FromMappedFile(filename));
+}
+
+}  // namespace
+}  // namespace xmpmeta
@@ -15,7 +15,9 @@
 #include "strings/numbers.h"
 
 #include <cassert>
-#include <float.h>          // for FLT_DIG
+#include <float.h>          // for DBL_DIG and FLT_DIG
+#include <locale.h>         // for localeconv
+#include <math.h>           // for fabs and signbit
 #include <memory>
 
 #include "strings/ascii_ctype.h"
@@ -47,16 +49,17 @@ static const int8 kAsciiToInt[256] = {
   36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
   36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36 };
 
-// Parse the sign and optional hex or oct prefix in text.
-inline bool safe_parse_sign_and_base(string* text  /*inout*/,
+// Parse the sign and optional hex or oct prefix in [*start_ptr, *end_ptr).
+inline bool safe_parse_sign_and_base(const char** start_ptr  /*inout*/,
+                                     const char** end_ptr  /*inout*/,
                                      int* base_ptr  /*inout*/,
                                      bool* negative_ptr  /*output*/) {
-  if (text->data() == NULL) {
+  if (*start_ptr == NULL) {
     return false;
   }
 
-  const char* start = text->data();
-  const char* end = start + text->size();
+  const char* start = *start_ptr;
+  const char* end = *end_ptr;
   int base = *base_ptr;
 
   // Consume whitespace.
@@ -112,7 +115,8 @@ inline bool safe_parse_sign_and_base(string* text  /*inout*/,
   } else {
     return false;
   }
-  text->assign(start, end - start);
+  *start_ptr = start;
+  *end_ptr = end;
   *base_ptr = base;
   return true;
 }
@@ -176,14 +180,12 @@ const IntType LookupTables<IntType>::kVminOverBase[] =
 
 template <typename IntType>
 inline bool safe_parse_positive_int(
-    const string& text, int base, IntType* value_p) {
+    const char* start, const char* end, int base, IntType* value_p) {
   IntType value = 0;
   const IntType vmax = std::numeric_limits<IntType>::max();
   assert(vmax > 0);
   assert(vmax >= base);
   const IntType vmax_over_base = LookupTables<IntType>::kVmaxOverBase[base];
-  const char* start = text.data();
-  const char* end = start + text.size();
   // loop over digits
   for (; start < end; ++start) {
     unsigned char c = static_cast<unsigned char>(start[0]);
@@ -209,7 +211,7 @@ inline bool safe_parse_positive_int(
 
 template <typename IntType>
 inline bool safe_parse_negative_int(
-    const string& text, int base, IntType* value_p) {
+    const char* start, const char* end, int base, IntType* value_p) {
   IntType value = 0;
   const IntType vmin = std::numeric_limits<IntType>::min();
   assert(vmin < 0);
@@ -223,8 +225,6 @@ inline bool safe_parse_negative_int(
   if (vmin % base > 0) {
     vmin_over_base += 1;
   }
-  const char* start = text.data();
-  const char* end = start + text.size();
   // loop over digits
   for (; start < end; ++start) {
     unsigned char c = static_cast<unsigned char>(start[0]);
@@ -251,29 +251,29 @@ inline bool safe_parse_negative_int(
 // Input format based on POSIX.1-2008 strtol
 // http://pubs.opengroup.org/onlinepubs/9699919799/functions/strtol.html
 template <typename IntType>
-inline bool safe_int_internal(const string& text, IntType* value_p, int base) {
+inline bool safe_int_internal(const char* start, const char* end,
+                              IntType* value_p, int base) {
   *value_p = 0;
   bool negative;
-  string text_copy(text);
-  if (!safe_parse_sign_and_base(&text_copy, &base, &negative)) {
+  if (!safe_parse_sign_and_base(&start, &end, &base, &negative)) {
     return false;
   }
   if (!negative) {
-    return safe_parse_positive_int(text_copy, base, value_p);
+    return safe_parse_positive_int(start, end, base, value_p);
   } else {
-    return safe_parse_negative_int(text_copy, base, value_p);
+    return safe_parse_negative_int(start, end, base, value_p);
   }
 }
 
 template <typename IntType>
-inline bool safe_uint_internal(const string& text, IntType* value_p, int base) {
+inline bool safe_uint_internal(const char* start, const char* end,
+                               IntType* value_p, int base) {
   *value_p = 0;
   bool negative;
-  string text_copy(text);
-  if (!safe_parse_sign_and_base(&text_copy, &base, &negative) || negative) {
+  if (!safe_parse_sign_and_base(&start, &end, &base, &negative) || negative) {
     return false;
   }
-  return safe_parse_positive_int(text_copy, base, value_p);
+  return safe_parse_positive_int(start, end, base, value_p);
 }
 
 // Writes a two-character representation of 'i' to 'buf'. 'i' must be in the
@@ -309,6 +309,216 @@ inline void PutTwoDigits(size_t i, char* buf) {
   memcpy(buf, two_ASCII_digits[i], 2);
 }
 
+// Powers of ten that are exactly representable as doubles.
+const double kExactPowersOfTen[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+const int kMaxExactPowerOfTen = 22;
+
+// Parses a decimal number in [start, end), with optional surrounding
+// whitespace, without calling strtod(). This is only done when the result is
+// exact: if the significant digits fit in 53 bits and the power of ten is at
+// most 22 in magnitude, both are exact doubles, and a single multiplication or
+// division rounds correctly. That covers the values commonly found in
+// metadata, such as "-85.320000".
+// Returns false, leaving *value unchanged, for all other inputs, including
+// malformed ones, which must then go through strtod().
+inline bool safe_parse_exact_decimal(const char* start, const char* end,
+                                     double* value) {
+  while (start < end && ascii_isspace(start[0])) {
+    ++start;
+  }
+  while (start < end && ascii_isspace(end[-1])) {
+    --end;
+  }
+  const bool negative = start < end && start[0] == '-';
+  if (start < end && (negative || start[0] == '+')) {
+    ++start;
+  }
+
+  // At most 19 significant digits are accumulated, so that they fit in a
+  // uint64. Leading zeros are not significant.
+  uint64 mantissa = 0;
+  int num_digits = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  for (; start < end && ascii_isdigit(start[0]); ++start) {
+    has_digits = true;
+    if (mantissa == 0 && start[0] == '0') {
+      continue;
+    }
+    if (num_digits == 19) {
+      return false;
+    }
+    mantissa = mantissa * 10 + (start[0] - '0');
+    ++num_digits;
+  }
+  if (start < end && start[0] == '.') {
+    for (++start; start < end && ascii_isdigit(start[0]); ++start) {
+      has_digits = true;
+      --exponent;
+      if (mantissa == 0 && start[0] == '0') {
+        continue;
+      }
+      if (num_digits == 19) {
+        return false;
+      }
+      mantissa = mantissa * 10 + (start[0] - '0');
+      ++num_digits;
+    }
+  }
+  if (!has_digits) {
+    return false;
+  }
+
+  if (start < end && (start[0] == 'e' || start[0] == 'E')) {
+    ++start;
+    const bool negative_exponent = start < end && start[0] == '-';
+    if (start < end && (negative_exponent || start[0] == '+')) {
+      ++start;
+    }
+    if (start == end || !ascii_isdigit(start[0])) {
+      return false;
+    }
+    int explicit_exponent = 0;
+    for (; start < end && ascii_isdigit(start[0]); ++start) {
+      // Large exponents are out of range anyway; only avoid overflowing.
+      if (explicit_exponent < 10000) {
+        explicit_exponent = explicit_exponent * 10 + (start[0] - '0');
+      }
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  if (start != end) {
+    return false;
+  }
+
+  double result = 0.0;
+  if (mantissa != 0) {
+    if (mantissa > (static_cast<uint64>(1) << 53) ||
+        exponent < -kMaxExactPowerOfTen || exponent > kMaxExactPowerOfTen) {
+      return false;
+    }
+    result = static_cast<double>(mantissa);
+    if (exponent < 0) {
+      result /= kExactPowersOfTen[-exponent];
+    } else {
+      result *= kExactPowersOfTen[exponent];
+    }
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+// A null-terminated copy of a number, for strtod() and strtof(). Any '.' is
+// replaced by the decimal point of the current locale, so that the number is
+// parsed as in the "C" locale whatever the locale is.
+class StrtodBuffer {
+ public:
+  StrtodBuffer(const char* start, const char* end) : str_(buf_), valid_(true) {
+    const size_t size = end - start;
+    if (size > sizeof(buf_) - 1) {
+      bigbuf_.reset(new char[size + 1]);
+      str_ = bigbuf_.get();
+    }
+    memcpy(str_, start, size);
+    str_[size] = '\0';
+
+    const char decimal_point = localeconv()->decimal_point[0];
+    if (decimal_point == '.') {
+      return;
+    }
+    for (char* c = str_; c < str_ + size; ++c) {
+      if (*c == decimal_point) {
+        // Would be accepted by strtod(), but not in the "C" locale.
+        valid_ = false;
+      } else if (*c == '.') {
+        *c = decimal_point;
+      }
+    }
+  }
+
+  char* str() { return str_; }
+
+  // Returns false if the number contains the decimal point of the current
+  // locale, when it is not '.'.
+  bool valid() const { return valid_; }
+
+ private:
+  char buf_[32];
+  std::unique_ptr<char[]> bigbuf_;
+  char* str_;
+  bool valid_;
+};
+
+// Writes value in fixed notation, with the fewest fractional digits that
+// parse back to it exactly with safe_parse_exact_decimal(). This is the
+// shortest round-trip form of the value, found without snprintf().
+// Returns false if the value has more than kMaxExactPowerOfTen fractional
+// digits or more than 53 bits of significant digits, or would be better
+// written in exponent notation; snprintf() must then be used.
+inline bool safe_format_exact_decimal(double value, char* buffer) {
+  const double magnitude = fabs(value);
+  // Below this, "%g" switches to exponent notation.
+  if (magnitude != 0.0 && magnitude < 1e-4) {
+    return false;
+  }
+  const double max_exact_mantissa = static_cast<double>(
+      static_cast<uint64>(1) << 53);
+  for (int exponent = 0; exponent <= kMaxExactPowerOfTen; ++exponent) {
+    const double scaled = magnitude * kExactPowersOfTen[exponent];
+    if (scaled > max_exact_mantissa) {
+      return false;
+    }
+    const uint64 mantissa = static_cast<uint64>(scaled + 0.5);
+    if (static_cast<double>(mantissa) / kExactPowersOfTen[exponent] !=
+        magnitude) {
+      continue;
+    }
+
+    char digits[kFastToBufferSize];
+    const int num_digits = FastUInt64ToBufferLeft(mantissa, digits) - digits;
+    if (signbit(value)) {
+      *buffer++ = '-';
+    }
+    if (num_digits <= exponent) {
+      *buffer++ = '0';
+      *buffer++ = '.';
+      memset(buffer, '0', exponent - num_digits);
+      buffer += exponent - num_digits;
+      memcpy(buffer, digits, num_digits);
+      buffer += num_digits;
+    } else {
+      memcpy(buffer, digits, num_digits - exponent);
+      buffer += num_digits - exponent;
+      if (exponent > 0) {
+        *buffer++ = '.';
+        memcpy(buffer, digits + num_digits - exponent, exponent);
+        buffer += exponent;
+      }
+    }
+    *buffer = '\0';
+    return true;
+  }
+  return false;
+}
+
+// Replaces the decimal point of the current locale with '.' in a number
+// written by snprintf().
+void DelocalizeRadix(char* buffer) {
+  const char* decimal_point = localeconv()->decimal_point;
+  if (strcmp(decimal_point, ".") == 0) {
+    return;
+  }
+  char* radix = strstr(buffer, decimal_point);
+  if (radix == NULL) {
+    return;
+  }
+  const size_t size = strlen(decimal_point);
+  *radix = '.';
+  memmove(radix + 1, radix + size, strlen(radix + size) + 1);
+}
+
 }  // anonymous namespace
 
 // ----------------------------------------------------------------------
@@ -466,33 +676,39 @@ char* FastInt64ToBufferLeft(int64 i, char* buffer) {
 }
 
 bool safe_strto32_base(const string& text, int32* value, int base) {
-  return safe_int_internal<int32>(text, value, base);
+  return safe_int_internal<int32>(text.data(), text.data() + text.size(),
+                                  value, base);
 }
 
 bool safe_strto64_base(const string& text, int64* value, int base) {
-  return safe_int_internal<int64>(text, value, base);
+  return safe_int_internal<int64>(text.data(), text.data() + text.size(),
+                                  value, base);
 }
 
 bool safe_strtou32_base(const string& text, uint32* value, int base) {
-  return safe_uint_internal<uint32>(text, value, base);
+  return safe_uint_internal<uint32>(text.data(), text.data() + text.size(),
+                                    value, base);
 }
 
 bool safe_strtou64_base(const string& text, uint64* value, int base) {
-  return safe_uint_internal<uint64>(text, value, base);
+  return safe_uint_internal<uint64>(text.data(), text.data() + text.size(),
+                                    value, base);
+}
+
+bool safe_strto32(const char* text, size_t length, int32* value) {
+  return safe_int_internal<int32>(text, text + length, value, 10);
+}
+
+bool safe_strto64(const char* text, size_t length, int64* value) {
+  return safe_int_internal<int64>(text, text + length, value, 10);
 }
 
 bool safe_strtof(const string& piece, float* value) {
   *value = 0.0;
   if (piece.empty()) return false;
-  char buf[32];
-  std::unique_ptr<char[]> bigbuf;
-  char* str = buf;
-  if (piece.size() > sizeof(buf) - 1) {
-    bigbuf.reset(new char[piece.size() + 1]);
-    str = bigbuf.get();
-  }
-  memcpy(str, piece.data(), piece.size());
-  str[piece.size()] = '\0';
+  StrtodBuffer buffer(piece.data(), piece.data() + piece.size());
+  if (!buffer.valid()) return false;
+  char* str = buffer.str();
 
   char* endptr;
 #ifdef COMPILER_MSVC  // has no strtof()
@@ -510,18 +726,13 @@ bool safe_strtof(const string& piece, float* value) {
   return *str != '\0' && *endptr == '\0';
 }
 
-bool safe_strtod(const string& piece, double* value) {
+bool safe_strtod(const char* text, size_t length, double* value) {
   *value = 0.0;
-  if (piece.empty()) return false;
-  char buf[32];
-  std::unique_ptr<char[]> bigbuf;
-  char* str = buf;
-  if (piece.size() > sizeof(buf) - 1) {
-    bigbuf.reset(new char[piece.size() + 1]);
-    str = bigbuf.get();
-  }
-  memcpy(str, piece.data(), piece.size());
-  str[piece.size()] = '\0';
+  if (text == NULL || length == 0) return false;
+  if (safe_parse_exact_decimal(text, text + length, value)) return true;
+  StrtodBuffer buffer(text, text + length);
+  if (!buffer.valid()) return false;
+  char* str = buffer.str();
 
   char* endptr;
   *value = strtod(str, &endptr);
@@ -534,11 +745,67 @@ bool safe_strtod(const string& piece, double* value) {
   return *str != '\0' && *endptr == '\0';
 }
 
+size_t safe_strto32_array(const char* const* texts, size_t count,
+                          int32* values) {
+  for (size_t i = 0; i < count; ++i) {
+    if (!safe_strto32(texts[i], strlen(texts[i]), &values[i])) {
+      return i;
+    }
+  }
+  return count;
+}
+
+size_t safe_strtod_array(const char* const* texts, size_t count,
+                         double* values) {
+  for (size_t i = 0; i < count; ++i) {
+    if (!safe_strtod(texts[i], strlen(texts[i]), &values[i])) {
+      return i;
+    }
+  }
+  return count;
+}
+
 string SimpleFtoa(float value) {
   char buffer[kFastToBufferSize];
   return FloatToBuffer(value, buffer);
 }
 
+string SimpleDtoa(double value) {
+  char buffer[kFastToBufferSize];
+  return DoubleToBuffer(value, buffer);
+}
+
+char* DoubleToBuffer(double value, char* buffer) {
+  if (isfinite(value) && safe_format_exact_decimal(value, buffer)) {
+    return buffer;
+  }
+
+  // DBL_DIG is 15 for IEEE-754 doubles, and DBL_DIG + 2 digits always suffice
+  // to round-trip. Since "%g" drops trailing zeros, a value that round-trips
+  // with fewer digits is written with those at precision DBL_DIG, except for
+  // denormals, which have less precision. So the first precision that
+  // round-trips gives the shortest string.
+  assert(DBL_DIG < 20);
+  const int min_precision = fabs(value) < DBL_MIN ? 1 : DBL_DIG;
+  for (int precision = min_precision; precision <= DBL_DIG + 2; ++precision) {
+    int snprintf_result =
+        snprintf(buffer, kFastToBufferSize, "%.*g", precision, value);
+
+    // The snprintf should never overflow because the buffer is significantly
+    // larger than the precision we asked for.
+    assert(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
+    DelocalizeRadix(buffer);
+
+    double parsed_value;
+    if (!isfinite(value) ||
+        (safe_strtod(buffer, snprintf_result, &parsed_value) &&
+         parsed_value == value)) {
+      break;
+    }
+  }
+  return buffer;
+}
+
 char* FloatToBuffer(float value, char* buffer) {
   // FLT_DIG is 6 for IEEE-754 floats, which are used on almost all
   // platforms these days.  Just in case some system exists where FLT_DIG
@@ -552,6 +819,7 @@ char* FloatToBuffer(float value, char* buffer) {
   // The snprintf should never overflow because the buffer is significantly
   // larger than the precision we asked for.
   assert(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
+  DelocalizeRadix(buffer);
 
   float parsed_value;
   if (!safe_strtof(buffer, &parsed_value) || parsed_value != value) {
@@ -560,6 +828,7 @@ char* FloatToBuffer(float value, char* buffer) {
 
     // Should never overflow; see above.
     assert(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
+    DelocalizeRadix(buffer);
   }
   return buffer;
 }
@@ -72,12 +72,33 @@ inline bool safe_strtou64(const string& text, uint64* value) {
   return safe_strtou64_base(text, value, 10);
 }
 
+// Variants of the above that parse the length characters at text, which need
+// not be null-terminated, without copying them.
+bool safe_strto32(const char* text, size_t length, int32* value);
+bool safe_strto64(const char* text, size_t length, int64* value);
+
 // Convert strings to floating point values.
 // Leading and trailing spaces are allowed.
 // Values may be rounded on over- and underflow.
+// The decimal point is always '.', whatever the current locale is.
 bool safe_strtof(const string& str, float* value);
 
-bool safe_strtod(const string& str, double* value);
+// Parses the length characters at text, which need not be null-terminated.
+// Most decimal numbers are parsed without copying them or calling strtod().
+bool safe_strtod(const char* text, size_t length, double* value);
+
+inline bool safe_strtod(const string& str, double* value) {
+  return safe_strtod(str.data(), str.size(), value);
+}
+
+// Parse count null-terminated strings as safe_strto32() and safe_strtod() do,
+// into values, which must have room for count numbers. Stop at the first
+// string that cannot be parsed.
+// Returns the number of strings parsed, which is count on success.
+size_t safe_strto32_array(const char* const* texts, size_t count,
+                          int32* values);
+size_t safe_strtod_array(const char* const* texts, size_t count,
+                         double* values);
 
 // Previously documented minimums -- the buffers provided must be at least this
 // long, though these numbers are subject to change:
@@ -168,6 +189,21 @@ MUST_USE_RESULT bool SimpleAtoi(const string& s, int_type* out) {
 // ----------------------------------------------------------------------
 string SimpleFtoa(float value);
 
+// ----------------------------------------------------------------------
+// SimpleDtoa()
+//    Description: converts a double to the shortest string which, if passed
+//    to strtod() or safe_strtod(), will produce the exact same double. The
+//    same exception as for SimpleFtoa() applies to NaN values.
+//
+//    The decimal point is always '.', whatever the current locale is. Most
+//    values are written without snprintf(), in fixed notation; very large
+//    and very small ones are written in exponent notation.
+//
+//    The output string, including terminating NUL, will have length
+//    less than or equal to kFastToBufferSize.
+// ----------------------------------------------------------------------
+string SimpleDtoa(double value);
+
 // ----------------------------------------------------------------------
 // SimpleItoa()
 //    Description: converts an integer to a string.
@@ -213,8 +249,10 @@ inline string SimpleItoa(unsigned long i) {  // NOLINT long is OK here
   }
 }
 
-// Required buffer size for FloatToBuffer is kFastToBufferSize.
+// Required buffer size for FloatToBuffer and DoubleToBuffer is
+// kFastToBufferSize. They return buffer, and do not allocate memory.
 char* FloatToBuffer(float i, char* buffer);
+char* DoubleToBuffer(double i, char* buffer);
 
 }  // namespace xmpmeta
 
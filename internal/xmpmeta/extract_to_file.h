@@ -0,0 +1,123 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_EXTRACT_TO_FILE_H_
+#define XMPMETA_EXTRACT_TO_FILE_H_
+
+#include <memory>
+#include <string>
+
+#include "base/port.h"
+#include "glog/logging.h"
+#include "xmpmeta/blob_ref.h"
+#include "xmpmeta/file.h"
+#include "xmpmeta/xmp_data.h"
+#include "xmpmeta/xmp_parser.h"
+
+namespace xmpmeta {
+
+// The output of ExtractData() that holds the mime type and the data in
+// strings, as GImage::FromJpegFile() and GAudio::FromJpegFile() do.
+class StringDataOutput {
+ public:
+  StringDataOutput(string* mime, string* data) : mime_(mime), data_(data) {}
+
+  bool AcceptsInput(const string& /* jpeg_filename */) const { return true; }
+
+  bool Decode(const string& mime, const BlobRef& data_ref) const {
+    *mime_ = mime;
+    return data_ref.DecodeToString(data_);
+  }
+
+  bool Write(const string& mime, const string& data) const {
+    *mime_ = mime;
+    *data_ = data;
+    return true;
+  }
+
+ private:
+  string* mime_;
+  string* data_;
+};
+
+// The output of ExtractData() that writes the data to a file, as
+// ExtractGImageToFile() and ExtractGAudioToFile() do. The file must not be the
+// JPEG file, which is still mapped while the output is written.
+class FileDataOutput {
+ public:
+  explicit FileDataOutput(const string& filename) : filename_(filename) {}
+
+  bool AcceptsInput(const string& jpeg_filename) const {
+    if (IsSameFile(jpeg_filename, filename_)) {
+      LOG(WARNING) << "The input and output files must differ: "
+                   << jpeg_filename << ", " << filename_;
+      return false;
+    }
+    return true;
+  }
+
+  bool Decode(const string& /* mime */, const BlobRef& data_ref) const {
+    return data_ref.DecodeToFile(filename_);
+  }
+
+  bool Write(const string& /* mime */, const string& data) const {
+    return WriteStringToFile(data, filename_);
+  }
+
+ private:
+  const string filename_;
+};
+
+// Reads the data of the GImage or GAudio metadata of a JPEG file into output,
+// a StringDataOutput or a FileDataOutput. Metadata::FindData() locates the
+// data in the mapped file so that it is decoded straight into the output. If
+// the data cannot be located in place, e.g. because it holds entity
+// references, the extended XMP is parsed and read with FromXmp() instead. As
+// for ReadXmpHeader(), the file name must end in .jpg or .jpeg.
+template <typename Metadata, typename Output>
+bool ExtractData(const string& jpeg_filename, const Output& output) {
+  if (!HasJpegExtension(jpeg_filename)) {
+    LOG(WARNING) << "XMP parse: only JPEG file is supported";
+    return false;
+  }
+  if (!output.AcceptsInput(jpeg_filename)) {
+    return false;
+  }
+  std::unique_ptr<MemoryMappedFile> file =
+      MemoryMappedFile::FromFile(jpeg_filename);
+  if (file == nullptr) {
+    LOG(WARNING) << "Could not read file: " << jpeg_filename;
+    return false;
+  }
+  string mime;
+  BlobRef data_ref;
+  if (Metadata::FindData(file->data(), file->size(), &mime, &data_ref)) {
+    return output.Decode(mime, data_ref);
+  }
+  XmpData xmp;
+  const bool kSkipExtended = false;
+  std::unique_ptr<Metadata> metadata;
+  if (ReadXmpFromMemory(file->data(), file->size(), kSkipExtended, &xmp)) {
+    metadata = Metadata::FromXmp(xmp);
+  }
+  if (metadata == nullptr) {
+    LOG(WARNING) << "No data found in " << jpeg_filename;
+    return false;
+  }
+  return output.Write(metadata->GetMime(), metadata->GetData());
+}
+
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_EXTRACT_TO_FILE_H_
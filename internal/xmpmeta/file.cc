@@ -14,10 +14,132 @@
 
 #include "xmpmeta/file.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
 #include <cstdio>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif  // __linux__
+
+// copy_file_range is available from glibc 2.27.
+#if defined(__linux__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define XMPMETA_HAVE_COPY_FILE_RANGE 1
+#endif
+
 #include "glog/logging.h"
 
 namespace xmpmeta {
+namespace {
+
+// Size of the blocks used when copying file ranges through user space.
+const size_t kCopyBlockSize = 64 * 1024;
+
+// Number of names tried for a temporary file before giving up.
+const int kMaxTempFileAttempts = 100;
+
+// Distinguishes the temporary files created by the threads of one process.
+std::atomic<unsigned int> temp_file_counter(0);
+
+// Returns a name for a temporary file next to filename, so that it can be
+// renamed over filename.
+std::string TempFilenameFor(const std::string& filename) {
+  std::string temp_filename = filename + ".tmp";
+#ifndef _WIN32
+  temp_filename += std::to_string(getpid()) + "-";
+#endif  // _WIN32
+  return temp_filename + std::to_string(temp_file_counter++);
+}
+
+#ifndef _WIN32
+// Maximum number of buffers passed to one writev call.
+#ifdef IOV_MAX
+const size_t kMaxIovecs = IOV_MAX;
+#else
+const size_t kMaxIovecs = 16;  // The minimum that POSIX allows.
+#endif  // IOV_MAX
+
+// Writes all size bytes of data to the file descriptor, retrying on partial
+// writes and interruptions.
+bool WriteFully(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    const ssize_t written = write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+// Writes all the buffers to the file descriptor with as few writev calls as
+// possible, retrying on partial writes and interruptions. The buffers are
+// modified.
+bool WriteVectorFully(int fd, std::vector<struct iovec>* iovecs) {
+  size_t index = 0;
+  while (index < iovecs->size()) {
+    const int count =
+        static_cast<int>(std::min(iovecs->size() - index, kMaxIovecs));
+    ssize_t written = writev(fd, &(*iovecs)[index], count);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    // Skip the buffers that were written, and the start of the one that was
+    // written in part.
+    while (index < iovecs->size() &&
+           static_cast<size_t>(written) >= (*iovecs)[index].iov_len) {
+      written -= (*iovecs)[index].iov_len;
+      ++index;
+    }
+    if (written > 0) {
+      struct iovec& partial = (*iovecs)[index];
+      partial.iov_base = static_cast<char*>(partial.iov_base) + written;
+      partial.iov_len -= written;
+    }
+  }
+  return true;
+}
+
+// Copies length bytes of in_fd starting at *offset to the current position of
+// out_fd by reading them into a buffer. Advances *offset by the bytes copied.
+bool CopyRangeWithBuffer(int in_fd, off_t* offset, size_t length, int out_fd) {
+  char buffer[kCopyBlockSize];
+  while (length > 0) {
+    const ssize_t num_read =
+        pread(in_fd, buffer, std::min(length, sizeof(buffer)), *offset);
+    if (num_read < 0 && errno == EINTR) {
+      continue;
+    }
+    if (num_read <= 0 || !WriteFully(out_fd, buffer, num_read)) {
+      return false;
+    }
+    *offset += num_read;
+    length -= num_read;
+  }
+  return true;
+}
+#endif  // _WIN32
+
+}  // namespace
 
 using std::string;
 
@@ -30,6 +152,22 @@ void WriteStringToFileOrDie(const string &data, const string &filename) {
   fclose(file_descriptor);
 }
 
+bool WriteStringToFile(const string& data, const string& filename) {
+  FILE* file_descriptor = fopen(filename.c_str(), "wb");
+  if (!file_descriptor) {
+    LOG(WARNING) << "Couldn't write to file: " << filename;
+    return false;
+  }
+  bool success =
+      fwrite(data.data(), 1, data.size(), file_descriptor) == data.size();
+  success = fclose(file_descriptor) == 0 && success;
+  if (!success) {
+    LOG(WARNING) << "Couldn't write to file: " << filename;
+    remove(filename.c_str());
+  }
+  return success;
+}
+
 void ReadFileToStringOrDie(const string &filename, string *data) {
   FILE* file_descriptor = fopen(filename.c_str(), "r");
 
@@ -56,6 +194,43 @@ void ReadFileToStringOrDie(const string &filename, string *data) {
   fclose(file_descriptor);
 }
 
+bool WriteStringToFileAt(const string& data, size_t offset,
+                         const string& filename) {
+#ifdef _WIN32
+  FILE* file_descriptor = fopen(filename.c_str(), "r+b");
+  if (!file_descriptor) {
+    LOG(WARNING) << "Couldn't write to file: " << filename;
+    return false;
+  }
+  const bool success = fseek(file_descriptor, offset, SEEK_SET) == 0 &&
+      fwrite(data.data(), 1, data.size(), file_descriptor) == data.size();
+  return fclose(file_descriptor) == 0 && success;
+#else
+  const int file_descriptor = open(filename.c_str(), O_WRONLY);
+  if (file_descriptor < 0) {
+    LOG(WARNING) << "Couldn't write to file: " << filename;
+    return false;
+  }
+  bool success = true;
+  for (size_t written = 0; success && written < data.size();) {
+    const ssize_t num_written = pwrite(file_descriptor, &data[written],
+                                       data.size() - written, offset + written);
+    if (num_written < 0 && errno == EINTR) {
+      continue;
+    }
+    success = num_written > 0;
+    if (success) {
+      written += num_written;
+    }
+  }
+  success = close(file_descriptor) == 0 && success;
+  if (!success) {
+    LOG(WARNING) << "Couldn't write all of " << filename;
+  }
+  return success;
+#endif  // _WIN32
+}
+
 string JoinPath(const string& dirname, const string& basename) {
 #ifdef _WIN32
     static const char separator = '\\';
@@ -72,4 +247,298 @@ string JoinPath(const string& dirname, const string& basename) {
   }
 }
 
+bool IsSameFile(const string& filename1, const string& filename2) {
+#ifdef _WIN32
+  char path1[_MAX_PATH];
+  char path2[_MAX_PATH];
+  return _fullpath(path1, filename1.c_str(), sizeof(path1)) != nullptr &&
+      _fullpath(path2, filename2.c_str(), sizeof(path2)) != nullptr &&
+      _stricmp(path1, path2) == 0;
+#else
+  struct stat stat1;
+  struct stat stat2;
+  return stat(filename1.c_str(), &stat1) == 0 &&
+      stat(filename2.c_str(), &stat2) == 0 &&
+      stat1.st_dev == stat2.st_dev && stat1.st_ino == stat2.st_ino;
+#endif  // _WIN32
+}
+
+MemoryMappedFile::MemoryMappedFile() : data_(nullptr), size_(0) {}
+
+MemoryMappedFile::~MemoryMappedFile() {
+#ifndef _WIN32
+  if (data_ != nullptr && contents_.empty()) {
+    munmap(const_cast<uint8*>(data_), size_);
+  }
+#endif  // _WIN32
+}
+
+std::unique_ptr<MemoryMappedFile> MemoryMappedFile::FromFile(
+    const string& filename) {
+  std::unique_ptr<MemoryMappedFile> file(new MemoryMappedFile());
+#ifdef _WIN32
+  FILE* file_descriptor = fopen(filename.c_str(), "rb");
+  if (!file_descriptor) {
+    LOG(WARNING) << "Couldn't read file: " << filename;
+    return nullptr;
+  }
+  char buffer[4096];
+  size_t num_read;
+  while ((num_read = fread(buffer, 1, sizeof(buffer), file_descriptor)) > 0) {
+    file->contents_.append(buffer, num_read);
+  }
+  fclose(file_descriptor);
+  file->data_ = reinterpret_cast<const uint8*>(file->contents_.data());
+  file->size_ = file->contents_.size();
+#else
+  const int file_descriptor = open(filename.c_str(), O_RDONLY);
+  if (file_descriptor < 0) {
+    LOG(WARNING) << "Couldn't read file: " << filename;
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(file_descriptor, &file_stat) != 0) {
+    LOG(WARNING) << "Couldn't stat file: " << filename;
+    close(file_descriptor);
+    return nullptr;
+  }
+  // Mapping an empty file fails, so leave data_ null in that case.
+  if (file_stat.st_size > 0) {
+    void* mapped = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                        file_descriptor, 0);
+    if (mapped == MAP_FAILED) {
+      LOG(WARNING) << "Couldn't map file: " << filename;
+      close(file_descriptor);
+      return nullptr;
+    }
+    file->data_ = static_cast<const uint8*>(mapped);
+    file->size_ = file_stat.st_size;
+  }
+  // The mapping remains valid after the descriptor is closed.
+  close(file_descriptor);
+#endif  // _WIN32
+  return file;
+}
+
+FileRangeWriter::FileRangeWriter()
+#ifdef _WIN32
+    : input_file_(nullptr), output_file_(nullptr) {}
+#else
+    : input_fd_(-1), output_fd_(-1) {}
+#endif  // _WIN32
+
+FileRangeWriter::~FileRangeWriter() {
+  Close();
+  if (!temp_filename_.empty()) {
+    remove(temp_filename_.c_str());
+  }
+}
+
+bool FileRangeWriter::Close() {
+  bool success = true;
+#ifdef _WIN32
+  if (input_file_ != nullptr) {
+    fclose(input_file_);
+    input_file_ = nullptr;
+  }
+  if (output_file_ != nullptr) {
+    success = fclose(output_file_) == 0;
+    output_file_ = nullptr;
+  }
+#else
+  if (input_fd_ >= 0) {
+    close(input_fd_);
+    input_fd_ = -1;
+  }
+  if (output_fd_ >= 0) {
+    success = close(output_fd_) == 0;
+    output_fd_ = -1;
+  }
+#endif  // _WIN32
+  return success;
+}
+
+std::unique_ptr<FileRangeWriter> FileRangeWriter::Create(
+    const string& input_filename, const string& output_filename) {
+  // Replacing the input would truncate data that is still being read.
+  if (IsSameFile(input_filename, output_filename)) {
+    LOG(WARNING) << "The input and output files must differ: "
+                 << input_filename << ", " << output_filename;
+    return nullptr;
+  }
+  std::unique_ptr<FileRangeWriter> writer(new FileRangeWriter());
+  writer->output_filename_ = output_filename;
+#ifdef _WIN32
+  writer->input_file_ = fopen(input_filename.c_str(), "rb");
+  if (writer->input_file_ == nullptr) {
+    LOG(WARNING) << "Couldn't read file: " << input_filename;
+    return nullptr;
+  }
+  for (int i = 0; i < kMaxTempFileAttempts && writer->output_file_ == nullptr;
+       ++i) {
+    const string temp_filename = TempFilenameFor(output_filename);
+    writer->output_file_ = fopen(temp_filename.c_str(), "wbx");
+    if (writer->output_file_ != nullptr) {
+      writer->temp_filename_ = temp_filename;
+    }
+  }
+  if (writer->output_file_ == nullptr) {
+    LOG(WARNING) << "Couldn't write to file: " << output_filename;
+    return nullptr;
+  }
+#else
+  writer->input_fd_ = open(input_filename.c_str(), O_RDONLY);
+  if (writer->input_fd_ < 0) {
+    LOG(WARNING) << "Couldn't read file: " << input_filename;
+    return nullptr;
+  }
+  // Replace the file that a symbolic link points to rather than the link.
+  char* resolved_filename = realpath(output_filename.c_str(), nullptr);
+  if (resolved_filename != nullptr) {
+    writer->output_filename_ = resolved_filename;
+    free(resolved_filename);
+  }
+  for (int i = 0; i < kMaxTempFileAttempts && writer->output_fd_ < 0; ++i) {
+    const string temp_filename = TempFilenameFor(writer->output_filename_);
+    writer->output_fd_ =
+        open(temp_filename.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (writer->output_fd_ >= 0) {
+      writer->temp_filename_ = temp_filename;
+    } else if (errno != EEXIST) {
+      break;
+    }
+  }
+  if (writer->output_fd_ < 0) {
+    LOG(WARNING) << "Couldn't write to file: " << output_filename;
+    return nullptr;
+  }
+  // Keep the mode and, where permitted, the owner of an existing output file.
+  struct stat output_stat;
+  if (stat(writer->output_filename_.c_str(), &output_stat) == 0) {
+    if (fchmod(writer->output_fd_, output_stat.st_mode & 07777) != 0) {
+      LOG(WARNING) << "Couldn't set the mode of file: " << output_filename;
+      return nullptr;
+    }
+    // Only a privileged process can give the file to another user.
+    if (fchown(writer->output_fd_, output_stat.st_uid, output_stat.st_gid) !=
+        0) {
+      LOG(WARNING) << "Couldn't keep the owner of file: " << output_filename;
+    }
+  }
+#endif  // _WIN32
+  return writer;
+}
+
+bool FileRangeWriter::Commit() {
+  if (!Flush() || !Close()) {
+    LOG(WARNING) << "Couldn't write to file: " << output_filename_;
+    return false;
+  }
+#ifdef _WIN32
+  // rename does not replace an existing file on Windows.
+  remove(output_filename_.c_str());
+#endif  // _WIN32
+  if (rename(temp_filename_.c_str(), output_filename_.c_str()) != 0) {
+    LOG(WARNING) << "Couldn't write to file: " << output_filename_;
+    return false;
+  }
+  temp_filename_.clear();
+  return true;
+}
+
+bool FileRangeWriter::Write(const char* data, size_t size) {
+#ifdef _WIN32
+  return fwrite(data, 1, size, output_file_) == size;
+#else
+  if (size == 0) {
+    return true;
+  }
+  if (size <= kMaxCopiedSize) {
+    pending_writes_.push_back({nullptr, copied_data_.size(), size});
+    copied_data_.append(data, size);
+  } else {
+    pending_writes_.push_back({data, 0, size});
+  }
+  return true;
+#endif  // _WIN32
+}
+
+bool FileRangeWriter::Flush() {
+#ifdef _WIN32
+  return fflush(output_file_) == 0;
+#else
+  if (pending_writes_.empty()) {
+    return true;
+  }
+  // Pointers into copied_data_ are only taken once it is no longer appended
+  // to.
+  std::vector<struct iovec> iovecs;
+  iovecs.reserve(pending_writes_.size());
+  for (const PendingWrite& pending : pending_writes_) {
+    char* data = pending.data != nullptr
+                     ? const_cast<char*>(pending.data)
+                     : &copied_data_[pending.offset];
+    iovecs.push_back({data, pending.size});
+  }
+  pending_writes_.clear();
+  const bool success = WriteVectorFully(output_fd_, &iovecs);
+  copied_data_.clear();
+  return success;
+#endif  // _WIN32
+}
+
+bool FileRangeWriter::CopyRange(size_t offset, size_t length) {
+  if (!Flush()) {
+    return false;
+  }
+#ifdef _WIN32
+  if (fseek(input_file_, offset, SEEK_SET) != 0) {
+    return false;
+  }
+  char buffer[kCopyBlockSize];
+  while (length > 0) {
+    const size_t num_read =
+        fread(buffer, 1, std::min(length, sizeof(buffer)), input_file_);
+    if (num_read == 0 ||
+        fwrite(buffer, 1, num_read, output_file_) != num_read) {
+      return false;
+    }
+    length -= num_read;
+  }
+  return true;
+#else
+  off_t input_offset = offset;
+#ifdef XMPMETA_HAVE_COPY_FILE_RANGE
+  // Lets the kernel copy the data, or share the extents on filesystems that
+  // support it. Falls through to sendfile if the files are on different
+  // filesystems or the kernel does not support the call.
+  while (length > 0) {
+    const ssize_t copied = copy_file_range(input_fd_, &input_offset,
+                                           output_fd_, nullptr, length, 0);
+    if (copied < 0 && errno == EINTR) {
+      continue;
+    }
+    if (copied <= 0) {
+      break;
+    }
+    length -= copied;
+  }
+#endif  // XMPMETA_HAVE_COPY_FILE_RANGE
+#ifdef __linux__
+  while (length > 0) {
+    const ssize_t copied =
+        sendfile(output_fd_, input_fd_, &input_offset, length);
+    if (copied < 0 && errno == EINTR) {
+      continue;
+    }
+    if (copied <= 0) {
+      break;
+    }
+    length -= copied;
+  }
+#endif  // __linux__
+  return CopyRangeWithBuffer(input_fd_, &input_offset, length, output_fd_);
+#endif  // _WIN32
+}
+
 }  // namespace xmpmeta
@@ -15,7 +15,12 @@
 #ifndef XMPMETA_FILE_H_
 #define XMPMETA_FILE_H_
 
+#include <cstdio>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "base/integral_types.h"
 
 namespace xmpmeta {
 
@@ -23,10 +28,125 @@ void WriteStringToFileOrDie(const std::string &data,
                             const std::string &filename);
 void ReadFileToStringOrDie(const std::string &filename, std::string *data);
 
+// Writes data to the file, replacing its contents. Returns false on failure,
+// in which case the file is removed.
+bool WriteStringToFile(const std::string& data, const std::string& filename);
+
+// Overwrites the bytes of an existing file starting at offset with data,
+// leaving the rest of the file unchanged. Returns false on failure.
+bool WriteStringToFileAt(const std::string& data, size_t offset,
+                         const std::string& filename);
+
 // Join two path components, adding a slash if necessary.  If basename is an
 // absolute path then JoinPath ignores dirname and simply returns basename.
 std::string JoinPath(const std::string& dirname, const std::string& basename);
 
+// Returns true if both paths name the same existing file, including through
+// relative paths, symbolic links or hard links.
+bool IsSameFile(const std::string& filename1, const std::string& filename2);
+
+// A read-only view of the contents of a file. On POSIX systems the file is
+// memory-mapped, so only the pages that are actually accessed are read from
+// disk. Elsewhere, the whole file is read into memory.
+class MemoryMappedFile {
+ public:
+  ~MemoryMappedFile();
+
+  // Returns null if the file could not be opened or mapped.
+  static std::unique_ptr<MemoryMappedFile> FromFile(
+      const std::string& filename);
+
+  // Returns the contents of the file. May be null if the file is empty.
+  const uint8* data() const { return data_; }
+
+  // Returns the size of the file in bytes.
+  size_t size() const { return size_; }
+
+  // Disallow copying.
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  void operator=(const MemoryMappedFile&) = delete;
+
+ private:
+  MemoryMappedFile();
+
+  const uint8* data_;
+  size_t size_;
+  // Holds the file contents where memory-mapping is not available.
+  std::string contents_;
+};
+
+// Writes a new output file whose contents are taken partly from an input file.
+// On Linux, byte ranges of the input are copied with copy_file_range or
+// sendfile, so they are not passed through user space. Elsewhere, they are
+// read and written in fixed-size blocks.
+// On POSIX systems, the data given to Write is gathered and written with one
+// writev call before the next range is copied, or by Flush.
+// The data is written to a temporary file in the directory of the output file,
+// which replaces the output file on Commit. The temporary file is removed if
+// the writer is destroyed before then, so a failed write leaves no partial
+// output behind. On POSIX systems, if the output file is a symbolic link, the
+// file it points to is replaced and the link is kept; the new file gets the
+// mode of the file it replaces, and its owner where the process may set it.
+class FileRangeWriter {
+ public:
+  ~FileRangeWriter();
+
+  // Returns null if the input file could not be opened for reading, the
+  // output file is the input file, or the temporary file could not be created.
+  static std::unique_ptr<FileRangeWriter> Create(
+      const std::string& input_filename, const std::string& output_filename);
+
+  // Appends size bytes of data to the output file. Data of up to
+  // kMaxCopiedSize bytes, such as a section header, is copied. Larger data is
+  // not, and must remain valid until the next call to CopyRange or Flush.
+  bool Write(const char* data, size_t size);
+
+  // Appends length bytes of the input file, starting at offset, to the output
+  // file.
+  bool CopyRange(size_t offset, size_t length);
+
+  // Writes the data that is still pending. Must be called after the last
+  // Write, since the destructor does not write it.
+  bool Flush();
+
+  // Writes the pending data and renames the temporary file to the output file.
+  // The writer must not be used afterwards. On failure, the temporary file is
+  // removed and the output file is left unchanged.
+  bool Commit();
+
+  static const size_t kMaxCopiedSize = 256;
+
+  // Disallow copying.
+  FileRangeWriter(const FileRangeWriter&) = delete;
+  void operator=(const FileRangeWriter&) = delete;
+
+ private:
+  FileRangeWriter();
+
+  // Closes the files, returning false if the output could not be closed.
+  bool Close();
+
+  std::string temp_filename_;
+  std::string output_filename_;
+#ifdef _WIN32
+  FILE* input_file_;
+  FILE* output_file_;
+#else
+  // Data given to Write that is not written yet. A piece that was copied has
+  // a null data pointer and starts at offset in copied_data_.
+  struct PendingWrite {
+    const char* data;
+    size_t offset;
+    size_t size;
+  };
+
+  int input_fd_;
+  int output_fd_;
+  std::vector<PendingWrite> pending_writes_;
+  std::string copied_data_;
+#endif  // _WIN32
+};
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_FILE_H_
@@ -0,0 +1,155 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/file.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/test_util.h"
+
+namespace xmpmeta {
+namespace {
+
+TEST(File, MemoryMappedFileHasFileContents) {
+  const std::string filename = TempFileAbsolutePath("mapped.txt");
+  std::string expected("mapped\0contents", 15);
+  WriteStringToFileOrDie(expected, filename);
+
+  std::unique_ptr<MemoryMappedFile> file = MemoryMappedFile::FromFile(filename);
+  ASSERT_NE(nullptr, file);
+  ASSERT_EQ(expected.size(), file->size());
+  EXPECT_EQ(expected, std::string(reinterpret_cast<const char*>(file->data()),
+                                  file->size()));
+}
+
+TEST(File, MemoryMappedFileEmpty) {
+  const std::string filename = TempFileAbsolutePath("empty.txt");
+  WriteStringToFileOrDie("", filename);
+
+  std::unique_ptr<MemoryMappedFile> file = MemoryMappedFile::FromFile(filename);
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(0u, file->size());
+}
+
+TEST(File, MemoryMappedFileMissing) {
+  EXPECT_EQ(nullptr, MemoryMappedFile::FromFile(
+                         TempFileAbsolutePath("does_not_exist.txt")));
+}
+
+TEST(File, FileRangeWriterGathersWrites) {
+  const std::string input_filename = TempFileAbsolutePath("range_input.txt");
+  const std::string input = "0123456789";
+  WriteStringToFileOrDie(input, input_filename);
+  const std::string output_filename = TempFileAbsolutePath("range_output.txt");
+  std::unique_ptr<FileRangeWriter> writer =
+      FileRangeWriter::Create(input_filename, output_filename);
+  ASSERT_NE(nullptr, writer);
+
+  // Use more pieces than fit in one writev call, both copied and not.
+  const std::string large(FileRangeWriter::kMaxCopiedSize + 1, 'x');
+  std::string expected;
+  for (int i = 0; i < 2000; ++i) {
+    const std::string small(i % 5, static_cast<char>('a' + i % 26));
+    ASSERT_TRUE(writer->Write(small.data(), small.size()));
+    expected.append(small);
+    if (i % 100 == 0) {
+      ASSERT_TRUE(writer->Write(large.data(), large.size()));
+      expected.append(large);
+      ASSERT_TRUE(writer->CopyRange(i % 7, 3));
+      expected.append(input, i % 7, 3);
+    }
+  }
+  ASSERT_TRUE(writer->Commit());
+  writer.reset();
+
+  std::string contents;
+  ReadFileToStringOrDie(output_filename, &contents);
+  EXPECT_EQ(expected, contents);
+}
+
+TEST(File, FileRangeWriterReplacesOutputOnlyOnCommit) {
+  const std::string input_filename = TempFileAbsolutePath("commit_input.txt");
+  WriteStringToFileOrDie("input", input_filename);
+  const std::string output_filename = TempFileAbsolutePath("commit_output.txt");
+  WriteStringToFileOrDie("old output", output_filename);
+
+  std::unique_ptr<FileRangeWriter> writer =
+      FileRangeWriter::Create(input_filename, output_filename);
+  ASSERT_NE(nullptr, writer);
+  ASSERT_TRUE(writer->CopyRange(0, 5));
+  writer.reset();
+  std::string contents;
+  ReadFileToStringOrDie(output_filename, &contents);
+  EXPECT_EQ("old output", contents);
+
+  writer = FileRangeWriter::Create(input_filename, output_filename);
+  ASSERT_NE(nullptr, writer);
+  ASSERT_TRUE(writer->CopyRange(0, 5));
+  ASSERT_TRUE(writer->Commit());
+  ReadFileToStringOrDie(output_filename, &contents);
+  EXPECT_EQ("input", contents);
+}
+
+TEST(File, FileRangeWriterKeepsOutputLinkAndMode) {
+  const std::string input_filename = TempFileAbsolutePath("mode_input.txt");
+  WriteStringToFileOrDie("input", input_filename);
+  const std::string output_filename = TempFileAbsolutePath("mode_output.txt");
+  WriteStringToFileOrDie("old output", output_filename);
+  ASSERT_EQ(0, chmod(output_filename.c_str(), 0640));
+  const std::string link_filename = TempFileAbsolutePath("mode_link.txt");
+  remove(link_filename.c_str());
+  ASSERT_EQ(0, symlink(output_filename.c_str(), link_filename.c_str()));
+
+  std::unique_ptr<FileRangeWriter> writer =
+      FileRangeWriter::Create(input_filename, link_filename);
+  ASSERT_NE(nullptr, writer);
+  ASSERT_TRUE(writer->CopyRange(0, 5));
+  ASSERT_TRUE(writer->Commit());
+
+  // The file the link points to is replaced, and the link is kept.
+  struct stat link_stat;
+  ASSERT_EQ(0, lstat(link_filename.c_str(), &link_stat));
+  EXPECT_TRUE(S_ISLNK(link_stat.st_mode));
+  std::string contents;
+  ReadFileToStringOrDie(output_filename, &contents);
+  EXPECT_EQ("input", contents);
+  struct stat output_stat;
+  ASSERT_EQ(0, stat(output_filename.c_str(), &output_stat));
+  EXPECT_EQ(0640u, output_stat.st_mode & 07777u);
+}
+
+TEST(File, FileRangeWriterRejectsInputAsOutput) {
+  const std::string input_filename = TempFileAbsolutePath("alias_input.txt");
+  WriteStringToFileOrDie("input", input_filename);
+  const std::string link_filename = TempFileAbsolutePath("alias_link.txt");
+  remove(link_filename.c_str());
+  ASSERT_EQ(0, link(input_filename.c_str(), link_filename.c_str()));
+
+  EXPECT_TRUE(IsSameFile(input_filename, link_filename));
+  EXPECT_EQ(nullptr, FileRangeWriter::Create(input_filename, link_filename));
+  EXPECT_FALSE(IsSameFile(input_filename,
+                          TempFileAbsolutePath("alias_missing.txt")));
+  std::string contents;
+  ReadFileToStringOrDie(input_filename, &contents);
+  EXPECT_EQ("input", contents);
+}
+
+}  // namespace
+}  // namespace xmpmeta
@@ -18,6 +18,8 @@
 
 #include "glog/logging.h"
 #include "xmpmeta/base64.h"
+#include "xmpmeta/extract_to_file.h"
+#include "xmpmeta/file.h"
 #include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
@@ -79,12 +81,29 @@ std::unique_ptr<GAudio> GAudio::FromXmp(const XmpData& xmp) {
 }
 
 std::unique_ptr<GAudio> GAudio::FromJpegFile(const string& filename) {
+  std::unique_ptr<GAudio> gaudio(new GAudio());
+  const StringDataOutput output(&gaudio->mime_, &gaudio->data_);
+  return ExtractData<GAudio>(filename, output) ? std::move(gaudio) : nullptr;
+}
+
+bool GAudio::FindData(const uint8* buffer, size_t size, BlobRef* data_ref) {
+  string mime;
+  return FindData(buffer, size, &mime, data_ref);
+}
+
+bool GAudio::FindData(const uint8* buffer, size_t size, string* mime,
+                     BlobRef* data_ref) {
   XmpData xmp;
-  const bool kSkipExtended = false;
-  if (!ReadXmpHeader(filename, kSkipExtended, &xmp)) {
-    return nullptr;
+  const bool kSkipExtended = true;
+  if (!ReadXmpFromMemory(buffer, size, kSkipExtended, &xmp)) {
+    return false;
+  }
+  DeserializerImpl std_deserializer(
+      GetFirstDescriptionElement(xmp.StandardSection()));
+  if (!std_deserializer.ParseString(kPrefix, kMime, mime)) {
+    return false;
   }
-  return FromXmp(xmp);
+  return FindExtendedXmpBlob(buffer, size, xmp, kPrefix, kData, data_ref);
 }
 
 bool GAudio::IsPresent(const XmpData& xmp) {
@@ -122,4 +141,9 @@ bool GAudio::Serialize(xml::Serializer* std_serializer,
   return ext_serializer->WriteProperty(kPrefix, kData, encoded);
 }
 
+bool ExtractGAudioToFile(const string& jpeg_filename,
+                         const string& output_filename) {
+  return ExtractData<GAudio>(jpeg_filename, FileDataOutput(output_filename));
+}
+
 }  // namespace xmpmeta
@@ -14,8 +14,12 @@
 
 #include "xmpmeta/gaudio.h"
 
+#include <unistd.h>
+
+#include <cstdio>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <libxml/tree.h>
 
@@ -23,6 +27,7 @@
 #include "gtest/gtest.h"
 #include "xmpmeta/file.h"
 #include "xmpmeta/test_util.h"
+#include "xmpmeta/test_xmp_creator.h"
 #include "xmpmeta/xmp_data.h"
 #include "xmpmeta/xmp_writer.h"
 #include "xmpmeta/xml/const.h"
@@ -68,11 +73,82 @@ TEST(GAudio, ParseVrPhotoXmp) {
   EXPECT_EQ(expected_audio_data, gaudio->GetData());
 }
 
+TEST(GAudio, ExtractGAudioToFile) {
+  const string left_path = TestFileAbsolutePath(kLeftFile);
+  const string audio_path = TestFileAbsolutePath(kAudioFile);
+  const string output_path = TempFileAbsolutePath("gaudio_output.mp4");
+  ASSERT_TRUE(ExtractGAudioToFile(left_path, output_path));
+
+  std::string expected_audio_data;
+  ReadFileToStringOrDie(audio_path, &expected_audio_data);
+  std::string audio_data;
+  ReadFileToStringOrDie(output_path, &audio_data);
+  EXPECT_EQ(expected_audio_data, audio_data);
+
+  EXPECT_FALSE(ExtractGAudioToFile(kBadPath, output_path));
+
+  // The input is never overwritten.
+  string contents;
+  ReadFileToStringOrDie(left_path, &contents);
+  const string jpeg_path = TempFileAbsolutePath("gaudio_input.jpg");
+  WriteStringToFileOrDie(contents, jpeg_path);
+  const string link_path = TempFileAbsolutePath("gaudio_link");
+  remove(link_path.c_str());
+  ASSERT_EQ(0, symlink(jpeg_path.c_str(), link_path.c_str()));
+  EXPECT_FALSE(ExtractGAudioToFile(jpeg_path, link_path));
+  string link_contents;
+  ReadFileToStringOrDie(link_path, &link_contents);
+  EXPECT_EQ(contents, link_contents);
+}
+
+TEST(GAudio, ExtractGAudioToFileWithEntityReferences) {
+  // Data with entity references cannot be decoded in place, and is read by
+  // parsing the extended section instead.
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(
+          2, "123ABCxxxxxxxx",
+          "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+          "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+          "<rdf:Description"
+          " xmlns:GAudio=\"http://ns.google.com/photos/1.0/audio/\""
+          " GAudio:Data=\"YWJj&#10;ZGVm\"/>"
+          "</rdf:RDF></x:xmpmeta>");
+  xmp_sections.insert(
+      xmp_sections.begin(),
+      TestXmpCreator::CreateStandardXmpString(
+          "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+          "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+          "<rdf:Description"
+          " xmlns:GAudio=\"http://ns.google.com/photos/1.0/audio/\""
+          " xmlns:xmpNote=\"http://ns.adobe.com/xmp/note/\""
+          " GAudio:Mime=\"audio/mp4a-latm\" xmpNote:HasExtendedXMP=\"123ABC\"/>"
+          "</rdf:RDF></x:xmpmeta>"));
+  const string jpeg_path = TempFileAbsolutePath("gaudio_entity.jpg");
+  TestXmpCreator::WriteJPEGFile(jpeg_path, xmp_sections);
+
+  const string output_path = TempFileAbsolutePath("gaudio_entity_output");
+  ASSERT_TRUE(ExtractGAudioToFile(jpeg_path, output_path));
+  std::string audio_data;
+  ReadFileToStringOrDie(output_path, &audio_data);
+  EXPECT_EQ("abcdef", audio_data);
+}
+
 TEST(GAudio, BadPath) {
   std::unique_ptr<GAudio> gaudio = GAudio::FromJpegFile(kBadPath);
   ASSERT_EQ(nullptr, gaudio);
 }
 
+TEST(GAudio, RequiresJpegExtension) {
+  ExpectOnlyJpegExtensionRead(
+      kLeftFile, "gaudio_left", [](const string& path) {
+        return GAudio::FromJpegFile(path) != nullptr;
+      });
+  ExpectOnlyJpegExtensionRead(
+      kLeftFile, "gaudio_extract", [](const string& path) {
+        return ExtractGAudioToFile(path, TempFileAbsolutePath("gaudio_output"));
+      });
+}
+
 TEST(GAudio, IsPresent) {
   const string left_path = TestFileAbsolutePath(kLeftFile);
   EXPECT_TRUE(GAudio::IsPresent(left_path));
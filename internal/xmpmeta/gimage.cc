@@ -18,13 +18,18 @@
 
 #include "glog/logging.h"
 #include "xmpmeta/base64.h"
+#include "xmpmeta/extract_to_file.h"
+#include "xmpmeta/file.h"
 #include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/property_scanner.h"
+#include "xmpmeta/xml/property_set.h"
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::xml::DeserializerImpl;
 using xmpmeta::xml::GetFirstDescriptionElement;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::XmlConst;
 
 namespace xmpmeta {
@@ -35,6 +40,10 @@ const char kMime[] = "Mime";
 const char kData[] = "Data";
 const char kMimePng[] = "image/png";
 const char kMimeJpeg[] = "image/jpeg";
+
+// Longest Mime value kept by ScanXmpPacketProperties. Only the presence of the
+// value is checked.
+const size_t kMaxMimeLength = 16;
 const char kNamespaceHref[] = "http://ns.google.com/photos/1.0/image/";
 
 }  // namespace
@@ -81,12 +90,29 @@ std::unique_ptr<GImage> GImage::FromXmp(const XmpData& xmp) {
 }
 
 std::unique_ptr<GImage> GImage::FromJpegFile(const string& filename) {
+  std::unique_ptr<GImage> gimage(new GImage());
+  const StringDataOutput output(&gimage->mime_, &gimage->data_);
+  return ExtractData<GImage>(filename, output) ? std::move(gimage) : nullptr;
+}
+
+bool GImage::FindData(const uint8* buffer, size_t size, BlobRef* data_ref) {
+  string mime;
+  return FindData(buffer, size, &mime, data_ref);
+}
+
+bool GImage::FindData(const uint8* buffer, size_t size, string* mime,
+                     BlobRef* data_ref) {
   XmpData xmp;
-  const bool kSkipExtended = false;
-  if (!ReadXmpHeader(filename, kSkipExtended, &xmp)) {
-    return nullptr;
+  const bool kSkipExtended = true;
+  if (!ReadXmpFromMemory(buffer, size, kSkipExtended, &xmp)) {
+    return false;
+  }
+  DeserializerImpl std_deserializer(
+      GetFirstDescriptionElement(xmp.StandardSection()));
+  if (!std_deserializer.ParseString(kPrefix, kMime, mime)) {
+    return false;
   }
-  return FromXmp(xmp);
+  return FindExtendedXmpBlob(buffer, size, xmp, kPrefix, kData, data_ref);
 }
 
 bool GImage::IsPresent(const XmpData& xmp) {
@@ -105,6 +131,14 @@ bool GImage::IsPresent(const string& filename) {
   return IsPresent(xmp);
 }
 
+bool GImage::IsPresent(const char* xmp_packet, size_t length) {
+  const char* const kPropertyNames[] = {kMime};
+  PropertySet properties(kPropertyNames);
+  return xml::ScanXmpPacketProperties(xmp_packet, length, kPrefix,
+                                      kMaxMimeLength, &properties) &&
+         properties.has_value(0);
+}
+
 bool GImage::Serialize(xml::Serializer* std_serializer,
                        xml::Serializer* ext_serializer) const {
   if (std_serializer == nullptr || ext_serializer == nullptr) {
@@ -124,4 +158,9 @@ bool GImage::Serialize(xml::Serializer* std_serializer,
   return ext_serializer->WriteProperty(kPrefix, kData, encoded);
 }
 
+bool ExtractGImageToFile(const string& jpeg_filename,
+                         const string& output_filename) {
+  return ExtractData<GImage>(jpeg_filename, FileDataOutput(output_filename));
+}
+
 }  // namespace xmpmeta
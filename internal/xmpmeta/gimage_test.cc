@@ -14,14 +14,26 @@
 
 #include "xmpmeta/gimage.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif  // __GLIBC__
 
 #include <libxml/tree.h>
+#include <libxml/xmlmemory.h>
 
 #include "glog/logging.h"
 #include "xmpmeta/file.h"
 #include "xmpmeta/test_util.h"
+#include "xmpmeta/test_xmp_creator.h"
 #include "xmpmeta/xmp_data.h"
 #include "xmpmeta/xmp_writer.h"
 #include "xmpmeta/xml/const.h"
@@ -39,6 +51,28 @@ const char kLeftFile[] = "left_with_xmp.jpg";
 const char kMime[] = "image/jpeg";
 const char kRightFile[] = "right_embedded.jpg";
 
+const char kXmpBody[] =
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+    "<rdf:Description xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+    " xmlns:xmpNote=\"http://ns.adobe.com/xmp/note/\""
+    " GImage:Mime=\"image/jpeg\" xmpNote:HasExtendedXMP=\"123ABC\"/>"
+    "</rdf:RDF></x:xmpmeta>";
+const char kXmpExtensionHeaderPart2[] = "123ABCxxxxxxxx";
+
+// Writes a JPEG file whose extended XMP is extension_body, and returns its
+// path.
+string WriteJpegWithExtension(const string& name, const char* extension_body) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                extension_body);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string path = TempFileAbsolutePath(name);
+  TestXmpCreator::WriteJPEGFile(path, xmp_sections);
+  return path;
+}
+
 std::unique_ptr<SerializerImpl>
     CreateSerializerForTest(const XmpData& xmp_data, bool use_extended_section,
                             const xmlNsPtr xml_ns) {
@@ -66,11 +100,232 @@ TEST(GImage, ParseVrPhotoXmp) {
   EXPECT_EQ(expected_image_data, gimage->GetData());
 }
 
+TEST(GImage, FindData) {
+  const string left_path = TestFileAbsolutePath(kLeftFile);
+  const string right_path = TestFileAbsolutePath(kRightFile);
+  std::string left_contents;
+  ReadFileToStringOrDie(left_path, &left_contents);
+  const uint8* buffer = reinterpret_cast<const uint8*>(left_contents.data());
+
+  BlobRef data_ref;
+  ASSERT_TRUE(GImage::FindData(buffer, left_contents.size(), &data_ref));
+  // The data spans many extended sections, and points into the buffer.
+  ASSERT_GT(data_ref.Segments().size(), 1);
+  for (const BlobRef::Segment& segment : data_ref.Segments()) {
+    EXPECT_GE(segment.data, left_contents.data());
+    EXPECT_LE(segment.data + segment.length,
+              left_contents.data() + left_contents.size());
+  }
+
+  std::string expected_image_data;
+  ReadFileToStringOrDie(right_path, &expected_image_data);
+  string decoded;
+  ASSERT_TRUE(data_ref.DecodeToString(&decoded));
+  EXPECT_EQ(expected_image_data, decoded);
+
+  // Decode in blocks into a sink.
+  string streamed;
+  ASSERT_TRUE(data_ref.Decode([&streamed](const char* data, size_t length) {
+    streamed.append(data, length);
+    return true;
+  }));
+  EXPECT_EQ(expected_image_data, streamed);
+
+  std::string right_contents;
+  ReadFileToStringOrDie(right_path, &right_contents);
+  EXPECT_FALSE(GImage::FindData(
+      reinterpret_cast<const uint8*>(right_contents.data()),
+      right_contents.size(), &data_ref));
+}
+
+TEST(GImage, FromJpegFileReadsDataAsXml) {
+  // The data of a CDATA section is its content.
+  const string cdata_path = WriteJpegWithExtension(
+      "gimage_cdata.jpg",
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description"
+      " xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\">"
+      "<GImage:Data><![CDATA[aGVsbG8=]]></GImage:Data>"
+      "</rdf:Description></rdf:RDF></x:xmpmeta>");
+  std::unique_ptr<GImage> gimage = GImage::FromJpegFile(cdata_path);
+  ASSERT_NE(nullptr, gimage);
+  EXPECT_EQ("hello", gimage->GetData());
+
+  // Text in a comment is not the data.
+  const string comment_path = WriteJpegWithExtension(
+      "gimage_comment.jpg",
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<!-- GImage:Data=\"Ym9ndXM=\" -->"
+      "<rdf:Description xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+      " GImage:Data=\"aGVsbG8=\"/>"
+      "</rdf:RDF></x:xmpmeta>");
+  gimage = GImage::FromJpegFile(comment_path);
+  ASSERT_NE(nullptr, gimage);
+  EXPECT_EQ("hello", gimage->GetData());
+}
+
+TEST(GImage, ExtractGImageToFile) {
+  const string left_path = TestFileAbsolutePath(kLeftFile);
+  const string right_path = TestFileAbsolutePath(kRightFile);
+  const string output_path = TempFileAbsolutePath("gimage_output.jpg");
+  ASSERT_TRUE(ExtractGImageToFile(left_path, output_path));
+
+  std::string expected_image_data;
+  ReadFileToStringOrDie(right_path, &expected_image_data);
+  std::string image_data;
+  ReadFileToStringOrDie(output_path, &image_data);
+  EXPECT_EQ(expected_image_data, image_data);
+
+  EXPECT_FALSE(ExtractGImageToFile(kBadPath, output_path));
+
+  // The input is never overwritten.
+  string contents;
+  ReadFileToStringOrDie(left_path, &contents);
+  const string jpeg_path = TempFileAbsolutePath("gimage_input.jpg");
+  WriteStringToFileOrDie(contents, jpeg_path);
+  const string link_path = TempFileAbsolutePath("gimage_link");
+  remove(link_path.c_str());
+  ASSERT_EQ(0, symlink(jpeg_path.c_str(), link_path.c_str()));
+  EXPECT_FALSE(ExtractGImageToFile(jpeg_path, link_path));
+  string link_contents;
+  ReadFileToStringOrDie(link_path, &link_contents);
+  EXPECT_EQ(contents, link_contents);
+  // The right eye image has no GImage data of its own.
+  EXPECT_FALSE(ExtractGImageToFile(right_path, output_path));
+}
+
+#ifdef __GLIBC__
+// Counts the bytes that libxml2 holds while it is installed, and the peak.
+class XmlMemoryCounter {
+ public:
+  XmlMemoryCounter() {
+    xmlMemGet(&free_, &malloc_, &realloc_, &strdup_);
+    current_ = 0;
+    peak_ = 0;
+    xmlMemSetup(Free, Malloc, Realloc, Strdup);
+  }
+  ~XmlMemoryCounter() { xmlMemSetup(free_, malloc_, realloc_, strdup_); }
+
+  static long long peak() { return peak_; }
+
+ private:
+  static void Add(void* block) {
+    if (block != nullptr) {
+      current_ += malloc_usable_size(block);
+      peak_ = std::max(peak_, current_);
+    }
+  }
+  static void Free(void* block) {
+    if (block != nullptr) {
+      current_ -= malloc_usable_size(block);
+    }
+    free(block);
+  }
+  static void* Malloc(size_t size) {
+    void* block = malloc(size);
+    Add(block);
+    return block;
+  }
+  static void* Realloc(void* block, size_t size) {
+    if (block != nullptr) {
+      current_ -= malloc_usable_size(block);
+    }
+    void* new_block = realloc(block, size);
+    Add(new_block);
+    return new_block;
+  }
+  static char* Strdup(const char* text) {
+    char* copy = static_cast<char*>(Malloc(strlen(text) + 1));
+    if (copy != nullptr) {
+      strcpy(copy, text);
+    }
+    return copy;
+  }
+
+  static long long current_;
+  static long long peak_;
+  xmlFreeFunc free_;
+  xmlMallocFunc malloc_;
+  xmlReallocFunc realloc_;
+  xmlStrdupFunc strdup_;
+};
+
+long long XmlMemoryCounter::current_ = 0;
+long long XmlMemoryCounter::peak_ = 0;
+
+TEST(GImage, ExtractGImageToFileHoldsLittleOfTheData) {
+  // Three megabytes of data, in as many extended sections as it takes.
+  const size_t kNumRepeats = 1000 * 1000;
+  string body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description"
+      " xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+      " GImage:Data=\"";
+  for (size_t i = 0; i < kNumRepeats; ++i) {
+    body.append("QUJD");
+  }
+  body.append("\"/></rdf:RDF></x:xmpmeta>");
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(
+          body.size() / 60000 + 1, kXmpExtensionHeaderPart2, body.c_str());
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string jpeg_path = TempFileAbsolutePath("gimage_large.jpg");
+  TestXmpCreator::WriteJPEGFile(jpeg_path, xmp_sections);
+  const string output_path = TempFileAbsolutePath("gimage_large_output");
+  // Extract once beforehand, so that libxml2 sets up its global state.
+  ASSERT_TRUE(ExtractGImageToFile(jpeg_path, output_path));
+
+  {
+    XmlMemoryCounter counter;
+    ASSERT_TRUE(ExtractGImageToFile(jpeg_path, output_path));
+    // The parser holds its usual buffers, but not the data.
+    EXPECT_LT(XmlMemoryCounter::peak(), 256 * 1024);
+  }
+  std::string image_data;
+  ReadFileToStringOrDie(output_path, &image_data);
+  ASSERT_EQ(3 * kNumRepeats, image_data.size());
+  EXPECT_EQ(string::npos, image_data.find_first_not_of("ABC"));
+}
+#endif  // __GLIBC__
+
+TEST(GImage, ExtractGImageToFileWithEntityReferences) {
+  // Data with entity references cannot be decoded in place, and is read by
+  // parsing the extended section instead.
+  const string jpeg_path = WriteJpegWithExtension(
+      "gimage_entity.jpg",
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description"
+      " xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+      " GImage:Data=\"YWJj&#10;ZGVm\"/>"
+      "</rdf:RDF></x:xmpmeta>");
+  const string output_path = TempFileAbsolutePath("gimage_entity_output");
+  ASSERT_TRUE(ExtractGImageToFile(jpeg_path, output_path));
+  std::string image_data;
+  ReadFileToStringOrDie(output_path, &image_data);
+  EXPECT_EQ("abcdef", image_data);
+}
+
 TEST(GImage, BadPath) {
   std::unique_ptr<GImage> gimage = GImage::FromJpegFile(kBadPath);
   ASSERT_EQ(nullptr, gimage);
 }
 
+TEST(GImage, RequiresJpegExtension) {
+  ExpectOnlyJpegExtensionRead(
+      kLeftFile, "gimage_left", [](const string& path) {
+        return GImage::FromJpegFile(path) != nullptr;
+      });
+  ExpectOnlyJpegExtensionRead(
+      kLeftFile, "gimage_extract", [](const string& path) {
+        return ExtractGImageToFile(path, TempFileAbsolutePath("gimage_output"));
+      });
+}
+
 TEST(GImage, IsPresent) {
   const string left_path = TestFileAbsolutePath(kLeftFile);
   EXPECT_TRUE(GImage::IsPresent(left_path));
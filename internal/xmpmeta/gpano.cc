@@ -15,15 +15,20 @@
 #include "xmpmeta/gpano.h"
 
 #include "glog/logging.h"
+#include "strings/numbers.h"
+#include "xmpmeta/file.h"
 #include "xmpmeta/xmp_parser.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/property_scanner.h"
+#include "xmpmeta/xml/property_set.h"
 #include "xmpmeta/xml/serializer.h"
 #include "xmpmeta/xml/utils.h"
 
 using xmpmeta::PanoMetaData;
 using xmpmeta::xml::DeserializerImpl;
 using xmpmeta::xml::GetFirstDescriptionElement;
+using xmpmeta::xml::PropertySet;
 using xmpmeta::xml::ToXmlChar;
 using xmpmeta::xml::XmlConst;
 
@@ -45,10 +50,9 @@ const char kPoseHeadingDegrees[] = "PoseHeadingDegrees";
 const char kProjectionType[] = "ProjectionType";
 const char kUsePanoramaViewer[] = "UsePanoramaViewer";
 
-// Extracts metadata from xmp.
-bool ParseGPanoFields(const XmpData& xmp, PanoMetaData* meta_data) {
-  DeserializerImpl std_deserializer(
-      GetFirstDescriptionElement(xmp.StandardSection()));
+// Extracts metadata from the given GPano properties.
+bool ParseGPanoFields(const PropertySet& std_deserializer,
+                      PanoMetaData* meta_data) {
   if (!std_deserializer.ParseInt(kPrefix, kCroppedAreaLeftPixels,
                                  &meta_data->cropped_left)) {
     return false;
@@ -101,6 +105,36 @@ bool ParseGPanoFields(const XmpData& xmp, PanoMetaData* meta_data) {
   return true;
 }
 
+// The GPano properties read by ParseGPanoFields.
+const char* const kPropertyNames[] = {
+    kCroppedAreaLeftPixels,
+    kCroppedAreaTopPixels,
+    kCroppedAreaImageWidthPixels,
+    kCroppedAreaImageHeightPixels,
+    kFullPanoWidthPixels,
+    kFullPanoHeightPixels,
+    kInitialViewHeadingDegrees,
+    kFullPanoWidthPixelsDeprecated,
+    kFullPanoHeightPixelsDeprecated,
+    kPoseHeadingDegrees,
+    kProjectionType,
+    kUsePanoramaViewer};
+
+// Extracts metadata from xmp, reading all the properties in one pass.
+bool ParseGPanoFields(const XmpData& xmp, PanoMetaData* meta_data) {
+  DeserializerImpl std_deserializer(
+      GetFirstDescriptionElement(xmp.StandardSection()));
+  PropertySet properties(kPropertyNames);
+  if (!std_deserializer.ParseProperties(kPrefix, &properties)) {
+    return false;
+  }
+  return ParseGPanoFields(properties, meta_data);
+}
+
+// Longest property value kept by ScanXmpPacketProperties. No valid value of any GPano
+// property is this long.
+const size_t kMaxValueLength = 32;
+
 }  // namespace
 
 GPano::GPano() {}
@@ -129,12 +163,44 @@ std::unique_ptr<GPano> GPano::FromXmp(const XmpData& xmp) {
 }
 
 std::unique_ptr<GPano> GPano::FromJpegFile(const string& filename) {
-  XmpData xmp;
-  const bool kSkipExtended = true;
-  if (!ReadXmpHeader(filename, kSkipExtended, &xmp)) {
+  if (!HasJpegExtension(filename)) {
+    LOG(WARNING) << "XMP parse: only JPEG file is supported";
+    return nullptr;
+  }
+  std::unique_ptr<MemoryMappedFile> file = MemoryMappedFile::FromFile(filename);
+  if (file == nullptr) {
+    LOG(WARNING) << "Could not read file: " << filename;
     return nullptr;
   }
-  return FromXmp(xmp);
+  std::unique_ptr<GPano> gpano(new GPano());
+  const bool success =
+      ReadPanoMetaData(file->data(), file->size(), &gpano->meta_data_);
+  return success ? std::move(gpano) : nullptr;
+}
+
+bool GPano::ReadPanoMetaData(const uint8* buffer, size_t size,
+                             PanoMetaData* meta_data) {
+  const char* xmp_packet;
+  size_t length;
+  if (!FindStandardXmpPacket(buffer, size, &xmp_packet, &length)) {
+    return false;
+  }
+  return ParsePanoMetaData(xmp_packet, length, meta_data);
+}
+
+bool GPano::ParsePanoMetaData(const char* xmp_packet, size_t length,
+                              PanoMetaData* meta_data) {
+  PropertySet properties(kPropertyNames);
+  if (!xml::ScanXmpPacketProperties(xmp_packet, length, kPrefix,
+                                    kMaxValueLength, &properties)) {
+    return false;
+  }
+  PanoMetaData scanned_meta_data;
+  if (!ParseGPanoFields(properties, &scanned_meta_data)) {
+    return false;
+  }
+  *meta_data = scanned_meta_data;
+  return true;
 }
 
 bool GPano::Serialize(xml::Serializer* serializer) const {
@@ -148,14 +214,14 @@ bool GPano::Serialize(xml::Serializer* serializer,
     return false;
   }
 
-  const string cropped_left_str = std::to_string(meta_data_.cropped_left);
-  const string cropped_top_str = std::to_string(meta_data_.cropped_top);
-  const string cropped_width_str = std::to_string(meta_data_.cropped_width);
-  const string cropped_height_str = std::to_string(meta_data_.cropped_height);
-  const string full_width_str = std::to_string(meta_data_.full_width);
-  const string full_height_str = std::to_string(meta_data_.full_height);
+  const string cropped_left_str = SimpleItoa(meta_data_.cropped_left);
+  const string cropped_top_str = SimpleItoa(meta_data_.cropped_top);
+  const string cropped_width_str = SimpleItoa(meta_data_.cropped_width);
+  const string cropped_height_str = SimpleItoa(meta_data_.cropped_height);
+  const string full_width_str = SimpleItoa(meta_data_.full_width);
+  const string full_height_str = SimpleItoa(meta_data_.full_height);
   const string init_heading_degrees_str =
-      std::to_string(meta_data_.initial_heading_degrees);
+      SimpleItoa(meta_data_.initial_heading_degrees);
 
   // Short-circuiting ensures that serialization halts at the first error if any
   // occurs.
@@ -178,7 +244,7 @@ bool GPano::Serialize(xml::Serializer* serializer,
 
   if (write_optional_photo_sphere_meta) {
     const string pose_heading_degrees_str =
-        std::to_string(meta_data_.pose_heading_degrees);
+        SimpleItoa(meta_data_.pose_heading_degrees);
     const string projection_type_str = meta_data_.projection_type.ToString();
     const string use_panorama_viewer_str =
         meta_data_.use_panorama_viewer ? "True" : "False";
@@ -14,8 +14,10 @@
 
 #include "xmpmeta/gpano.h"
 
+#include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <libxml/tree.h>
 
@@ -77,6 +79,18 @@ TEST(GPano, BadPath) {
   ASSERT_EQ(nullptr, gpano);
 }
 
+TEST(GPano, FromJpegFileRequiresJpegExtension) {
+  ExpectOnlyJpegExtensionRead(
+      "left_with_xmp.jpg", "gpano_left", [](const string& path) {
+        return GPano::FromJpegFile(path) != nullptr;
+      });
+  ExpectOnlyJpegExtensionRead(
+      "left_with_xmp.jpg", "xmp_header_left", [](const string& path) {
+        XmpData xmp_data;
+        return ReadXmpHeader(path, true, &xmp_data);
+      });
+}
+
 TEST(GPano, ToVrPhotoXmp) {
   PanoMetaData new_meta_data;
   new_meta_data.cropped_left = kCroppedLeft;
@@ -145,5 +159,139 @@ TEST(GPano, ParseXmpTest) {
   }
 }
 
+TEST(GPano, ReadPanoMetaDataMatchesFromXmp) {
+  const std::vector<string> data_paths = {
+      TestFileAbsolutePath("vr_photo_with_audio_std_section_data.txt"),
+      TestFileAbsolutePath("vr_photo_no_audio_std_section_data.txt"),
+      TestFileAbsolutePath("photo_sphere_std_section_data.txt")};
+
+  for (const string& data_path : data_paths) {
+    std::string xmp_body;
+    ReadFileToStringOrDie(data_path, &xmp_body);
+    std::vector<string> standard_xmp;
+    standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(xmp_body));
+    const string jpeg = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+    const uint8* buffer = reinterpret_cast<const uint8*>(jpeg.data());
+
+    XmpData xmp_data;
+    ASSERT_TRUE(ReadXmpFromMemory(jpeg, true, &xmp_data));
+    std::unique_ptr<GPano> gpano_from_xmp = GPano::FromXmp(xmp_data);
+    ASSERT_NE(nullptr, gpano_from_xmp) << data_path;
+    const PanoMetaData& expected = gpano_from_xmp->GetPanoMetaData();
+
+    PanoMetaData meta_data;
+    ASSERT_TRUE(GPano::ReadPanoMetaData(buffer, jpeg.size(), &meta_data))
+        << data_path;
+    EXPECT_EQ(expected.cropped_left, meta_data.cropped_left);
+    EXPECT_EQ(expected.cropped_top, meta_data.cropped_top);
+    EXPECT_EQ(expected.cropped_width, meta_data.cropped_width);
+    EXPECT_EQ(expected.cropped_height, meta_data.cropped_height);
+    EXPECT_EQ(expected.full_width, meta_data.full_width);
+    EXPECT_EQ(expected.full_height, meta_data.full_height);
+    EXPECT_EQ(expected.initial_heading_degrees,
+              meta_data.initial_heading_degrees);
+    EXPECT_EQ(expected.pose_heading_degrees, meta_data.pose_heading_degrees);
+    EXPECT_EQ(expected.projection_type.ToString(),
+              meta_data.projection_type.ToString());
+    EXPECT_EQ(expected.use_panorama_viewer, meta_data.use_panorama_viewer);
+  }
+}
+
+TEST(GPano, ParsePanoMetaDataFromElements) {
+  // Properties may be written as elements as well as attributes, including
+  // the deprecated full pano dimensions.
+  const string xmp_packet =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description rdf:about=\"\""
+      " xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\""
+      " GPano:CroppedAreaLeftPixels=\"2420\""
+      " GPano:CroppedAreaTopPixels=\"1396\">"
+      "<GPano:CroppedAreaImageWidthPixels>3782"
+      "</GPano:CroppedAreaImageWidthPixels>"
+      "<GPano:CroppedAreaImageHeightPixels> 1566 "
+      "</GPano:CroppedAreaImageHeightPixels>"
+      "<GPano:FullPanoImageWidthPixels>8192</GPano:FullPanoImageWidthPixels>"
+      "<GPano:FullPanoImageHeightPixels>4096</GPano:FullPanoImageHeightPixels>"
+      "<GPano:UsePanoramaViewer>False</GPano:UsePanoramaViewer>"
+      "</rdf:Description>"
+      "<rdf:Description GPano:PoseHeadingDegrees=\"90\""
+      " xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\"/>"
+      "</rdf:RDF>"
+      "</x:xmpmeta>";
+
+  PanoMetaData meta_data;
+  ASSERT_TRUE(GPano::ParsePanoMetaData(xmp_packet.data(), xmp_packet.size(),
+                                       &meta_data));
+  EXPECT_EQ(kCroppedLeft, meta_data.cropped_left);
+  EXPECT_EQ(kCroppedTop, meta_data.cropped_top);
+  EXPECT_EQ(kCroppedWidth, meta_data.cropped_width);
+  EXPECT_EQ(kCroppedHeight, meta_data.cropped_height);
+  EXPECT_EQ(kFullWidth, meta_data.full_width);
+  EXPECT_EQ(kFullHeight, meta_data.full_height);
+  // Not given, so set to the center of the cropped panorama.
+  EXPECT_EQ((kCroppedLeft + kCroppedWidth / 2) * 360 / kFullWidth,
+            meta_data.initial_heading_degrees);
+  EXPECT_FALSE(meta_data.use_panorama_viewer);
+  // Only the first rdf:Description is read.
+  EXPECT_EQ(0, meta_data.pose_heading_degrees);
+}
+
+TEST(GPano, ParsePanoMetaDataMissingFields) {
+  const string xmp_packet =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description rdf:about=\"\""
+      " xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\""
+      " GPano:CroppedAreaLeftPixels=\"2420\"/>"
+      "</rdf:RDF>"
+      "</x:xmpmeta>";
+  PanoMetaData meta_data;
+  meta_data.cropped_left = 1;
+  EXPECT_FALSE(GPano::ParsePanoMetaData(xmp_packet.data(), xmp_packet.size(),
+                                        &meta_data));
+  EXPECT_EQ(1, meta_data.cropped_left);
+
+  const string not_xml = "GPano:CroppedAreaLeftPixels=\"2420\"";
+  EXPECT_FALSE(
+      GPano::ParsePanoMetaData(not_xml.data(), not_xml.size(), &meta_data));
+}
+
+TEST(GPano, ReadPanoMetaDataMalformedAfterDescription) {
+  // The first rdf:Description is complete, but the packet is not well formed,
+  // so ReadXmpFromMemory rejects it.
+  const string xmp_body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description rdf:about=\"\""
+      " xmlns:GPano=\"http://ns.google.com/photos/1.0/panorama/\""
+      " GPano:CroppedAreaLeftPixels=\"2420\""
+      " GPano:CroppedAreaTopPixels=\"1396\""
+      " GPano:CroppedAreaImageWidthPixels=\"3782\""
+      " GPano:CroppedAreaImageHeightPixels=\"1566\""
+      " GPano:FullPanoWidthPixels=\"8192\""
+      " GPano:FullPanoHeightPixels=\"4096\"/>"
+      "<rdf:Description></rdf:Descriptio>"
+      "</rdf:RDF>"
+      "</x:xmpmeta>";
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(xmp_body));
+  const string jpeg = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+  XmpData xmp_data;
+  EXPECT_FALSE(ReadXmpFromMemory(jpeg, true, &xmp_data));
+
+  PanoMetaData meta_data;
+  EXPECT_FALSE(GPano::ReadPanoMetaData(
+      reinterpret_cast<const uint8*>(jpeg.data()), jpeg.size(), &meta_data));
+
+  // The same packet without the malformed element is read.
+  string valid_body = xmp_body;
+  valid_body.erase(valid_body.find("<rdf:Description></rdf:Descriptio>"),
+                   strlen("<rdf:Description></rdf:Descriptio>"));
+  EXPECT_TRUE(GPano::ParsePanoMetaData(valid_body.data(), valid_body.size(),
+                                       &meta_data));
+  EXPECT_EQ(kFullWidth, meta_data.full_width);
+}
+
 }  // namespace
 }  // namespace xmpmeta
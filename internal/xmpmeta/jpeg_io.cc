@@ -14,6 +14,7 @@
 
 #include "xmpmeta/jpeg_io.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -57,6 +58,17 @@ size_t GetBytesAvailable(std::istream* input_stream) {
   return end - pos;
 }
 
+// Reads the rest of the stream into data, without seeking. Returns false if
+// the stream could not be read.
+bool ReadToEnd(std::istream* input_stream, string* data) {
+  char buffer[4096];
+  while (input_stream->read(buffer, sizeof(buffer)) ||
+         input_stream->gcount() > 0) {
+    data->append(buffer, input_stream->gcount());
+  }
+  return !input_stream->bad();
+}
+
 // Returns the first byte in the stream cast to an integer.
 int ReadByteAsInt(std::istream* input_stream) {
   unsigned char byte;
@@ -87,6 +99,140 @@ bool HasPrefixString(const string& to_check, const string& prefix) {
   return std::equal(prefix.begin(), prefix.end(), to_check.begin());
 }
 
+bool HasPrefixString(const char* data, size_t size, const string& prefix) {
+  if (size < prefix.size()) {
+    return false;
+  }
+  return std::equal(prefix.begin(), prefix.end(), data);
+}
+
+// Number of bytes read ahead from a ByteSource, so that the headers of
+// consecutive small sections are fetched together.
+const size_t kReadAheadSize = 4096;
+
+// Reads from a ByteSource through a read-ahead block, recording the ranges
+// that are fetched from the source.
+class ReadAheadReader {
+ public:
+  ReadAheadReader(ByteSource* source, std::vector<ByteRange>* fetched_ranges)
+      : source_(source), fetched_ranges_(fetched_ranges), block_offset_(0) {}
+
+  // Reads length bytes starting at offset into output. Returns false if they
+  // could not all be read.
+  bool Read(size_t offset, size_t length, char* output) {
+    while (length > 0) {
+      if (offset >= block_offset_ && offset - block_offset_ < block_.size()) {
+        const size_t num_copied =
+            std::min(length, block_.size() - (offset - block_offset_));
+        std::copy_n(&block_[offset - block_offset_], num_copied, output);
+        offset += num_copied;
+        output += num_copied;
+        length -= num_copied;
+        continue;
+      }
+      // Large reads bypass the read-ahead block.
+      if (length >= kReadAheadSize) {
+        return Fetch(offset, length, output) == length;
+      }
+      if (offset >= source_->Size()) {
+        return false;
+      }
+      block_.resize(std::min(kReadAheadSize, source_->Size() - offset));
+      block_.resize(Fetch(offset, block_.size(), &block_[0]));
+      block_offset_ = offset;
+      if (block_.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Reads from the source and records the range that was read.
+  size_t Fetch(size_t offset, size_t length, char* output) {
+    const size_t num_read = source_->ReadAt(offset, length, output);
+    if (fetched_ranges_ != nullptr && num_read > 0) {
+      if (!fetched_ranges_->empty() &&
+          fetched_ranges_->back().offset + fetched_ranges_->back().length ==
+              offset) {
+        fetched_ranges_->back().length += num_read;
+      } else {
+        ByteRange range;
+        range.offset = offset;
+        range.length = num_read;
+        fetched_ranges_->push_back(range);
+      }
+    }
+    return num_read;
+  }
+
+  ByteSource* source_;
+  std::vector<ByteRange>* fetched_ranges_;
+  string block_;
+  size_t block_offset_;
+};
+
+// Appends the locations of the sections in the stream, which holds size bytes
+// of JPEG data, to sections.
+void IndexStreamSections(size_t size, std::istream* input_stream,
+                         std::vector<SectionIndex>* sections) {
+  if (size < 2 || ReadByteAsInt(input_stream) != 0xff ||
+      ReadByteAsInt(input_stream) != kSoi) {
+    LOG(WARNING) << "File's first two bytes does not match the sequence \xff"
+                 << kSoi;
+    return;
+  }
+
+  size_t position = 2;
+  int chr;  // Short for character.
+  while ((chr = ReadByteAsInt(input_stream)) != -1) {
+    ++position;
+    if (chr != 0xff) {
+      LOG(WARNING) << "Read non-padding byte: " << chr;
+      return;
+    }
+    // Skip padding bytes.
+    while ((chr = ReadByteAsInt(input_stream)) == 0xff) {
+      ++position;
+    }
+    if (chr == -1) {
+      LOG(WARNING) << "No more bytes in file available to be read.";
+      return;
+    }
+    ++position;
+
+    SectionIndex section;
+    section.marker = chr;
+    if (section.IsImageSection()) {
+      section.file_offset = position;
+      section.length = size - position;
+      sections->push_back(section);
+      return;
+    }
+
+    bool error;
+    const size_t length = Read2ByteLength(input_stream, &error);
+    if (error || length < kSectionLengthByteSize) {
+      LOG(WARNING) << "No sections to read; section length is " << length;
+      return;
+    }
+    position += kSectionLengthByteSize;
+
+    const size_t data_size = length - kSectionLengthByteSize;
+    if (data_size > size - position) {
+      LOG(WARNING) << "Invalid section length = " << length
+                   << " total bytes available = " << size - position;
+      return;
+    }
+    section.file_offset = position;
+    section.length = data_size;
+    sections->push_back(section);
+
+    input_stream->seekg(data_size, std::ios::cur);
+    position += data_size;
+  }
+}
+
 }  // namespace
 
 Section::Section(const string& buffer) {
@@ -99,6 +245,18 @@ bool Section::IsMarkerApp1() {
   return marker == kApp1;
 }
 
+bool SectionView::IsMarkerApp1() const {
+  return marker == kApp1;
+}
+
+bool SectionIndex::IsMarkerApp1() const {
+  return marker == kApp1;
+}
+
+bool SectionIndex::IsImageSection() const {
+  return marker == kSos;
+}
+
 std::vector<Section> Parse(const ParseOptions& options,
                            std::istream* input_stream) {
   std::vector<Section> sections;
@@ -132,10 +290,7 @@ std::vector<Section> Parse(const ParseOptions& options,
         Section section;
         section.marker = marker;
         section.is_image_section = true;
-        const size_t bytes_available = GetBytesAvailable(input_stream);
-        section.data.resize(bytes_available);
-        input_stream->read(&section.data[0], bytes_available);
-        if (input_stream->good()) {
+        if (ReadToEnd(input_stream, &section.data)) {
           sections.push_back(section);
         }
       }
@@ -151,13 +306,9 @@ std::vector<Section> Parse(const ParseOptions& options,
       return sections;
     }
 
-    const size_t bytes_left = GetBytesAvailable(input_stream);
-    if (length - kSectionLengthByteSize > bytes_left) {
-      LOG(WARNING) << "Invalid section length = " << length
-                   << " total bytes available = " << bytes_left;
-      return sections;
-    }
-
+    // The length is trusted rather than checked against the stream size, so
+    // that streams which cannot seek, such as pipes, can be parsed. A
+    // truncated section fails to be read instead.
     if (!options.read_meta_only || marker == kApp1) {
       Section section;
       section.marker = marker;
@@ -170,8 +321,13 @@ std::vector<Section> Parse(const ParseOptions& options,
         return sections;
       }
       input_stream->read(&section.data[0], section.data.size());
-      if (input_stream->good() && (options.section_header.empty() ||
-            HasPrefixString(section.data, options.section_header))) {
+      if (!input_stream->good()) {
+        LOG(WARNING) << "Invalid section length = " << length
+                     << "; the stream ended before the section";
+        return sections;
+      }
+      if (options.section_header.empty() ||
+          HasPrefixString(section.data, options.section_header)) {
         sections.push_back(section);
         // Return if we have specified to return the 1st section with
         // the given name.
@@ -187,21 +343,266 @@ std::vector<Section> Parse(const ParseOptions& options,
   return sections;
 }
 
+std::vector<SectionView> ParseSectionViews(const ParseOptions& options,
+                                           const uint8* buffer, size_t size) {
+  std::vector<SectionView> sections;
+  // Return early if this is not the start of a JPEG section.
+  if (buffer == nullptr || size < 2 || buffer[0] != 0xff || buffer[1] != kSoi) {
+    LOG(WARNING) << "File's first two bytes does not match the sequence \xff"
+                 << kSoi;
+    return sections;
+  }
+
+  size_t position = 2;
+  while (position < size) {
+    if (buffer[position] != 0xff) {
+      LOG(WARNING) << "Read non-padding byte: "
+                   << static_cast<int>(buffer[position]);
+      return sections;
+    }
+    // Skip padding bytes.
+    while (++position < size && buffer[position] == 0xff) {
+    }
+    if (position == size) {
+      LOG(WARNING) << "No more bytes in file available to be read.";
+      return sections;
+    }
+
+    const int marker = buffer[position++];
+    if (marker == kSos) {
+      // kSos indicates the image data will follow and no metadata after that,
+      // so the rest of the buffer is the image section.
+      if (!options.read_meta_only) {
+        SectionView section;
+        section.marker = marker;
+        section.is_image_section = true;
+        section.offset = position;
+        section.length = size - position;
+        section.data = reinterpret_cast<const char*>(buffer + position);
+        sections.push_back(section);
+      }
+      // All sections have been read.
+      return sections;
+    }
+
+    if (size - position < kSectionLengthByteSize) {
+      LOG(WARNING) << "No sections to read; section length is missing";
+      return sections;
+    }
+    const size_t length = buffer[position] << 8 | buffer[position + 1];
+    position += kSectionLengthByteSize;
+    if (length < kSectionLengthByteSize) {
+      LOG(WARNING) << "No sections to read; section length is " << length;
+      return sections;
+    }
+
+    const size_t data_size = length - kSectionLengthByteSize;
+    if (data_size > size - position) {
+      LOG(WARNING) << "Invalid section length = " << length
+                   << " total bytes available = " << size - position;
+      return sections;
+    }
+
+    if (!options.read_meta_only || marker == kApp1) {
+      SectionView section;
+      section.marker = marker;
+      section.is_image_section = false;
+      section.offset = position;
+      section.length = data_size;
+      section.data = reinterpret_cast<const char*>(buffer + position);
+      if (options.section_header.empty() ||
+          HasPrefixString(section.data, section.length,
+                          options.section_header)) {
+        sections.push_back(section);
+        // Return if we have specified to return the 1st section with
+        // the given name.
+        if (options.section_header_return_first) {
+          return sections;
+        }
+      }
+    }
+    // Sections that are not kept are skipped, since all EXIF/XMP meta will be
+    // in kApp1 sections.
+    position += data_size;
+  }
+  return sections;
+}
+
+std::vector<Section> Parse(const ParseOptions& options, ByteSource* source,
+                           std::vector<ByteRange>* fetched_ranges) {
+  std::vector<Section> sections;
+  ReadAheadReader reader(source, fetched_ranges);
+  const size_t size = source->Size();
+  char bytes[2];
+  // Return early if this is not the start of a JPEG section.
+  if (!reader.Read(0, 2, bytes) || bytes[0] != '\xff' ||
+      static_cast<uint8>(bytes[1]) != kSoi) {
+    LOG(WARNING) << "File's first two bytes does not match the sequence \xff"
+                 << kSoi;
+    return sections;
+  }
+
+  size_t position = 2;
+  char chr;  // Short for character.
+  while (reader.Read(position, 1, &chr)) {
+    ++position;
+    if (chr != '\xff') {
+      LOG(WARNING) << "Read non-padding byte: "
+                   << static_cast<int>(static_cast<uint8>(chr));
+      return sections;
+    }
+    // Skip padding bytes.
+    bool has_marker;
+    while ((has_marker = reader.Read(position, 1, &chr)) && chr == '\xff') {
+      ++position;
+    }
+    if (!has_marker) {
+      LOG(WARNING) << "No more bytes in file available to be read.";
+      return sections;
+    }
+    ++position;
+
+    const int marker = static_cast<uint8>(chr);
+    if (marker == kSos) {
+      // kSos indicates the image data will follow and no metadata after that,
+      // so read all data at one time.
+      if (!options.read_meta_only) {
+        Section section;
+        section.marker = marker;
+        section.is_image_section = true;
+        section.data.resize(size - position);
+        if (section.data.empty() ||
+            reader.Read(position, section.data.size(), &section.data[0])) {
+          sections.push_back(section);
+        }
+      }
+      // All sections have been read.
+      return sections;
+    }
+
+    if (!reader.Read(position, kSectionLengthByteSize, bytes)) {
+      LOG(WARNING) << "No sections to read; section length is missing";
+      return sections;
+    }
+    const size_t length =
+        static_cast<uint8>(bytes[0]) << 8 | static_cast<uint8>(bytes[1]);
+    position += kSectionLengthByteSize;
+    if (length < kSectionLengthByteSize) {
+      LOG(WARNING) << "No sections to read; section length is " << length;
+      return sections;
+    }
+
+    const size_t data_size = length - kSectionLengthByteSize;
+    if (data_size > size - position) {
+      LOG(WARNING) << "Invalid section length = " << length
+                   << " total bytes available = " << size - position;
+      return sections;
+    }
+
+    if (!options.read_meta_only || marker == kApp1) {
+      Section section;
+      section.marker = marker;
+      section.is_image_section = false;
+      // Check the header before fetching the rest of the section.
+      const size_t header_size =
+          std::min(options.section_header.size(), data_size);
+      section.data.resize(header_size);
+      if (header_size > 0 &&
+          !reader.Read(position, header_size, &section.data[0])) {
+        return sections;
+      }
+      if (options.section_header.empty() ||
+          HasPrefixString(section.data, options.section_header)) {
+        section.data.resize(data_size);
+        if (data_size > header_size &&
+            !reader.Read(position + header_size, data_size - header_size,
+                         &section.data[header_size])) {
+          return sections;
+        }
+        sections.push_back(section);
+        // Return if we have specified to return the 1st section with
+        // the given name.
+        if (options.section_header_return_first) {
+          return sections;
+        }
+      }
+    }
+    // Sections that are not kept are skipped, since all EXIF/XMP meta will be
+    // in kApp1 sections.
+    position += data_size;
+  }
+  return sections;
+}
+
+std::vector<SectionIndex> IndexSections(std::istream* input_stream) {
+  std::vector<SectionIndex> sections;
+  const std::streamoff start = input_stream->tellg();
+  if (start == -1) {
+    return sections;
+  }
+  // Compute the size once, rather than seeking to the end for every section.
+  const size_t size = GetBytesAvailable(input_stream);
+  IndexStreamSections(size, input_stream, &sections);
+  input_stream->clear();
+  input_stream->seekg(start);
+  return sections;
+}
+
+std::vector<SectionIndex> IndexSections(const uint8* buffer, size_t size) {
+  const std::vector<SectionView> views =
+      ParseSectionViews(ParseOptions(), buffer, size);
+  std::vector<SectionIndex> sections(views.size());
+  for (size_t i = 0; i < views.size(); ++i) {
+    sections[i].marker = views[i].marker;
+    sections[i].file_offset = views[i].offset;
+    sections[i].length = views[i].length;
+  }
+  return sections;
+}
+
+bool ReadSectionData(const SectionIndex& section, std::istream* input_stream,
+                     string* data) {
+  const std::streamoff start = input_stream->tellg();
+  if (start == -1) {
+    return false;
+  }
+  data->resize(section.length);
+  input_stream->seekg(start + static_cast<std::streamoff>(section.file_offset));
+  if (section.length > 0) {
+    input_stream->read(&(*data)[0], section.length);
+  }
+  const bool success = input_stream->good();
+  input_stream->clear();
+  input_stream->seekg(start);
+  return success;
+}
+
+string GetStartOfImageMarker() {
+  string marker(2, '\xff');
+  marker[1] = static_cast<char>(kSoi);
+  return marker;
+}
+
+string GetSectionHeader(int marker, bool is_image_section, size_t length) {
+  string header(2, '\xff');
+  header[1] = static_cast<char>(marker);
+  if (!is_image_section) {
+    // It's not the image data.
+    const size_t section_length = length + kSectionLengthByteSize;
+    header.push_back(static_cast<char>((section_length >> 8) & 0xff));
+    header.push_back(static_cast<char>(section_length & 0xff));
+  }
+  return header;
+}
+
 void WriteSections(const std::vector<Section>& sections,
                    std::ostream* output_stream) {
-  output_stream->put(0xff);
-  output_stream->put(kSoi);
+  const string start_of_image = GetStartOfImageMarker();
+  output_stream->write(start_of_image.data(), start_of_image.size());
   for (const Section& section : sections) {
-    output_stream->put(0xff);
-    output_stream->put(section.marker);
-    if (!section.is_image_section) {
-      const int section_length = static_cast<int>(section.data.length()) + 2;
-      // It's not the image data.
-      const int lh = section_length >> 8;
-      const int ll = section_length & 0xff;
-      output_stream->put(lh);
-      output_stream->put(ll);
-    }
+    const string header = GetSectionHeader(
+        section.marker, section.is_image_section, section.data.length());
+    output_stream->write(header.data(), header.size());
     output_stream->write(section.data.c_str(), section.data.length());
   }
 }
@@ -15,6 +15,10 @@
 #include "xmpmeta/jpeg_io.h"
 
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <streambuf>
 #include <string>
 #include <vector>
 
@@ -28,6 +32,18 @@
 namespace xmpmeta {
 namespace {
 
+// A stream buffer over a string that cannot seek, like that of a pipe.
+class ForwardOnlyStreamBuf : public std::streambuf {
+ public:
+  explicit ForwardOnlyStreamBuf(const string& data) : data_(data) {
+    char* begin = &data_[0];
+    setg(begin, begin, begin + data_.size());
+  }
+
+ private:
+  string data_;
+};
+
 // Test file paths.
 const char* kJpegTestDataPath = "left_with_xmp.jpg";
 
@@ -203,5 +219,247 @@ TEST(JpegIO, ParseJpegWithExtendedXmpReadEverything) {
   EXPECT_TRUE(sections.at(sections.size() - 1).is_image_section);
 }
 
+TEST(JpegIO, ParseSectionViewsExtendedXmp) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+  const uint8* buffer = reinterpret_cast<const uint8*>(contents.data());
+
+  ParseOptions parse_options;
+  parse_options.read_meta_only = true;
+  const std::vector<SectionView> sections =
+      ParseSectionViews(parse_options, buffer, contents.size());
+  ASSERT_EQ(3u, sections.size());
+  for (size_t i = 0; i < sections.size(); ++i) {
+    EXPECT_TRUE(sections[i].IsMarkerApp1());
+    EXPECT_FALSE(sections[i].is_image_section);
+    // Views point into the parsed buffer rather than into a copy.
+    EXPECT_EQ(contents.data() + sections[i].offset, sections[i].data);
+    EXPECT_EQ(xmp_sections[i],
+              string(sections[i].data, sections[i].length));
+  }
+}
+
+TEST(JpegIO, ParseSectionViewsWithSectionHeader) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+  const uint8* buffer = reinterpret_cast<const uint8*>(contents.data());
+
+  ParseOptions parse_options;
+  parse_options.read_meta_only = true;
+  parse_options.section_header = XmpConst::ExtensionHeader();
+  EXPECT_EQ(2u,
+            ParseSectionViews(parse_options, buffer, contents.size()).size());
+
+  parse_options.section_header_return_first = true;
+  EXPECT_EQ(1u,
+            ParseSectionViews(parse_options, buffer, contents.size()).size());
+}
+
+TEST(JpegIO, ParseSectionViewsReadEverything) {
+  string contents;
+  ReadFileToStringOrDie(TestFileAbsolutePath(kJpegTestDataPath), &contents);
+  std::ifstream file(TestFileAbsolutePath(kJpegTestDataPath).c_str(),
+                     std::ios::binary);
+  ASSERT_TRUE(file.is_open());
+
+  ParseOptions parse_options;
+  const std::vector<Section> expected = Parse(parse_options, &file);
+  const std::vector<SectionView> sections = ParseSectionViews(
+      parse_options, reinterpret_cast<const uint8*>(contents.data()),
+      contents.size());
+  ASSERT_EQ(expected.size(), sections.size());
+  for (size_t i = 0; i < sections.size(); ++i) {
+    EXPECT_EQ(expected[i].marker, sections[i].marker);
+    EXPECT_EQ(expected[i].is_image_section, sections[i].is_image_section);
+    EXPECT_EQ(expected[i].data, string(sections[i].data, sections[i].length));
+  }
+  EXPECT_TRUE(sections.back().is_image_section);
+}
+
+TEST(JpegIO, ParseSectionViewsTruncatedSection) {
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+
+  ParseOptions parse_options;
+  parse_options.read_meta_only = true;
+  // Cut the buffer off in the middle of the XMP section.
+  EXPECT_TRUE(ParseSectionViews(parse_options,
+                                reinterpret_cast<const uint8*>(contents.data()),
+                                contents.size() / 2).empty());
+  EXPECT_TRUE(ParseSectionViews(parse_options, nullptr, 0).empty());
+}
+
+TEST(JpegIO, IndexSectionsFromStream) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+  std::istringstream stream(contents);
+
+  const std::vector<SectionIndex> sections = IndexSections(&stream);
+  // Three XMP sections and the image section.
+  ASSERT_EQ(4u, sections.size());
+  EXPECT_EQ(0, stream.tellg());
+  for (size_t i = 0; i < xmp_sections.size(); ++i) {
+    EXPECT_TRUE(sections[i].IsMarkerApp1());
+    EXPECT_FALSE(sections[i].IsImageSection());
+    EXPECT_EQ(xmp_sections[i],
+              contents.substr(sections[i].file_offset, sections[i].length));
+    string data;
+    ASSERT_TRUE(ReadSectionData(sections[i], &stream, &data));
+    EXPECT_EQ(xmp_sections[i], data);
+  }
+  const SectionIndex& image_section = sections.back();
+  EXPECT_TRUE(image_section.IsImageSection());
+  EXPECT_EQ(contents.size(), image_section.file_offset + image_section.length);
+}
+
+TEST(JpegIO, IndexSectionsMatchesParse) {
+  string contents;
+  ReadFileToStringOrDie(TestFileAbsolutePath(kJpegTestDataPath), &contents);
+  std::ifstream file(TestFileAbsolutePath(kJpegTestDataPath).c_str(),
+                     std::ios::binary);
+  ASSERT_TRUE(file.is_open());
+
+  const std::vector<SectionIndex> sections = IndexSections(&file);
+  const std::vector<SectionIndex> buffer_sections = IndexSections(
+      reinterpret_cast<const uint8*>(contents.data()), contents.size());
+  const std::vector<Section> expected = Parse(ParseOptions(), &file);
+  ASSERT_EQ(expected.size(), sections.size());
+  ASSERT_EQ(expected.size(), buffer_sections.size());
+  for (size_t i = 0; i < sections.size(); ++i) {
+    EXPECT_EQ(expected[i].marker, sections[i].marker);
+    EXPECT_EQ(expected[i].is_image_section, sections[i].IsImageSection());
+    EXPECT_EQ(expected[i].data.size(), sections[i].length);
+    EXPECT_EQ(sections[i].file_offset, buffer_sections[i].file_offset);
+    EXPECT_EQ(sections[i].length, buffer_sections[i].length);
+  }
+}
+
+TEST(JpegIO, IndexSectionsTruncatedSection) {
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+  std::istringstream stream(contents.substr(0, contents.size() / 2));
+  EXPECT_TRUE(IndexSections(&stream).empty());
+}
+
+TEST(JpegIO, ParseByteSourceMatchesParse) {
+  string contents;
+  ReadFileToStringOrDie(TestFileAbsolutePath(kJpegTestDataPath), &contents);
+  std::istringstream stream(contents);
+  const std::vector<Section> expected = Parse(ParseOptions(), &stream);
+
+  std::unique_ptr<ByteSource> source = ByteSource::FromMemory(
+      reinterpret_cast<const uint8*>(contents.data()), contents.size());
+  std::vector<ByteRange> fetched_ranges;
+  const std::vector<Section> sections =
+      Parse(ParseOptions(), source.get(), &fetched_ranges);
+  ASSERT_EQ(expected.size(), sections.size());
+  for (size_t i = 0; i < sections.size(); ++i) {
+    EXPECT_EQ(expected[i].marker, sections[i].marker);
+    EXPECT_EQ(expected[i].is_image_section, sections[i].is_image_section);
+    EXPECT_EQ(expected[i].data, sections[i].data);
+  }
+  // Everything was read, once.
+  ASSERT_EQ(1u, fetched_ranges.size());
+  EXPECT_EQ(0u, fetched_ranges[0].offset);
+  EXPECT_EQ(contents.size(), fetched_ranges[0].length);
+}
+
+TEST(JpegIO, ParseByteSourceFetchesOnlyMetadata) {
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  string contents = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+  // Make the image data large enough to be skipped by read-ahead.
+  contents.append(100000, '\0');
+
+  std::unique_ptr<ByteSource> source = ByteSource::FromMemory(
+      reinterpret_cast<const uint8*>(contents.data()), contents.size());
+  ParseOptions parse_options;
+  parse_options.read_meta_only = true;
+  parse_options.section_header = XmpConst::Header();
+  parse_options.section_header_return_first = true;
+  std::vector<ByteRange> fetched_ranges;
+  const std::vector<Section> sections =
+      Parse(parse_options, source.get(), &fetched_ranges);
+  ASSERT_EQ(1u, sections.size());
+  EXPECT_EQ(standard_xmp[0], sections[0].data);
+
+  size_t fetched_size = 0;
+  for (const ByteRange& range : fetched_ranges) {
+    fetched_size += range.length;
+  }
+  EXPECT_LT(fetched_size, 10000);
+}
+
+TEST(JpegIO, ParseByteSourceTruncatedSection) {
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+  std::unique_ptr<ByteSource> source = ByteSource::FromMemory(
+      reinterpret_cast<const uint8*>(contents.data()), contents.size() / 2);
+  EXPECT_TRUE(Parse(ParseOptions(), source.get(), nullptr).empty());
+}
+
+TEST(JpegIO, ParseNonSeekableStream) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+  ForwardOnlyStreamBuf stream_buffer(contents);
+  std::istream stream(&stream_buffer);
+  ASSERT_EQ(-1, stream.tellg());
+
+  const std::vector<Section> sections = Parse(ParseOptions(), &stream);
+  ASSERT_EQ(xmp_sections.size() + 1, sections.size());
+  for (size_t i = 0; i < xmp_sections.size(); ++i) {
+    EXPECT_EQ(xmp_sections[i], sections[i].data);
+  }
+  EXPECT_TRUE(sections.back().is_image_section);
+  EXPECT_EQ(TestXmpCreator::GetFakeJpegPayload().substr(2),
+            sections.back().data);
+}
+
+TEST(JpegIO, ParseNonSeekableStreamStopsAtImageData) {
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+  ForwardOnlyStreamBuf stream_buffer(contents);
+  std::istream stream(&stream_buffer);
+
+  ParseOptions parse_options;
+  parse_options.read_meta_only = true;
+  const std::vector<Section> sections = Parse(parse_options, &stream);
+  ASSERT_EQ(1u, sections.size());
+  EXPECT_EQ(standard_xmp[0], sections[0].data);
+  // Only the start of scan marker was read past the metadata.
+  string rest((std::istreambuf_iterator<char>(&stream_buffer)),
+              std::istreambuf_iterator<char>());
+  EXPECT_EQ(TestXmpCreator::GetFakeJpegPayload().substr(2), rest);
+}
+
+TEST(JpegIO, ParseNonSeekableStreamTruncatedSection) {
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+  ForwardOnlyStreamBuf stream_buffer(contents.substr(0, contents.size() / 2));
+  std::istream stream(&stream_buffer);
+  EXPECT_TRUE(Parse(ParseOptions(), &stream).empty());
+}
+
 }  // namespace
 }  // namespace xmpmeta
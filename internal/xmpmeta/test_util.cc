@@ -39,4 +39,19 @@ std::string TempFileAbsolutePath(const std::string& filename) {
   return JoinPath(FLAGS_test_tmpdir, filename);
 }
 
+void ExpectOnlyJpegExtensionRead(
+    const std::string& test_filename, const std::string& temp_name,
+    const std::function<bool(const std::string&)>& read_file) {
+  std::string contents;
+  ReadFileToStringOrDie(TestFileAbsolutePath(test_filename), &contents);
+  const std::string png_path = TempFileAbsolutePath(temp_name + ".png");
+  WriteStringToFileOrDie(contents, png_path);
+  EXPECT_FALSE(read_file(png_path));
+
+  const std::string upper_case_path =
+      TempFileAbsolutePath(temp_name + ".JPEG");
+  WriteStringToFileOrDie(contents, upper_case_path);
+  EXPECT_TRUE(read_file(upper_case_path));
+}
+
 }  // namespace xmpmeta
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <functional>
 #include <string>
 #include "gtest/gtest.h"
 
@@ -28,6 +29,14 @@ std::string TestFileAbsolutePath(const std::string& filename);
 // local build/testing environment.
 std::string TempFileAbsolutePath(const std::string& filename);
 
+// Copies the given JPEG test file to temporary files with a .png and an upper
+// case .JPEG extension, named after temp_name, and expects read_file to fail
+// on the first and succeed on the second: as for ReadXmpHeader(), only files
+// named .jpg or .jpeg in any case are read.
+void ExpectOnlyJpegExtensionRead(
+    const std::string& test_filename, const std::string& temp_name,
+    const std::function<bool(const std::string&)>& read_file);
+
 }  // namespace xmpmeta
 
 #endif  // XMPMETA_TEST_UTIL_H_
@@ -21,11 +21,15 @@
 
 #include "base/integral_types.h"
 #include "base/port.h"
+#include "xmpmeta/xml/property_set.h"
+#include "xmpmeta/xml/string_ref.h"
 
 namespace xmpmeta {
 namespace xml {
 
 // Performs deserialization.
+// Prefixes and names are passed as StringRef, so string literals and
+// constants are not copied into temporary strings.
 // Example:
 //   Deserializer deserializer();
 //   string revision;
@@ -37,35 +41,50 @@ class Deserializer {
   // Returns a Deserializer.
   // child_name is the name of the next node to deserialize.
   virtual std::unique_ptr<Deserializer> CreateDeserializer(
-      const string& prefix, const string& child_name) const = 0;
+      StringRef prefix, StringRef child_name) const = 0;
 
   // Returns a Deserializer from a list element node.
   virtual std::unique_ptr<Deserializer> CreateDeserializerFromListElementAt(
-      const string& prefix, const string& list_name, int index) const = 0;
+      StringRef prefix, StringRef list_name, int index) const = 0;
+
+  // Returns a Deserializer for each element of a list, in order.
+  // Prefer this to calling CreateDeserializerFromListElementAt for each
+  // index, which looks up the element from the start of the list every time.
+  virtual std::vector<std::unique_ptr<Deserializer>> CreateListDeserializers(
+      StringRef prefix, StringRef list_name) const = 0;
 
   // Parsers for properties with the given prefix.
   // Parses a node such as <NodeName Prefix:Name="Value" />
-  virtual bool ParseBase64(const string& prefix, const string& name,
+  virtual bool ParseBase64(StringRef prefix, StringRef name,
                            string* value) const = 0;
-  virtual bool ParseIntArrayBase64(const string& prefix, const string& name,
+  virtual bool ParseIntArrayBase64(StringRef prefix, StringRef name,
                                    std::vector<int>& values) const = 0;
-  virtual bool ParseFloatArrayBase64(const string& prefix, const string& name,
+  virtual bool ParseFloatArrayBase64(StringRef prefix, StringRef name,
                                      std::vector<float>& values) const = 0;
-  virtual bool ParseBoolean(const string& prefix, const string& name,
+  virtual bool ParseBoolean(StringRef prefix, StringRef name,
                             bool* value) const = 0;
-  virtual bool ParseInt(const string& prefix, const string& name,
+  virtual bool ParseInt(StringRef prefix, StringRef name,
                         int* value) const = 0;
-  virtual bool ParseDouble(const string& prefix, const string& name,
+  virtual bool ParseDouble(StringRef prefix, StringRef name,
                            double* value) const = 0;
-  virtual bool ParseLong(const string& prefix, const string& name,
+  virtual bool ParseLong(StringRef prefix, StringRef name,
                          int64* value) const = 0;
-  virtual bool ParseString(const string& prefix, const string& name,
+  virtual bool ParseString(StringRef prefix, StringRef name,
                            string* value) const = 0;
 
+  // Reads the values of all the properties in the given set, which have the
+  // given prefix, in one pass, and sets the prefix of the set. Properties that
+  // are not found have no value. Values that are held in the document as they
+  // are, as is usual, are referred to rather than copied, so the set must not
+  // outlive the document.
+  // Returns false if there is no node to read from.
+  virtual bool ParseProperties(StringRef prefix,
+                               PropertySet* properties) const = 0;
+
   // Parsers for arrays.
-  virtual bool ParseIntArray(const string& prefix, const string& list_name,
+  virtual bool ParseIntArray(StringRef prefix, StringRef list_name,
                              std::vector<int>* values) const = 0;
-  virtual bool ParseDoubleArray(const string& prefix, const string& list_name,
+  virtual bool ParseDoubleArray(StringRef prefix, StringRef list_name,
                                 std::vector<double>* values) const = 0;
 };
 
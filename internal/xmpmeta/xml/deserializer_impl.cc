@@ -14,13 +14,15 @@
 
 #include "deserializer_impl.h"
 
-#include <algorithm>
+#include <deque>
 
 #include "base/integral_types.h"
 #include "glog/logging.h"
+#include "strings/case.h"
 #include "strings/numbers.h"
 #include "xmpmeta/base64.h"
 #include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/interned_name.h"
 #include "xmpmeta/xml/search.h"
 #include "xmpmeta/xml/utils.h"
 #include "xmpmeta/xmp_parser.h"
@@ -31,27 +33,144 @@ namespace {
 
 // Converts a string to a boolean value if bool_str is one of "false" or "true",
 // regardless of letter casing.
-bool BoolStringToBool(const string& bool_str, bool* value) {
-  string bool_str_lower = bool_str;
-  std::transform(bool_str_lower.begin(), bool_str_lower.end(),
-                 bool_str_lower.begin(), ::tolower);
-  if (bool_str_lower == "true") {
+bool BoolStringToBool(StringRef bool_str, bool* value) {
+  if (strcasecmp(bool_str.c_str(), "true") == 0) {
     *value = true;
     return true;
   }
-  if (bool_str_lower == "false") {
+  if (strcasecmp(bool_str.c_str(), "false") == 0) {
     *value = false;
     return true;
   }
   return false;
 }
 
+// Returns the text of the given list of attribute or element children. A
+// single text node, as is usual, is referred to in place. Other contents, e.g.
+// text split across several nodes or holding entity references, are copied
+// into storage.
+StringRef GetNodeListText(const xmlDocPtr doc, const xmlNodePtr children,
+                          string* storage) {
+  if (children == nullptr) {
+    return StringRef();
+  }
+  if (children->next == nullptr && children->type == XML_TEXT_NODE) {
+    return FromXmlChar(children->content);
+  }
+  xmlChar* text = xmlNodeListGetString(doc, children, 1);
+  *storage = text != nullptr ? FromXmlChar(text) : "";
+  xmlFree(text);
+  return *storage;
+}
+
+// Same as above, but returns the text content of the given element, which
+// includes that of its descendants.
+StringRef GetElementText(const xmlNodePtr element, string* storage) {
+  const xmlNodePtr child = element->children;
+  if (child == nullptr) {
+    return StringRef();
+  }
+  if (child->next == nullptr && child->type == XML_TEXT_NODE) {
+    return FromXmlChar(child->content);
+  }
+  xmlChar* text = xmlNodeGetContent(element);
+  *storage = text != nullptr ? FromXmlChar(text) : "";
+  xmlFree(text);
+  return *storage;
+}
+
+// Sets the value of the property at the given index to text, as returned by
+// GetNodeListText or GetElementText, which is copied only if it is in
+// storage.
+void SetPropertyText(size_t index, StringRef text, const string& storage,
+                     PropertySet* properties) {
+  if (text.data() == storage.c_str()) {
+    properties->SetValue(index, storage);
+  } else {
+    properties->SetValueRef(index, text);
+  }
+}
+
+// Returns the first node in node or its descendants with a matching prefix
+// and name, using the index if there is one.
+xmlNodePtr FindNode(const NodeIndex* index, const xmlNodePtr node,
+                    StringRef prefix, StringRef name) {
+  if (index != nullptr) {
+    return index->Find(node, prefix.data(), name.data());
+  }
+  return DepthFirstSearch(node, prefix.data(), name.data());
+}
+
+// Returns true if the node has the given name and, unless prefix is empty,
+// the given namespace prefix.
+bool NodeNameMatches(const xmlNodePtr node, StringRef prefix, StringRef name) {
+  return InternedName(node->doc, name).Matches(node->name) &&
+         PrefixMatcher(prefix).Matches(node->ns);
+}
+
+// Returns the names of the properties in the given set, looked up in the
+// dictionary of the given document.
+std::vector<InternedName> InternPropertyNames(const xmlDocPtr doc,
+                                              const PropertySet& properties) {
+  std::vector<InternedName> names;
+  names.reserve(properties.size());
+  for (size_t i = 0; i < properties.size(); ++i) {
+    names.emplace_back(doc, properties.name(i));
+  }
+  return names;
+}
+
+// Returns the index of the first property without a value whose name, as
+// interned in names, is the given name, or -1.
+int FindMissingProperty(const PropertySet& properties,
+                        const std::vector<InternedName>& names,
+                        const xmlChar* name) {
+  for (size_t i = 0; i < properties.size(); ++i) {
+    if (!properties.has_value(i) && names[i].Matches(name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Sets the properties that have no value yet from the content of the first
+// matching element in node or its descendants, in a single preorder walk.
+void ReadMissingNodeContents(const xmlNodePtr node, StringRef prefix,
+                             size_t num_missing, PropertySet* properties) {
+  const std::vector<InternedName> names =
+      InternPropertyNames(node->doc, *properties);
+  PrefixMatcher prefix_matcher(prefix);
+  xmlNodePtr current = node;
+  while (num_missing > 0) {
+    if (current->type == XML_ELEMENT_NODE &&
+        prefix_matcher.Matches(current->ns)) {
+      const int index = FindMissingProperty(*properties, names, current->name);
+      if (index >= 0) {
+        string storage;
+        const StringRef text = GetElementText(current, &storage);
+        SetPropertyText(index, text, storage, properties);
+        --num_missing;
+      }
+    }
+    if (current->type == XML_ELEMENT_NODE && current->children != nullptr) {
+      current = current->children;
+      continue;
+    }
+    while (current != node && current->next == nullptr) {
+      current = current->parent;
+    }
+    if (current == node) {
+      return;
+    }
+    current = current->next;
+  }
+}
+
 // Search for an rdf:Seq node, if it hasn't already been set.
 // parent_name is the name of the rdf:Seq node's parent.
-xmlNodePtr FindSeqNode(const xmlNodePtr node, const string& prefix,
-                       const string& parent_name) {
-  xmlNodePtr parent_node =
-      DepthFirstSearch(node, prefix.data(), parent_name.data());
+xmlNodePtr FindSeqNode(const NodeIndex* index, const xmlNodePtr node,
+                       StringRef prefix, StringRef parent_name) {
+  xmlNodePtr parent_node = FindNode(index, node, prefix, parent_name);
   if (parent_node == nullptr) {
     LOG(WARNING) << "Node " << parent_name << " not found";
     return nullptr;
@@ -59,21 +178,39 @@ xmlNodePtr FindSeqNode(const xmlNodePtr node, const string& prefix,
   return GetFirstSeqElement(parent_node);
 }
 
-// Extracts the specified string attribute.
-bool GetStringProperty(const xmlNodePtr node, const string& prefix,
-                       const string& property, string* value) {
-  const xmlDocPtr doc = node->doc;
+// Returns the text of each rdf:li element in seq_node. When an element holds a
+// single text node, as is usual, its text is not copied. Other contents are
+// copied into storage.
+std::vector<const char*> GetLiTexts(const xmlNodePtr seq_node,
+                                    std::deque<string>* storage) {
+  std::vector<const char*> texts;
+  for (xmlNodePtr li_node : GetLiElements(seq_node)) {
+    const xmlNodePtr child = li_node->children;
+    if (child == nullptr) {
+      texts.push_back("");
+    } else if (child->next == nullptr && child->type == XML_TEXT_NODE &&
+               child->content != nullptr) {
+      texts.push_back(FromXmlChar(child->content));
+    } else {
+      storage->push_back(GetLiNodeContent(li_node));
+      texts.push_back(storage->back().c_str());
+    }
+  }
+  return texts;
+}
+
+// Finds the specified string attribute and sets text to its value, which is
+// copied into storage only if it is not a single text node.
+bool GetStringProperty(const xmlNodePtr node, StringRef prefix,
+                       StringRef property, string* storage, StringRef* text) {
+  const InternedName property_name(node->doc, property);
+  PrefixMatcher prefix_matcher(prefix);
   for (const _xmlAttr* attribute = node->properties; attribute != nullptr;
        attribute = attribute->next) {
     // If prefix is not empty, then the attribute's namespace must not be null.
-    if (((attribute->ns && !prefix.empty() &&
-          strcmp(FromXmlChar(attribute->ns->prefix), prefix.data()) == 0) ||
-         prefix.empty()) &&
-        strcmp(FromXmlChar(attribute->name), property.data()) == 0) {
-      xmlChar* attribute_string =
-          xmlNodeListGetString(doc, attribute->children, 1);
-      *value = FromXmlChar(attribute_string);
-      xmlFree(attribute_string);
+    if (property_name.Matches(attribute->name) &&
+        prefix_matcher.Matches(attribute->ns)) {
+      *text = GetNodeListText(node->doc, attribute->children, storage);
       return true;
     }
   }
@@ -81,28 +218,29 @@ bool GetStringProperty(const xmlNodePtr node, const string& prefix,
   return false;
 }
 
-// Reads the contents of a node.
+// Reads the contents of a node, which are copied into storage only if they
+// are not a single text node.
 // E.g. <prefix:node_name>Contents Here</prefix:node_name>
-bool ReadNodeContent(const xmlNodePtr node, const string& prefix,
-                     const string& node_name, string* value) {
-  auto* element = DepthFirstSearch(node, prefix.data(), node_name.data());
+bool ReadNodeContent(const NodeIndex* index, const xmlNodePtr node,
+                     StringRef prefix, StringRef node_name,
+                     string* storage, StringRef* text) {
+  auto* element = FindNode(index, node, prefix, node_name);
   if (element == nullptr) {
     return false;
   }
-  if (!prefix.empty() &&
-      (element->ns == nullptr || element->ns->prefix == nullptr ||
-       strcmp(FromXmlChar(element->ns->prefix), prefix.data()) != 0)) {
+  if (!PrefixMatcher(prefix).Matches(element->ns)) {
     return false;
   }
-  xmlChar* node_content = xmlNodeGetContent(element);
-  *value = FromXmlChar(node_content);
-  free(node_content);
+  *text = GetElementText(element, storage);
   return true;
 }
 
-// Reads the string value of a property from the given XML node.
-bool ReadStringProperty(const xmlNodePtr node, const string& prefix,
-                        const string& property, string* value) {
+// Reads the text of a property from the given XML node. The text is copied
+// into storage only if it is not a single text node, so that a single number
+// or boolean can be parsed in place.
+bool ReadPropertyText(const NodeIndex* index, const xmlNodePtr node,
+                      StringRef prefix, StringRef property,
+                      string* storage, StringRef* text) {
   if (node == nullptr) {
     return false;
   }
@@ -112,19 +250,34 @@ bool ReadStringProperty(const xmlNodePtr node, const string& prefix,
   }
 
   // Try parsing in the format <Node ... Prefix:Property="Value"/>
-  bool success = GetStringProperty(node, prefix, property, value);
+  bool success = GetStringProperty(node, prefix, property, storage, text);
   if (!success) {
     // Try parsing in the format <Prefix:Property>Value</Prefix:Property>
-    success = ReadNodeContent(node, prefix, property, value);
+    success = ReadNodeContent(index, node, prefix, property, storage, text);
   }
   return success;
 }
 
+// Reads the string value of a property from the given XML node.
+bool ReadStringProperty(const NodeIndex* index, const xmlNodePtr node,
+                        StringRef prefix, StringRef property,
+                        string* value) {
+  StringRef text;
+  if (!ReadPropertyText(index, node, prefix, property, value, &text)) {
+    return false;
+  }
+  if (text.data() != value->c_str()) {
+    value->assign(text.data(), text.size());
+  }
+  return true;
+}
+
 // Same as ReadStringProperty, but applies base-64 decoding to the output.
-bool ReadBase64Property(const xmlNodePtr node, const string& prefix,
-                        const string& property, string* value) {
+bool ReadBase64Property(const NodeIndex* index, const xmlNodePtr node,
+                        StringRef prefix, StringRef property,
+                        string* value) {
   string base64_data;
-  if (!ReadStringProperty(node, prefix, property, &base64_data)) {
+  if (!ReadStringProperty(index, node, prefix, property, &base64_data)) {
     return false;
   }
   return DecodeBase64(base64_data, value);
@@ -133,27 +286,31 @@ bool ReadBase64Property(const xmlNodePtr node, const string& prefix,
 }  // namespace
 
 DeserializerImpl::DeserializerImpl(const xmlNodePtr node)
-    : node_(node), list_node_(nullptr) {}
+    : DeserializerImpl(node, nullptr) {}
+
+DeserializerImpl::DeserializerImpl(const xmlNodePtr node,
+                                   const NodeIndex* index)
+    : node_(node), index_(index), list_node_(nullptr) {}
 
 // Public methods.
 std::unique_ptr<Deserializer> DeserializerImpl::CreateDeserializer(
-    const string& prefix, const string& child_name) const {
+    StringRef prefix, StringRef child_name) const {
   if (child_name.empty()) {
     LOG(ERROR) << "Child name is empty";
     return nullptr;
   }
-  xmlNodePtr child_node =
-      DepthFirstSearch(node_, prefix.data(), child_name.data());
+  xmlNodePtr child_node = FindNode(index_, node_, prefix, child_name);
   if (child_node == nullptr) {
     LOG(ERROR) << "Could not find " << child_name << " node";
     return nullptr;
   }
-  return std::unique_ptr<Deserializer>(new DeserializerImpl(child_node));
+  return std::unique_ptr<Deserializer>(
+      new DeserializerImpl(child_node, index_));
 }
 
 std::unique_ptr<Deserializer>
-DeserializerImpl::CreateDeserializerFromListElementAt(const string& prefix,
-                                                      const string& list_name,
+DeserializerImpl::CreateDeserializerFromListElementAt(StringRef prefix,
+                                                      StringRef list_name,
                                                       int index) const {
   if (index < 0) {
     LOG(ERROR) << "Index must be greater than or equal to zero";
@@ -165,16 +322,13 @@ DeserializerImpl::CreateDeserializerFromListElementAt(const string& prefix,
     return nullptr;
   }
   // Search for an rdf:Seq node, if the name of list_node_ doesn't match
-  // the given parent name.
-  // Ensures thread safety.
-  const xmlNodePtr list_node = [&] {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (list_node_ == nullptr ||
-        string(FromXmlChar(list_node_->name)) != list_name) {
-      list_node_ = DepthFirstSearch(node_, prefix.data(), list_name.data());
-    }
-    return list_node_;
-  }();
+  // the given parent name. Threads that miss at the same time each search and
+  // publish their own result.
+  xmlNodePtr list_node = list_node_.load(std::memory_order_acquire);
+  if (list_node == nullptr || !NodeNameMatches(list_node, prefix, list_name)) {
+    list_node = FindNode(index_, node_, prefix, list_name);
+    list_node_.store(list_node, std::memory_order_release);
+  }
   if (list_node == nullptr) {
     return nullptr;
   }
@@ -190,120 +344,186 @@ DeserializerImpl::CreateDeserializerFromListElementAt(const string& prefix,
   }
   // Return a new Deserializer with the current rdf:li node and the current
   // node name.
-  return std::unique_ptr<Deserializer>(new DeserializerImpl(li_node));
+  return std::unique_ptr<Deserializer>(new DeserializerImpl(li_node, index_));
+}
+
+std::vector<std::unique_ptr<Deserializer>>
+DeserializerImpl::CreateListDeserializers(StringRef prefix,
+                                          StringRef list_name) const {
+  std::vector<std::unique_ptr<Deserializer>> deserializers;
+  if (list_name.empty()) {
+    LOG(ERROR) << "Parent name cannot be empty";
+    return deserializers;
+  }
+  xmlNodePtr list_node = FindNode(index_, node_, prefix, list_name);
+  if (list_node == nullptr) {
+    return deserializers;
+  }
+  xmlNodePtr seq_node = GetFirstSeqElement(list_node);
+  if (seq_node == nullptr) {
+    LOG(ERROR) << "No rdf:Seq node found on " << list_name;
+    return deserializers;
+  }
+  for (xmlNodePtr li_node : GetLiElements(seq_node)) {
+    deserializers.emplace_back(new DeserializerImpl(li_node, index_));
+  }
+  return deserializers;
 }
 
-bool DeserializerImpl::ParseBase64(const string& prefix, const string& name,
+bool DeserializerImpl::ParseBase64(StringRef prefix, StringRef name,
                                    string* value) const {
-  return ReadBase64Property(node_, prefix, name, value);
+  return ReadBase64Property(index_, node_, prefix, name, value);
 }
 
-bool DeserializerImpl::ParseIntArrayBase64(const string& prefix,
-                                           const string& name,
+bool DeserializerImpl::ParseIntArrayBase64(StringRef prefix, StringRef name,
                                            std::vector<int>& values) const {
   string base64_data;
-  if (!ReadStringProperty(node_, prefix, name, &base64_data)) {
+  if (!ReadStringProperty(index_, node_, prefix, name, &base64_data)) {
     return false;
   }
   return DecodeIntArrayBase64(base64_data, values);
 }
 
-bool DeserializerImpl::ParseFloatArrayBase64(const string& prefix,
-                                             const string& name,
+bool DeserializerImpl::ParseFloatArrayBase64(StringRef prefix, StringRef name,
                                              std::vector<float>& values) const {
   string base64_data;
-  if (!ReadStringProperty(node_, prefix, name, &base64_data)) {
+  if (!ReadStringProperty(index_, node_, prefix, name, &base64_data)) {
     return false;
   }
   return DecodeFloatArrayBase64(base64_data, values);
 }
 
-bool DeserializerImpl::ParseBoolean(const string& prefix, const string& name,
+bool DeserializerImpl::ParseBoolean(StringRef prefix, StringRef name,
                                     bool* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
+  string storage;
+  StringRef text;
+  if (!ReadPropertyText(index_, node_, prefix, name, &storage, &text)) {
     return false;
   }
-  return BoolStringToBool(string_value, value);
+  return BoolStringToBool(text, value);
 }
 
-bool DeserializerImpl::ParseDouble(const string& prefix, const string& name,
+bool DeserializerImpl::ParseDouble(StringRef prefix, StringRef name,
                                    double* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
+  string storage;
+  StringRef text;
+  if (!ReadPropertyText(index_, node_, prefix, name, &storage, &text)) {
     return false;
   }
-  *value = std::stod(string_value);
-  return true;
+  return safe_strtod(text.data(), text.size(), value);
 }
 
-bool DeserializerImpl::ParseInt(const string& prefix, const string& name,
+bool DeserializerImpl::ParseInt(StringRef prefix, StringRef name,
                                 int* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
+  string storage;
+  StringRef text;
+  if (!ReadPropertyText(index_, node_, prefix, name, &storage, &text)) {
     return false;
   }
-  return SimpleAtoi(string_value, value);
+  return safe_strto32(text.data(), text.size(), value);
 }
 
-bool DeserializerImpl::ParseLong(const string& prefix, const string& name,
+bool DeserializerImpl::ParseLong(StringRef prefix, StringRef name,
                                  int64* value) const {
-  string string_value;
-  if (!ReadStringProperty(node_, prefix, name, &string_value)) {
+  string storage;
+  StringRef text;
+  if (!ReadPropertyText(index_, node_, prefix, name, &storage, &text)) {
     return false;
   }
-  *value = std::stol(string_value);
-  return true;
+  return safe_strto64(text.data(), text.size(), value);
 }
 
-bool DeserializerImpl::ParseString(const string& prefix, const string& name,
+bool DeserializerImpl::ParseString(StringRef prefix, StringRef name,
                                    string* value) const {
-  return ReadStringProperty(node_, prefix, name, value);
+  return ReadStringProperty(index_, node_, prefix, name, value);
 }
 
-bool DeserializerImpl::ParseIntArray(const string& prefix,
-                                     const string& list_name,
+bool DeserializerImpl::ParseProperties(StringRef prefix,
+                                       PropertySet* properties) const {
+  if (node_ == nullptr) {
+    return false;
+  }
+  properties->SetPrefix(prefix);
+
+  // Try the format <Node ... Prefix:Property="Value"/>
+  size_t num_missing = properties->size();
+  const std::vector<InternedName> names =
+      InternPropertyNames(node_->doc, *properties);
+  PrefixMatcher prefix_matcher(prefix);
+  for (const _xmlAttr* attribute = node_->properties;
+       attribute != nullptr && num_missing > 0; attribute = attribute->next) {
+    if (!prefix_matcher.Matches(attribute->ns)) {
+      continue;
+    }
+    const int index =
+        FindMissingProperty(*properties, names, attribute->name);
+    if (index >= 0) {
+      string storage;
+      const StringRef text =
+          GetNodeListText(node_->doc, attribute->children, &storage);
+      SetPropertyText(index, text, storage, properties);
+      --num_missing;
+    }
+  }
+  if (num_missing == 0) {
+    return true;
+  }
+
+  // Try the format <Prefix:Property>Value</Prefix:Property>
+  if (index_ != nullptr) {
+    for (size_t i = 0; i < properties->size(); ++i) {
+      if (!properties->has_value(i)) {
+        string storage;
+        StringRef text;
+        if (ReadNodeContent(index_, node_, prefix, properties->name(i),
+                            &storage, &text)) {
+          SetPropertyText(i, text, storage, properties);
+        }
+      }
+    }
+  } else {
+    ReadMissingNodeContents(node_, prefix, num_missing, properties);
+  }
+  return true;
+}
+
+bool DeserializerImpl::ParseIntArray(StringRef prefix, StringRef list_name,
                                      std::vector<int>* values) const {
-  xmlNodePtr seq_node = FindSeqNode(node_, prefix, list_name);
+  xmlNodePtr seq_node = FindSeqNode(index_, node_, prefix, list_name);
   if (seq_node == nullptr) {
     LOG(ERROR) << "No rdf:Seq node found";
     return false;
   }
-  values->clear();
-  int i = 0;
-  for (xmlNodePtr li_node = GetElementAt(seq_node, 0); li_node != nullptr;
-       li_node = GetElementAt(seq_node, ++i)) {
-    int int_value;
-    if (!SimpleAtoi(GetLiNodeContent(li_node), &int_value)) {
-      LOG(ERROR) << "Could not parse rdf:li node value to an integer";
-      return false;
-    }
-    values->push_back(int_value);
+  std::deque<string> storage;
+  const std::vector<const char*> texts = GetLiTexts(seq_node, &storage);
+  values->resize(texts.size());
+  const size_t num_parsed =
+      safe_strto32_array(texts.data(), texts.size(), values->data());
+  if (num_parsed < texts.size()) {
+    values->resize(num_parsed);
+    LOG(ERROR) << "Could not parse rdf:li node value to an integer";
+    return false;
   }
-
   return true;
 }
 
-bool DeserializerImpl::ParseDoubleArray(const string& prefix,
-                                        const string& list_name,
+bool DeserializerImpl::ParseDoubleArray(StringRef prefix, StringRef list_name,
                                         std::vector<double>* values) const {
-  xmlNodePtr seq_node = FindSeqNode(node_, prefix, list_name);
+  xmlNodePtr seq_node = FindSeqNode(index_, node_, prefix, list_name);
   if (seq_node == nullptr) {
     LOG(ERROR) << "No rdf:Seq node found";
     return false;
   }
-  values->clear();
-  int i = 0;
-  for (xmlNodePtr li_node = GetElementAt(seq_node, 0); li_node != nullptr;
-       li_node = GetElementAt(seq_node, ++i)) {
-    double double_value;
-    if (!safe_strtod(GetLiNodeContent(li_node), &double_value)) {
-      LOG(ERROR) << "Could not parse rdf:li node value to a double";
-      return false;
-    }
-    values->push_back(double_value);
+  std::deque<string> storage;
+  const std::vector<const char*> texts = GetLiTexts(seq_node, &storage);
+  values->resize(texts.size());
+  const size_t num_parsed =
+      safe_strtod_array(texts.data(), texts.size(), values->data());
+  if (num_parsed < texts.size()) {
+    values->resize(num_parsed);
+    LOG(ERROR) << "Could not parse rdf:li node value to a double";
+    return false;
   }
-
   return true;
 }
 
@@ -15,14 +15,15 @@
 #ifndef XMPMETA_XML_DESERIALIZER_IMPL_H_
 #define XMPMETA_XML_DESERIALIZER_IMPL_H_
 
+#include <atomic>
 #include <map>
-#include <mutex>
 #include <string>
 
 #include <libxml/tree.h>
 
 #include "base/port.h"
 #include "xmpmeta/xml/deserializer.h"
+#include "xmpmeta/xml/node_index.h"
 
 namespace xmpmeta {
 namespace xml {
@@ -40,12 +41,17 @@ class DeserializerImpl : public Deserializer {
   // Creates a deserializer with a null rdf:Seq node.
   DeserializerImpl(const xmlNodePtr node);
 
+  // Same as above, but descendant nodes are looked up in the given index
+  // instead of by traversing the tree. The index must cover node, and must
+  // outlive this deserializer and those created from it. May be null.
+  DeserializerImpl(const xmlNodePtr node, const NodeIndex* index);
+
   // Returns a Deserializer.
   // If prefix is empty, the deserializer will be created on the first node
   // found with a name that matches child_name.
   // child_name is the name of the next node to deserialize.
   std::unique_ptr<Deserializer> CreateDeserializer(
-      const string& prefix, const string& child_name) const override;
+      StringRef prefix, StringRef child_name) const override;
 
   // Returns a Deserializer from a list element node, if one is available as
   // a descendant of node_.
@@ -53,34 +59,48 @@ class DeserializerImpl : public Deserializer {
   // found with a name that matches child_name.
   // Returns null if seq_node_ is null or if the index is out of range.
   std::unique_ptr<Deserializer> CreateDeserializerFromListElementAt(
-      const string& prefix, const string& list_name, int index) const override;
+      StringRef prefix, StringRef list_name, int index) const override;
+
+  // Returns a Deserializer for each rdf:li node of the first rdf:Seq node
+  // under the first descendant of node_ named list_name. The rdf:Seq node's
+  // children are walked once.
+  // Returns an empty vector if the list is not found.
+  std::vector<std::unique_ptr<Deserializer>> CreateListDeserializers(
+      StringRef prefix, StringRef list_name) const override;
 
   // Parsers for XML properties.
   // If prefix is empty, the node's namespace may be null. Otherwise, it must
   // not be null.
-  bool ParseBase64(const string& prefix, const string& name,
+  bool ParseBase64(StringRef prefix, StringRef name,
                    string* value) const override;
-  bool ParseIntArrayBase64(const string& prefix, const string& name,
+  bool ParseIntArrayBase64(StringRef prefix, StringRef name,
                            std::vector<int>& values) const override;
-  bool ParseFloatArrayBase64(const string& prefix, const string& name,
+  bool ParseFloatArrayBase64(StringRef prefix, StringRef name,
                              std::vector<float>& values) const override;
-  bool ParseBoolean(const string& prefix, const string& name,
+  bool ParseBoolean(StringRef prefix, StringRef name,
                     bool* value) const override;
-  bool ParseDouble(const string& prefix, const string& name,
+  bool ParseDouble(StringRef prefix, StringRef name,
                    double* value) const override;
-  bool ParseInt(const string& prefix, const string& name,
+  bool ParseInt(StringRef prefix, StringRef name,
                 int* value) const override;
-  bool ParseLong(const string& prefix, const string& name,
+  bool ParseLong(StringRef prefix, StringRef name,
                  int64* value) const override;
-  bool ParseString(const string& prefix, const string& name,
+  bool ParseString(StringRef prefix, StringRef name,
                    string* value) const override;
 
+  // Reads the properties from the attributes of node_, and the ones that are
+  // not attributes from the first matching descendants of node_, as
+  // ParseString does. The attributes and the descendants are each visited at
+  // most once.
+  bool ParseProperties(StringRef prefix,
+                       PropertySet* properties) const override;
+
   // Parses the numbers in an rdf:Seq list into the values collection.
   // The given collection is cleared of any existing values, and the
   // parsed numbers are written to it.
-  bool ParseIntArray(const string& prefix, const string& list_name,
+  bool ParseIntArray(StringRef prefix, StringRef list_name,
                      std::vector<int>* values) const override;
-  bool ParseDoubleArray(const string& prefix, const string& list_name,
+  bool ParseDoubleArray(StringRef prefix, StringRef list_name,
                         std::vector<double>* values) const override;
 
   // Disallow copying.
@@ -89,12 +109,14 @@ class DeserializerImpl : public Deserializer {
 
  private:
   xmlNodePtr node_;
+  // Not owned.
+  const NodeIndex* index_;
   // Remembers the parent node of the last deserializer created on the rdf:Seq
   // node. For performance reasons only, to avoid unnessarily traversing
   // the XML document tree.
-  mutable xmlNodePtr list_node_;
-  // Lock modifications of list_node_ in const functions to make it thread-safe.
-  mutable std::mutex mtx_;
+  // Any node published here is a valid result for its own name, so concurrent
+  // callers only need the store to be atomic, and never wait on each other.
+  mutable std::atomic<xmlNodePtr> list_node_;
 };
 
 }  // namespace xml
@@ -14,8 +14,13 @@
 
 #include "xmpmeta/xml/deserializer_impl.h"
 
+#include <atomic>
+#include <clocale>
+#include <cstdlib>
+#include <limits>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <libxml/tree.h>
@@ -271,6 +276,78 @@ TEST(DeserializerImpl, CreateDeserializerFromListElement) {
   xmlFreeNode(node);
 }
 
+TEST(DeserializerImpl, CreateDeserializerFromListElementConcurrently) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  for (const char* list_name : {"ListOne", "ListTwo"}) {
+    xmlNodePtr seq_parent_node = NewNode(nullptr, list_name);
+    xmlNodePtr seq_node = NewNode(nullptr, XmlConst::RdfSeq());
+    xmlNodePtr li_node = NewNode(nullptr, XmlConst::RdfLi());
+    xmlSetNsProp(li_node, nullptr, ToXmlChar("List"), ToXmlChar(list_name));
+    xmlAddChild(seq_node, li_node);
+    xmlAddChild(seq_parent_node, seq_node);
+    xmlAddChild(node, seq_parent_node);
+  }
+
+  // Threads alternate between the lists, so the cached list node keeps
+  // changing under them.
+  DeserializerImpl deserializer(node);
+  std::vector<std::thread> threads;
+  std::atomic<int> num_mismatches(0);
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&deserializer, &num_mismatches, i] {
+      for (int j = 0; j < 1000; j++) {
+        const char* list_name = (i + j) % 2 ? "ListOne" : "ListTwo";
+        std::unique_ptr<Deserializer> item_deserializer =
+            deserializer.CreateDeserializerFromListElementAt("", list_name, 0);
+        string value;
+        if (item_deserializer == nullptr ||
+            !item_deserializer->ParseString("", "List", &value) ||
+            value != list_name) {
+          ++num_mismatches;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, num_mismatches);
+
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, CreateListDeserializers) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  xmlNsPtr parent_ns = NewNamespace("http://somehref.com", "Prefix");
+  xmlNodePtr seq_parent_node = NewNode(parent_ns, "Parent");
+  xmlNodePtr seq_node = NewNode(nullptr, XmlConst::RdfSeq());
+  for (int i = 0; i < 3; i++) {
+    xmlNodePtr li_node = NewNode(nullptr, XmlConst::RdfLi());
+    xmlSetNsProp(li_node, nullptr, ToXmlChar("Index"),
+                 ToXmlChar(std::to_string(i).data()));
+    xmlAddChild(seq_node, li_node);
+  }
+  xmlAddChild(seq_parent_node, seq_node);
+  xmlAddChild(node, seq_parent_node);
+
+  DeserializerImpl deserializer(node);
+  std::vector<std::unique_ptr<Deserializer>> deserializers =
+      deserializer.CreateListDeserializers("Prefix", "Parent");
+  ASSERT_EQ(3u, deserializers.size());
+  for (size_t i = 0; i < deserializers.size(); i++) {
+    int index;
+    ASSERT_TRUE(deserializers[i]->ParseInt("", "Index", &index));
+    EXPECT_EQ(static_cast<int>(i), index);
+  }
+  EXPECT_EQ(3u, deserializer.CreateListDeserializers("", "Parent").size());
+  EXPECT_TRUE(deserializer.CreateListDeserializers("Other", "Parent").empty());
+  EXPECT_TRUE(deserializer.CreateListDeserializers("", "Missing").empty());
+  EXPECT_TRUE(deserializer.CreateListDeserializers("", "").empty());
+
+  xmlFreeNs(parent_ns);
+  xmlFreeNode(node);
+}
+
 TEST(DeserializerImpl, ParseDoubleArrayNoSeqParentNodeElement) {
   const char* node_name = "NodeName";
   xmlNsPtr node_ns = NewNamespace("http://somehref.com", "NodePrefix");
@@ -506,6 +583,29 @@ TEST(DeserializerImpl, ParseDoubleArrayWithStringType) {
   xmlFreeNode(node);
 }
 
+TEST(DeserializerImpl, ParseDoubleArrayWithMixedContent) {
+  const char* node_name = "NodeName";
+  xmlNodePtr node = NewNode(nullptr, node_name);
+  xmlNodePtr seq_node = NewNode(nullptr, XmlConst::RdfSeq());
+  xmlNodePtr li_node1 = NewNode(nullptr, XmlConst::RdfLi());
+  xmlNodePtr li_node2 = NewNode(nullptr, XmlConst::RdfLi());
+
+  // The content of the second node is split in a text and a CDATA node.
+  xmlNodeSetContent(li_node1, ToXmlChar("-85.32"));
+  xmlNodeSetContent(li_node2, ToXmlChar("1."));
+  xmlAddChild(li_node2, xmlNewCDataBlock(nullptr, ToXmlChar("25"), 2));
+
+  xmlAddChild(seq_node, li_node1);
+  xmlAddChild(seq_node, li_node2);
+  xmlAddChild(node, seq_node);
+  DeserializerImpl deserializer(node);
+  std::vector<double> values;
+  ASSERT_TRUE(deserializer.ParseDoubleArray("", node_name, &values));
+  EXPECT_EQ(std::vector<double>({-85.32, 1.25}), values);
+
+  xmlFreeNode(node);
+}
+
 // Variations on a theme of property parser tests.
 // Doubles.
 TEST(DeserializerImpl, ParseDoubleEmptyName) {
@@ -564,6 +664,63 @@ TEST(DeserializerImpl, ParseDouble) {
   xmlFreeNode(node);
 }
 
+TEST(DeserializerImpl, ParseDoubleExactValues) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  DeserializerImpl deserializer(node);
+  const char* values[] = {"-85.320000", "0.1", " 1e22 ", "0.000125",
+                          "123456789.987654321", "1.7976931348623157e308",
+                          "4.9e-324", "-0", "0x1.8p1"};
+  for (const char* value_str : values) {
+    xmlSetProp(node, ToXmlChar("Name"), ToXmlChar(value_str));
+    double value;
+    ASSERT_TRUE(deserializer.ParseDouble("", "Name", &value)) << value_str;
+    EXPECT_EQ(strtod(value_str, nullptr), value) << value_str;
+  }
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, ParseMalformedNumbers) {
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  DeserializerImpl deserializer(node);
+  const char* values[] = {"", " ", "abc", "1.5abc", "1e", "--1", "1,5", "."};
+  for (const char* value_str : values) {
+    xmlSetProp(node, ToXmlChar("Name"), ToXmlChar(value_str));
+    double double_value;
+    EXPECT_FALSE(deserializer.ParseDouble("", "Name", &double_value))
+        << value_str;
+    int64 long_value;
+    EXPECT_FALSE(deserializer.ParseLong("", "Name", &long_value))
+        << value_str;
+  }
+  xmlSetProp(node, ToXmlChar("Name"), ToXmlChar("9223372036854775808"));
+  int64 long_value;
+  EXPECT_FALSE(deserializer.ParseLong("", "Name", &long_value));
+  xmlSetProp(node, ToXmlChar("Name"), ToXmlChar("-9223372036854775808"));
+  ASSERT_TRUE(deserializer.ParseLong("", "Name", &long_value));
+  EXPECT_EQ(std::numeric_limits<int64>::min(), long_value);
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, ParseDoubleIgnoresLocale) {
+  // Skipped if no locale with a ',' decimal point is installed.
+  if (setlocale(LC_NUMERIC, "de_DE.UTF-8") == nullptr) {
+    return;
+  }
+  xmlNodePtr node = NewNode(nullptr, "NodeName");
+  DeserializerImpl deserializer(node);
+  double value;
+  xmlSetProp(node, ToXmlChar("Name"), ToXmlChar("1.5"));
+  ASSERT_TRUE(deserializer.ParseDouble("", "Name", &value));
+  EXPECT_EQ(1.5, value);
+  xmlSetProp(node, ToXmlChar("Name"), ToXmlChar("1.5e-300"));
+  ASSERT_TRUE(deserializer.ParseDouble("", "Name", &value));
+  EXPECT_EQ(1.5e-300, value);
+  xmlSetProp(node, ToXmlChar("Name"), ToXmlChar("1,5"));
+  EXPECT_FALSE(deserializer.ParseDouble("", "Name", &value));
+  setlocale(LC_NUMERIC, "C");
+  xmlFreeNode(node);
+}
+
 // String.
 TEST(DeserializerImpl, ParseStringEmptyName) {
   const char* node_name = "NodeName";
@@ -813,6 +970,105 @@ TEST(DeserializerImpl, ParseInt) {
   xmlFreeNode(node);
 }
 
+TEST(DeserializerImpl, ParseProperties) {
+  const char* node_name = "NodeName";
+  xmlNsPtr node_ns = NewNamespace("http://somehref.com/", node_name);
+  xmlNodePtr node = NewNode(node_ns, node_name);
+  xmlSetNsProp(node, node_ns, ToXmlChar("Width"), ToXmlChar("640"));
+  xmlSetNsProp(node, nullptr, ToXmlChar("Height"), ToXmlChar("100"));
+  xmlNodePtr child = NewNode(node_ns, "Height");
+  xmlNodeSetContent(child, ToXmlChar("480"));
+  xmlAddChild(node, child);
+  child = NewNode(node_ns, "Name");
+  xmlNodeSetContent(child, ToXmlChar("name"));
+  xmlAddChild(node, child);
+
+  const char* const kNames[] = {"Width", "Height", "Name", "Missing"};
+  PropertySet properties(kNames);
+  DeserializerImpl deserializer(node);
+  ASSERT_TRUE(deserializer.ParseProperties(node_name, &properties));
+
+  // Matches the results of the single-property parsers.
+  int width;
+  ASSERT_TRUE(properties.ParseInt(node_name, "Width", &width));
+  EXPECT_EQ(640, width);
+  int height;
+  ASSERT_TRUE(properties.ParseInt(node_name, "Height", &height));
+  int expected_height;
+  ASSERT_TRUE(deserializer.ParseInt(node_name, "Height", &expected_height));
+  EXPECT_EQ(expected_height, height);
+  EXPECT_EQ(480, height);
+  string name;
+  ASSERT_TRUE(properties.ParseString(node_name, "Name", &name));
+  EXPECT_EQ("name", name);
+  EXPECT_FALSE(properties.has_value(3));
+  EXPECT_FALSE(properties.ParseString(node_name, "Missing", &name));
+  EXPECT_EQ(node_name, properties.prefix());
+  EXPECT_FALSE(properties.ParseInt("Other", "Width", &width));
+
+  // Properties with another prefix are not read.
+  PropertySet other_properties(kNames);
+  ASSERT_TRUE(deserializer.ParseProperties("Other", &other_properties));
+  for (size_t i = 0; i < other_properties.size(); ++i) {
+    EXPECT_FALSE(other_properties.has_value(i)) << other_properties.name(i);
+  }
+
+  xmlFreeNs(node_ns);
+  xmlFreeNode(node);
+}
+
+TEST(DeserializerImpl, ParseTextSplitAcrossNodes) {
+  // A value in one text node is parsed in place; one split by a comment is
+  // copied, and must parse the same.
+  const char* node_name = "NodeName";
+  xmlNsPtr node_ns = NewNamespace("http://somehref.com/", node_name);
+  xmlNodePtr node = NewNode(node_ns, node_name);
+  xmlNodePtr child = NewNode(node_ns, "Width");
+  xmlAddChild(child, xmlNewText(ToXmlChar("6")));
+  xmlAddChild(child, xmlNewComment(ToXmlChar("comment")));
+  xmlAddChild(child, xmlNewText(ToXmlChar("40")));
+  xmlAddChild(node, child);
+  child = NewNode(node_ns, "Enabled");
+  xmlAddChild(child, xmlNewText(ToXmlChar("tr")));
+  xmlAddChild(child, xmlNewComment(ToXmlChar("comment")));
+  xmlAddChild(child, xmlNewText(ToXmlChar("ue")));
+  xmlAddChild(node, child);
+  child = NewNode(node_ns, "Height");
+  xmlNodeSetContent(child, ToXmlChar("480"));
+  xmlAddChild(node, child);
+  DeserializerImpl deserializer(node);
+
+  int width;
+  ASSERT_TRUE(deserializer.ParseInt(node_name, "Width", &width));
+  EXPECT_EQ(640, width);
+  double double_width;
+  ASSERT_TRUE(deserializer.ParseDouble(node_name, "Width", &double_width));
+  EXPECT_EQ(640, double_width);
+  bool enabled;
+  ASSERT_TRUE(deserializer.ParseBoolean(node_name, "Enabled", &enabled));
+  EXPECT_TRUE(enabled);
+  string text;
+  ASSERT_TRUE(deserializer.ParseString(node_name, "Width", &text));
+  EXPECT_EQ("640", text);
+  ASSERT_TRUE(deserializer.ParseString(node_name, "Height", &text));
+  EXPECT_EQ("480", text);
+
+  const char* const kNames[] = {"Width", "Enabled", "Height"};
+  PropertySet properties(kNames);
+  ASSERT_TRUE(deserializer.ParseProperties(node_name, &properties));
+  int64 long_width;
+  ASSERT_TRUE(properties.ParseLong(node_name, "Width", &long_width));
+  EXPECT_EQ(640, long_width);
+  ASSERT_TRUE(properties.ParseBoolean(node_name, "Enabled", &enabled));
+  EXPECT_TRUE(enabled);
+  int height;
+  ASSERT_TRUE(properties.ParseInt(node_name, "Height", &height));
+  EXPECT_EQ(480, height);
+
+  xmlFreeNs(node_ns);
+  xmlFreeNode(node);
+}
+
 }  // namespace
 }  // namespace xml
 }  // namespace xmpmeta
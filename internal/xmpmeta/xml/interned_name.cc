@@ -0,0 +1,49 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/interned_name.h"
+
+#include <cstring>
+
+#include <libxml/dict.h>
+
+namespace xmpmeta {
+namespace xml {
+
+InternedName::InternedName(const xmlDocPtr doc, StringRef name)
+    : name_(name),
+      interned_(doc != nullptr && doc->dict != nullptr),
+      dict_name_(interned_ ? xmlDictExists(doc->dict, ToXmlChar(name.c_str()),
+                                           name.size())
+                           : nullptr) {}
+
+bool PrefixMatcher::Matches(const xmlNs* ns) {
+  if (prefix_.empty()) {
+    return true;
+  }
+  if (ns == nullptr || ns->prefix == nullptr) {
+    return false;
+  }
+  if (ns == matched_ns_) {
+    return true;
+  }
+  if (strcmp(FromXmlChar(ns->prefix), prefix_.c_str()) != 0) {
+    return false;
+  }
+  matched_ns_ = ns;
+  return true;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
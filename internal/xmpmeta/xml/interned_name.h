@@ -0,0 +1,85 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_INTERNED_NAME_H_
+#define XMPMETA_XML_INTERNED_NAME_H_
+
+#include <cstring>
+
+#include <libxml/tree.h>
+
+#include "xmpmeta/xml/string_ref.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// A local name to compare with the names of the elements and attributes of
+// one XML document. libxml interns the names of the nodes it creates for a
+// document, e.g. when parsing it, in the document's dictionary. The name is
+// looked up there once, and candidates are then matched by comparing
+// pointers; a name that is not in the dictionary matches no node. The names
+// of documents without a dictionary, such as those created with xmlNewDoc or
+// nodes that have no document, are compared by value.
+// Example:
+//   const InternedName li(node->doc, XmlConst::RdfLi());
+//   for (xmlNodePtr child = node->children; ...) {
+//     if (li.Matches(child->name)) { ... }
+//   }
+class InternedName {
+ public:
+  // The name must outlive this object. doc may be null.
+  InternedName(const xmlDocPtr doc, StringRef name);
+
+  // Returns true if the given element or attribute name, of a node of the
+  // document this object was created for, is equal to this name.
+  bool Matches(const xmlChar* name) const {
+    if (interned_) {
+      return name == dict_name_;
+    }
+    return name != nullptr && strcmp(FromXmlChar(name), name_.c_str()) == 0;
+  }
+
+ private:
+  StringRef name_;
+  // True if the document has a dictionary.
+  bool interned_;
+  // The dictionary's copy of the name, or null if it is not in there.
+  const xmlChar* dict_name_;
+};
+
+// A namespace prefix to compare with the namespaces of the nodes of a
+// document. libxml copies the prefixes of namespaces rather than interning
+// them, so the first namespace found to have the prefix is remembered, and
+// later nodes that share it, as the nodes of an XMP document usually do, are
+// matched by comparing pointers. An empty prefix matches any namespace.
+// Meant to be used for a single search, by a single thread.
+class PrefixMatcher {
+ public:
+  // The prefix must outlive this object.
+  explicit PrefixMatcher(StringRef prefix)
+      : prefix_(prefix), matched_ns_(nullptr) {}
+
+  // Returns true if this prefix is empty or is the prefix of ns.
+  bool Matches(const xmlNs* ns);
+
+ private:
+  StringRef prefix_;
+  const xmlNs* matched_ns_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_INTERNED_NAME_H_
@@ -0,0 +1,114 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/interned_name.h"
+
+#include <string>
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kXml[] =
+    "<a:Root xmlns:a=\"http://ns.a/\" xmlns:b=\"http://ns.b/\">"
+    "<a:Child/><b:Child/></a:Root>";
+
+xmlDocPtr ParseXml() {
+  return xmlReadMemory(kXml, sizeof(kXml) - 1, nullptr, nullptr, 0);
+}
+
+TEST(InternedName, ParsedDocumentMatchesByPointer) {
+  xmlDocPtr doc = ParseXml();
+  ASSERT_NE(nullptr, doc);
+  ASSERT_NE(nullptr, doc->dict);
+  const xmlNodePtr child = xmlDocGetRootElement(doc)->children;
+
+  const InternedName name(doc, "Child");
+  EXPECT_TRUE(name.Matches(child->name));
+  EXPECT_FALSE(name.Matches(xmlDocGetRootElement(doc)->name));
+  // An equal name that is not the document's is not matched.
+  const std::string copy = "Child";
+  EXPECT_FALSE(name.Matches(ToXmlChar(copy.c_str())));
+  EXPECT_FALSE(name.Matches(nullptr));
+
+  xmlFreeDoc(doc);
+}
+
+TEST(InternedName, NameNotInDictionaryMatchesNothing) {
+  xmlDocPtr doc = ParseXml();
+  ASSERT_NE(nullptr, doc);
+
+  const InternedName name(doc, "Missing");
+  for (xmlNodePtr node = xmlDocGetRootElement(doc); node != nullptr;
+       node = node->children) {
+    EXPECT_FALSE(name.Matches(node->name));
+  }
+
+  xmlFreeDoc(doc);
+}
+
+TEST(InternedName, DocumentWithoutDictionaryMatchesByValue) {
+  xmlDocPtr doc = xmlNewDoc(ToXmlChar("1.0"));
+  xmlNodePtr root = xmlNewNode(nullptr, ToXmlChar("Root"));
+  xmlDocSetRootElement(doc, root);
+  ASSERT_EQ(nullptr, doc->dict);
+
+  const InternedName name(doc, "Root");
+  EXPECT_TRUE(name.Matches(root->name));
+  EXPECT_FALSE(name.Matches(ToXmlChar("Child")));
+  EXPECT_FALSE(name.Matches(nullptr));
+  EXPECT_TRUE(InternedName(nullptr, "Root").Matches(root->name));
+
+  xmlFreeDoc(doc);
+}
+
+TEST(PrefixMatcher, MatchesNamespacesByPrefix) {
+  xmlDocPtr doc = ParseXml();
+  ASSERT_NE(nullptr, doc);
+  const xmlNodePtr root = xmlDocGetRootElement(doc);
+  const xmlNodePtr a_child = root->children;
+  const xmlNodePtr b_child = a_child->next;
+
+  PrefixMatcher matcher("a");
+  EXPECT_TRUE(matcher.Matches(root->ns));
+  EXPECT_TRUE(matcher.Matches(a_child->ns));
+  EXPECT_FALSE(matcher.Matches(b_child->ns));
+  EXPECT_FALSE(matcher.Matches(nullptr));
+
+  xmlFreeDoc(doc);
+}
+
+TEST(PrefixMatcher, EmptyPrefixMatchesAnyNamespace) {
+  xmlDocPtr doc = ParseXml();
+  ASSERT_NE(nullptr, doc);
+  const xmlNodePtr root = xmlDocGetRootElement(doc);
+
+  PrefixMatcher matcher("");
+  EXPECT_TRUE(matcher.Matches(root->ns));
+  EXPECT_TRUE(matcher.Matches(root->children->next->ns));
+  EXPECT_TRUE(matcher.Matches(nullptr));
+  EXPECT_TRUE(PrefixMatcher(nullptr).Matches(root->ns));
+
+  xmlFreeDoc(doc);
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
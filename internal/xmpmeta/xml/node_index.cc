@@ -0,0 +1,148 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/node_index.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+#include "xmpmeta/xml/search.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+
+NodeIndex::NodeIndex(xmlDictPtr dict) : dict_(dict) {}
+
+NodeIndex::~NodeIndex() { xmlDictFree(dict_); }
+
+std::unique_ptr<NodeIndex> NodeIndex::Create() {
+  xmlDictPtr dict = xmlDictCreate();
+  if (dict == nullptr) {
+    LOG(ERROR) << "Could not create the name dictionary";
+    return nullptr;
+  }
+  return std::unique_ptr<NodeIndex>(new NodeIndex(dict));
+}
+
+std::unique_ptr<NodeIndex> NodeIndex::FromDoc(const xmlDocPtr doc) {
+  if (doc == nullptr) {
+    LOG(ERROR) << "XML doc was null";
+    return nullptr;
+  }
+  std::unique_ptr<NodeIndex> index = Create();
+  if (index == nullptr) {
+    return nullptr;
+  }
+  for (xmlNodePtr node = doc->children; node != nullptr; node = node->next) {
+    index->AddTree(node);
+  }
+  return index;
+}
+
+std::unique_ptr<NodeIndex> NodeIndex::FromNode(const xmlNodePtr root) {
+  if (root == nullptr) {
+    LOG(ERROR) << "XML node was null";
+    return nullptr;
+  }
+  std::unique_ptr<NodeIndex> index = Create();
+  if (index == nullptr) {
+    return nullptr;
+  }
+  index->AddTree(root);
+  return index;
+}
+
+xmlNodePtr NodeIndex::Find(const char* prefix, const char* name) const {
+  if (ranges_.empty()) {
+    return nullptr;
+  }
+  return FindInRange(prefix, name, 0, ranges_.size() - 1);
+}
+
+xmlNodePtr NodeIndex::Find(const xmlNodePtr parent, const char* prefix,
+                           const char* name) const {
+  if (parent == nullptr) {
+    LOG(ERROR) << "XML node was null";
+    return nullptr;
+  }
+  const auto range = ranges_.find(parent);
+  if (range == ranges_.end()) {
+    return DepthFirstSearch(parent, prefix, name);
+  }
+  return FindInRange(prefix, name, range->second.first, range->second.second);
+}
+
+void NodeIndex::AddTree(const xmlNodePtr root) {
+  // Walks the tree in preorder through the sibling and parent links, so that
+  // no stack is needed.
+  xmlNodePtr node = root;
+  while (true) {
+    if (node->type == XML_ELEMENT_NODE) {
+      const size_t order = ranges_.size();
+      ranges_[node] = std::make_pair(order, order);
+      const xmlChar* prefix =
+          node->ns != nullptr && node->ns->prefix != nullptr
+              ? xmlDictLookup(dict_, node->ns->prefix, -1)
+              : nullptr;
+      elements_[xmlDictLookup(dict_, node->name, -1)].push_back(
+          {order, node, prefix});
+      if (node->children != nullptr) {
+        node = node->children;
+        continue;
+      }
+    }
+    // Close the subtrees that end here.
+    while (node != root && node->next == nullptr) {
+      node = node->parent;
+      ranges_[node].second = ranges_.size() - 1;
+    }
+    if (node == root) {
+      return;
+    }
+    node = node->next;
+  }
+}
+
+xmlNodePtr NodeIndex::FindInRange(const char* prefix, const char* name,
+                                  size_t first, size_t last) const {
+  // A name or prefix that is not in the dictionary matches no element.
+  const xmlChar* interned_name = xmlDictExists(dict_, ToXmlChar(name), -1);
+  if (interned_name == nullptr) {
+    return nullptr;
+  }
+  const bool any_prefix = prefix == nullptr || prefix[0] == '\0';
+  const xmlChar* interned_prefix =
+      any_prefix ? nullptr : xmlDictExists(dict_, ToXmlChar(prefix), -1);
+  if (!any_prefix && interned_prefix == nullptr) {
+    return nullptr;
+  }
+  const auto elements = elements_.find(interned_name);
+  if (elements == elements_.end()) {
+    return nullptr;
+  }
+  const std::vector<Entry>& entries = elements->second;
+  auto entry = std::lower_bound(
+      entries.begin(), entries.end(), first,
+      [](const Entry& entry, size_t order) { return entry.order < order; });
+  for (; entry != entries.end() && entry->order <= last; ++entry) {
+    if (any_prefix || entry->prefix == interned_prefix) {
+      return entry->node;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
@@ -0,0 +1,102 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_NODE_INDEX_H_
+#define XMPMETA_XML_NODE_INDEX_H_
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <libxml/tree.h>
+
+namespace xmpmeta {
+namespace xml {
+
+// An index of the elements of an XML tree by name, built in a single pass.
+// Looking up a descendant of a node takes a hash lookup and a binary search,
+// instead of the full traversal done by DepthFirstSearch. Names and prefixes
+// are interned in a dictionary owned by the index, so that the candidates are
+// then matched by comparing pointers.
+// The tree must not be modified while the index is in use.
+// Example:
+//   std::unique_ptr<NodeIndex> index = NodeIndex::FromDoc(xmp_doc);
+//   xmlNodePtr device_node = index->Find("", "Device");
+//   DeserializerImpl deserializer(device_node, index.get());
+class NodeIndex {
+ public:
+  // Indexes all the elements of the given document.
+  // Returns null if doc is null or the index could not be allocated.
+  static std::unique_ptr<NodeIndex> FromDoc(const xmlDocPtr doc);
+
+  // Indexes the given node and all of its descendant elements.
+  // Returns null if root is null or the index could not be allocated.
+  static std::unique_ptr<NodeIndex> FromNode(const xmlNodePtr root);
+
+  ~NodeIndex();
+
+  // Returns the first element in document order with a matching prefix and
+  // name. If prefix is null or empty, any prefix matches.
+  // Returns a null pointer if no matching element is found.
+  xmlNodePtr Find(const char* prefix, const char* name) const;
+
+  // Returns the same element as DepthFirstSearch(parent, prefix, name), that
+  // is the first matching element in parent or its descendants. If parent was
+  // not indexed, this falls back to DepthFirstSearch.
+  xmlNodePtr Find(const xmlNodePtr parent, const char* prefix,
+                  const char* name) const;
+
+  // Returns the number of indexed elements.
+  size_t size() const { return ranges_.size(); }
+
+  // Disallow copying.
+  NodeIndex(const NodeIndex&) = delete;
+  void operator=(const NodeIndex&) = delete;
+
+ private:
+  // An element and its position in a preorder traversal.
+  struct Entry {
+    size_t order;
+    xmlNodePtr node;
+    // The interned namespace prefix; null if the element has none.
+    const xmlChar* prefix;
+  };
+
+  // Takes ownership of dict, which must not be null.
+  explicit NodeIndex(xmlDictPtr dict);
+
+  // Returns an empty index, or null if its dictionary could not be created.
+  static std::unique_ptr<NodeIndex> Create();
+
+  // Adds the elements of the tree rooted at root, in document order.
+  void AddTree(const xmlNodePtr root);
+
+  // Returns the first element with a matching prefix and name whose order is
+  // in [first, last].
+  xmlNodePtr FindInRange(const char* prefix, const char* name, size_t first,
+                         size_t last) const;
+
+  // Interns the names and prefixes of the elements.
+  xmlDictPtr dict_;
+  // Elements by interned local name, in document order.
+  std::unordered_map<const xmlChar*, std::vector<Entry>> elements_;
+  // The preorder position of each element, and that of its last descendant.
+  std::unordered_map<xmlNodePtr, std::pair<size_t, size_t>> ranges_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_NODE_INDEX_H_
@@ -0,0 +1,183 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/node_index.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/search.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kXml[] =
+    "<Root xmlns:A=\"http://a.com/\" xmlns:B=\"http://b.com/\""
+    "    xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+    "  <A:Camera Id=\"0\">"
+    "    <B:Pose>first</B:Pose>"
+    "    <A:Pose>second</A:Pose>"
+    "  </A:Camera>"
+    "  <A:Camera Id=\"1\">"
+    "    <A:Name>camera one</A:Name>"
+    "  </A:Camera>"
+    "  <A:Pose>third</A:Pose>"
+    "  <A:List><rdf:Seq><rdf:li>1</rdf:li><rdf:li>2</rdf:li></rdf:Seq>"
+    "  </A:List>"
+    "</Root>";
+
+xmlDocPtr ParseDoc(const char* xml) {
+  return xmlReadMemory(xml, strlen(xml), nullptr, nullptr, 0);
+}
+
+// Returns the text content of a node.
+string GetContent(const xmlNodePtr node) {
+  xmlChar* content = xmlNodeGetContent(node);
+  const string value = FromXmlChar(content);
+  xmlFree(content);
+  return value;
+}
+
+TEST(NodeIndex, NullInput) {
+  EXPECT_EQ(nullptr, NodeIndex::FromDoc(nullptr));
+  EXPECT_EQ(nullptr, NodeIndex::FromNode(nullptr));
+}
+
+TEST(NodeIndex, FindInDoc) {
+  xmlDocPtr doc = ParseDoc(kXml);
+  ASSERT_NE(nullptr, doc);
+  std::unique_ptr<NodeIndex> index = NodeIndex::FromDoc(doc);
+  ASSERT_NE(nullptr, index);
+  EXPECT_EQ(11u, index->size());
+
+  EXPECT_EQ(xmlDocGetRootElement(doc), index->Find("", "Root"));
+  xmlNodePtr pose = index->Find("", "Pose");
+  ASSERT_NE(nullptr, pose);
+  EXPECT_EQ("first", GetContent(pose));
+  pose = index->Find("A", "Pose");
+  ASSERT_NE(nullptr, pose);
+  EXPECT_EQ("second", GetContent(pose));
+  EXPECT_EQ(nullptr, index->Find("C", "Pose"));
+  EXPECT_EQ(nullptr, index->Find("", "NoSuchNode"));
+
+  xmlFreeDoc(doc);
+}
+
+TEST(NodeIndex, FindUnderParent) {
+  xmlDocPtr doc = ParseDoc(kXml);
+  ASSERT_NE(nullptr, doc);
+  std::unique_ptr<NodeIndex> index = NodeIndex::FromDoc(doc);
+  ASSERT_NE(nullptr, index);
+
+  xmlNodePtr first_camera = index->Find("A", "Camera");
+  ASSERT_NE(nullptr, first_camera);
+  xmlNodePtr second_camera = first_camera->next;
+  while (second_camera->type != XML_ELEMENT_NODE) {
+    second_camera = second_camera->next;
+  }
+
+  // The search includes the parent itself.
+  EXPECT_EQ(first_camera, index->Find(first_camera, "A", "Camera"));
+  EXPECT_EQ(second_camera, index->Find(second_camera, "", "Camera"));
+  EXPECT_EQ(nullptr, index->Find(first_camera, "", "Name"));
+  xmlNodePtr name = index->Find(second_camera, "A", "Name");
+  ASSERT_NE(nullptr, name);
+  EXPECT_EQ("camera one", GetContent(name));
+  // Does not match nodes after the parent's subtree.
+  EXPECT_EQ(nullptr, index->Find(second_camera, "", "Pose"));
+
+  xmlFreeDoc(doc);
+}
+
+TEST(NodeIndex, MatchesDepthFirstSearch) {
+  xmlDocPtr doc = ParseDoc(kXml);
+  ASSERT_NE(nullptr, doc);
+  std::unique_ptr<NodeIndex> index = NodeIndex::FromDoc(doc);
+  ASSERT_NE(nullptr, index);
+
+  const char* prefixes[] = {"", "A", "B", "rdf"};
+  const char* names[] = {"Root", "Camera", "Pose", "Name", "List", "Seq", "li"};
+  xmlNodePtr root = xmlDocGetRootElement(doc);
+  for (xmlNodePtr parent = root->children; parent != nullptr;
+       parent = parent->next) {
+    if (parent->type != XML_ELEMENT_NODE) {
+      continue;
+    }
+    for (const char* prefix : prefixes) {
+      for (const char* name : names) {
+        EXPECT_EQ(DepthFirstSearch(parent, prefix, name),
+                  index->Find(parent, prefix, name))
+            << prefix << ":" << name;
+      }
+    }
+  }
+
+  xmlFreeDoc(doc);
+}
+
+TEST(NodeIndex, FindFromUnindexedNode) {
+  xmlDocPtr doc = ParseDoc(kXml);
+  ASSERT_NE(nullptr, doc);
+  xmlNodePtr camera = DepthFirstSearch(doc, "A", "Camera");
+  ASSERT_NE(nullptr, camera);
+  std::unique_ptr<NodeIndex> index = NodeIndex::FromNode(camera);
+  ASSERT_NE(nullptr, index);
+  EXPECT_EQ(3u, index->size());
+  EXPECT_EQ(nullptr, index->Find("", "Root"));
+
+  // Falls back to a traversal of the tree.
+  xmlNodePtr root = xmlDocGetRootElement(doc);
+  EXPECT_EQ(DepthFirstSearch(root, "A", "Name"),
+            index->Find(root, "A", "Name"));
+
+  xmlFreeDoc(doc);
+}
+
+TEST(NodeIndex, DeserializerWithIndex) {
+  xmlDocPtr doc = ParseDoc(kXml);
+  ASSERT_NE(nullptr, doc);
+  std::unique_ptr<NodeIndex> index = NodeIndex::FromDoc(doc);
+  ASSERT_NE(nullptr, index);
+
+  DeserializerImpl deserializer(xmlDocGetRootElement(doc), index.get());
+  string value;
+  ASSERT_TRUE(deserializer.ParseString("A", "Pose", &value));
+  EXPECT_EQ("second", value);
+
+  std::unique_ptr<Deserializer> camera =
+      deserializer.CreateDeserializer("A", "Camera");
+  ASSERT_NE(nullptr, camera);
+  int id;
+  ASSERT_TRUE(camera->ParseInt("", "Id", &id));
+  EXPECT_EQ(0, id);
+  EXPECT_FALSE(camera->ParseString("A", "Name", &value));
+
+  std::vector<int> values;
+  ASSERT_TRUE(deserializer.ParseIntArray("A", "List", &values));
+  EXPECT_EQ(std::vector<int>({1, 2}), values);
+
+  xmlFreeDoc(doc);
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
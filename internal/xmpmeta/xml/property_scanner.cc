@@ -0,0 +1,182 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_scanner.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+
+#include <libxml/parser.h>
+
+#include "glog/logging.h"
+#include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+// The state of ScanXmpPacketProperties while libxml2 calls back into it.
+struct ScanState {
+  PropertySet* properties = nullptr;
+  StringRef prefix = "";
+  size_t max_value_length = 0;
+  // Depth of the current element, and of the first rdf:Description element
+  // once it is found.
+  int depth = 0;
+  int description_depth = 0;
+  bool description_done = false;
+  // The property whose element text is being collected, its depth, and the
+  // text collected so far.
+  int property_index = -1;
+  int property_depth = 0;
+  string property_text;
+};
+
+bool PrefixMatches(const ScanState& state, const xmlChar* prefix) {
+  return state.prefix.empty() ||
+         (prefix != nullptr && StringRef(FromXmlChar(prefix)) == state.prefix);
+}
+
+// Returns the index of the first property without a value whose name is the
+// given name, or -1.
+int FindMissingProperty(const PropertySet& properties, const xmlChar* name) {
+  for (size_t i = 0; i < properties.size(); ++i) {
+    if (!properties.has_value(i) &&
+        strcmp(FromXmlChar(name), properties.name(i)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Appends up to length bytes of text to value, keeping it within the
+// maximum length.
+void AppendCapped(const ScanState& state, const char* text, size_t length,
+                  string* value) {
+  value->append(text, std::min(length,
+                               state.max_value_length - value->size()));
+}
+
+void ScanStartElement(void* ctx, const xmlChar* localname,
+                      const xmlChar* prefix, const xmlChar* /* uri */,
+                      int /* num_namespaces */,
+                      const xmlChar** /* namespaces */, int num_attributes,
+                      int /* num_defaulted */, const xmlChar** attributes) {
+  ScanState* state = static_cast<ScanState*>(ctx);
+  ++state->depth;
+  if (state->description_done) {
+    return;
+  }
+  if (state->description_depth == 0) {
+    // Like GetFirstDescriptionElement, match on the local name only.
+    if (strcmp(FromXmlChar(localname), XmlConst::RdfDescription()) != 0) {
+      return;
+    }
+    state->description_depth = state->depth;
+    // Each attribute is given as its local name, prefix, URI, and the start
+    // and end of its value.
+    for (int i = 0; i < num_attributes; ++i) {
+      const xmlChar** attribute = &attributes[i * 5];
+      if (!PrefixMatches(*state, attribute[1])) {
+        continue;
+      }
+      const int index = FindMissingProperty(*state->properties, attribute[0]);
+      if (index >= 0) {
+        string value;
+        AppendCapped(*state, FromXmlChar(attribute[3]),
+                     attribute[4] - attribute[3], &value);
+        state->properties->SetValue(index, value);
+      }
+    }
+    return;
+  }
+  if (state->property_index >= 0 || !PrefixMatches(*state, prefix)) {
+    return;
+  }
+  const int index = FindMissingProperty(*state->properties, localname);
+  if (index >= 0) {
+    state->property_index = index;
+    state->property_depth = state->depth;
+    state->property_text.clear();
+  }
+}
+
+void ScanEndElement(void* ctx, const xmlChar* /* localname */,
+                    const xmlChar* /* prefix */, const xmlChar* /* uri */) {
+  ScanState* state = static_cast<ScanState*>(ctx);
+  if (state->property_index >= 0 && state->depth == state->property_depth) {
+    state->properties->SetValue(state->property_index, state->property_text);
+    state->property_index = -1;
+  }
+  if (state->depth == state->description_depth) {
+    // Nothing past the first rdf:Description is read.
+    state->description_done = true;
+  }
+  --state->depth;
+}
+
+void ScanCharacters(void* ctx, const xmlChar* text, int length) {
+  ScanState* state = static_cast<ScanState*>(ctx);
+  if (state->property_index >= 0) {
+    AppendCapped(*state, FromXmlChar(text), length, &state->property_text);
+  }
+}
+
+}  // namespace
+
+bool ScanXmpPacketProperties(const char* xmp_packet, size_t length,
+                             StringRef prefix, size_t max_value_length,
+                             PropertySet* properties) {
+  if (length > INT_MAX) {
+    LOG(ERROR) << "XMP packet too large, size: " << length;
+    return false;
+  }
+  properties->SetPrefix(prefix);
+  xmlSAXHandler handler;
+  memset(&handler, 0, sizeof(handler));
+  handler.initialized = XML_SAX2_MAGIC;
+  handler.startElementNs = ScanStartElement;
+  handler.endElementNs = ScanEndElement;
+  handler.characters = ScanCharacters;
+  handler.cdataBlock = ScanCharacters;
+
+  ScanState state;
+  state.properties = properties;
+  state.prefix = prefix;
+  state.max_value_length = max_value_length;
+  xmlParserCtxtPtr context =
+      xmlCreatePushParserCtxt(&handler, &state, nullptr, 0, nullptr);
+  if (context == nullptr) {
+    LOG(ERROR) << "Could not create XML parser";
+    return false;
+  }
+  xmlParseChunk(context, xmp_packet, static_cast<int>(length), 1);
+  const bool well_formed = context->wellFormed;
+  xmlFreeParserCtxt(context);
+  if (!well_formed) {
+    LOG(WARNING) << "The XMP packet is not well formed";
+    return false;
+  }
+  if (!state.description_done) {
+    LOG(WARNING) << "No complete rdf:Description element in the XMP packet";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
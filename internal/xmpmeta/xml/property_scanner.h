@@ -0,0 +1,43 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_PROPERTY_SCANNER_H_
+#define XMPMETA_XML_PROPERTY_SCANNER_H_
+
+#include <cstddef>
+
+#include "xmpmeta/xml/property_set.h"
+#include "xmpmeta/xml/string_ref.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// Sets the properties of the first rdf:Description element of the given XMP
+// packet, as DeserializerImpl::ParseProperties does on a tree of the packet,
+// but with a SAX parser and without building the tree. A property is read
+// from an attribute of the rdf:Description, or else from the text of the first
+// descendant element of that name. Values longer than max_value_length bytes
+// are cut short, so that no large value is held in memory. The rest of the
+// packet is parsed too, so that a packet that xmlReadMemory rejects because
+// it is not well formed is rejected here as well.
+// Returns false if the packet is not well formed or has no complete
+// rdf:Description element.
+bool ScanXmpPacketProperties(const char* xmp_packet, size_t length,
+                             StringRef prefix, size_t max_value_length,
+                             PropertySet* properties);
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_PROPERTY_SCANNER_H_
@@ -0,0 +1,77 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_scanner.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/xml/property_set.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kPrefix[] = "Prefix";
+const char kAttribute[] = "Attribute";
+const char kElement[] = "Element";
+const char kMissing[] = "Missing";
+const char* const kNames[] = {kAttribute, kElement, kMissing};
+const size_t kMaxValueLength = 8;
+
+const char kPacket[] =
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+    "<rdf:Description xmlns:Prefix=\"http://ns.prefix/\""
+    " xmlns:Other=\"http://ns.other/\""
+    " Prefix:Attribute=\"3\" Other:Element=\"5\">"
+    "<Prefix:Element>abc<![CDATA[def]]>ghijk</Prefix:Element>"
+    "</rdf:Description>"
+    "<rdf:Description xmlns:Prefix=\"http://ns.prefix/\""
+    " Prefix:Missing=\"7\"/>"
+    "</rdf:RDF></x:xmpmeta>";
+
+TEST(PropertyScanner, ScansFirstDescription) {
+  PropertySet properties(kNames);
+  ASSERT_TRUE(ScanXmpPacketProperties(kPacket, sizeof(kPacket) - 1, kPrefix,
+                                      kMaxValueLength, &properties));
+  EXPECT_EQ(kPrefix, properties.prefix());
+  int int_value;
+  ASSERT_TRUE(properties.ParseInt(kPrefix, kAttribute, &int_value));
+  EXPECT_EQ(3, int_value);
+  string value;
+  ASSERT_TRUE(properties.ParseString(kPrefix, kElement, &value));
+  EXPECT_EQ("abcdefgh", value);
+  EXPECT_FALSE(properties.has_value(2));
+}
+
+TEST(PropertyScanner, RejectsMalformedPacket) {
+  // The packet is cut short inside the first rdf:Description.
+  PropertySet properties(kNames);
+  EXPECT_FALSE(ScanXmpPacketProperties(kPacket, 300, kPrefix, kMaxValueLength,
+                                       &properties));
+}
+
+TEST(PropertyScanner, RejectsPacketWithoutDescription) {
+  const char kNoDescription[] =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\"></x:xmpmeta>";
+  PropertySet properties(kNames);
+  EXPECT_FALSE(ScanXmpPacketProperties(kNoDescription,
+                                       sizeof(kNoDescription) - 1, kPrefix,
+                                       kMaxValueLength, &properties));
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
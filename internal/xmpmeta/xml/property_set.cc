@@ -0,0 +1,127 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_set.h"
+
+#include <cstring>
+
+#include "strings/case.h"
+#include "strings/numbers.h"
+#include "xmpmeta/base64.h"
+
+namespace xmpmeta {
+namespace xml {
+
+PropertySet::PropertySet(const char* const* names, size_t num_names)
+    : names_(names),
+      num_names_(num_names),
+      values_(num_names),
+      found_(num_names, false) {}
+
+void PropertySet::SetPrefix(StringRef prefix) { prefix_ = prefix.ToString(); }
+
+void PropertySet::SetValue(size_t index, const string& value) {
+  copied_values_.push_back(value);
+  SetValueRef(index, copied_values_.back());
+}
+
+void PropertySet::SetValueRef(size_t index, StringRef value) {
+  values_[index] = value;
+  found_[index] = true;
+}
+
+const StringRef* PropertySet::GetValue(StringRef prefix,
+                                       StringRef name) const {
+  if (StringRef(prefix_) != prefix) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < num_names_; ++i) {
+    // Callers usually pass the same constant as the table.
+    if (names_[i] == name.data() || strcmp(names_[i], name.c_str()) == 0) {
+      return found_[i] ? &values_[i] : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+bool PropertySet::ParseBase64(StringRef prefix, StringRef name,
+                              string* value) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  return value_str != nullptr && DecodeBase64(value_str->ToString(), value);
+}
+
+bool PropertySet::ParseIntArrayBase64(StringRef prefix, StringRef name,
+                                      std::vector<int>& values) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  return value_str != nullptr &&
+         DecodeIntArrayBase64(value_str->ToString(), values);
+}
+
+bool PropertySet::ParseFloatArrayBase64(StringRef prefix, StringRef name,
+                                        std::vector<float>& values) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  return value_str != nullptr &&
+         DecodeFloatArrayBase64(value_str->ToString(), values);
+}
+
+bool PropertySet::ParseBoolean(StringRef prefix, StringRef name,
+                               bool* value) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  if (value_str == nullptr) {
+    return false;
+  }
+  if (strcasecmp(value_str->c_str(), "true") == 0) {
+    *value = true;
+    return true;
+  }
+  if (strcasecmp(value_str->c_str(), "false") == 0) {
+    *value = false;
+    return true;
+  }
+  return false;
+}
+
+bool PropertySet::ParseDouble(StringRef prefix, StringRef name,
+                              double* value) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  return value_str != nullptr &&
+         safe_strtod(value_str->data(), value_str->size(), value);
+}
+
+bool PropertySet::ParseInt(StringRef prefix, StringRef name,
+                           int* value) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  return value_str != nullptr &&
+         safe_strto32(value_str->data(), value_str->size(), value);
+}
+
+bool PropertySet::ParseLong(StringRef prefix, StringRef name,
+                            int64* value) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  return value_str != nullptr &&
+         safe_strto64(value_str->data(), value_str->size(), value);
+}
+
+bool PropertySet::ParseString(StringRef prefix, StringRef name,
+                              string* value) const {
+  const StringRef* value_str = GetValue(prefix, name);
+  if (value_str == nullptr) {
+    return false;
+  }
+  value->assign(value_str->data(), value_str->size());
+  return true;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
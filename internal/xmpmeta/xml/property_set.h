@@ -0,0 +1,103 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_PROPERTY_SET_H_
+#define XMPMETA_XML_PROPERTY_SET_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/port.h"
+#include "xmpmeta/xml/string_ref.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// The values of a fixed table of properties that share one prefix, filled in
+// by Deserializer::ParseProperties in a single pass over a node, instead of
+// one lookup per property. Offers the Deserializer parsers for the properties
+// in the table, with the same results. Lists, such as the rdf:Seq read by
+// ParseIntArray, are not held in the table and are still read from the
+// Deserializer, as are elements that read a single property.
+// Example:
+//   const char* const kPropertyNames[] = {kPositionX, kPositionY};
+//   PropertySet properties(kPropertyNames);
+//   deserializer.ParseProperties(prefix, &properties);
+//   double x;
+//   properties.ParseDouble(prefix, kPositionX, &x);
+class PropertySet {
+ public:
+  // The names must outlive this object.
+  PropertySet(const char* const* names, size_t num_names);
+  template <size_t N>
+  explicit PropertySet(const char* const (&names)[N])
+      : PropertySet(names, N) {}
+
+  size_t size() const { return num_names_; }
+  const char* name(size_t index) const { return names_[index]; }
+
+  // Returns true if a value was set for the property at the given index.
+  bool has_value(size_t index) const { return found_[index]; }
+
+  // Sets the prefix shared by the properties, which ParseProperties does
+  // before it sets their values.
+  void SetPrefix(StringRef prefix);
+  const string& prefix() const { return prefix_; }
+
+  // Sets the value of the property at the given index to a copy of value.
+  void SetValue(size_t index, const string& value);
+
+  // Same as above, but refers to value in place instead of copying it, e.g.
+  // to the text of an XML node. The text must outlive this object.
+  void SetValueRef(size_t index, StringRef value);
+
+  // Parsers for the properties in the table, which mirror the Deserializer
+  // interface. Returns false if prefix is not the prefix of the table, or if
+  // name is not in the table or has no valid value.
+  bool ParseBase64(StringRef prefix, StringRef name, string* value) const;
+  bool ParseIntArrayBase64(StringRef prefix, StringRef name,
+                           std::vector<int>& values) const;
+  bool ParseFloatArrayBase64(StringRef prefix, StringRef name,
+                             std::vector<float>& values) const;
+  bool ParseBoolean(StringRef prefix, StringRef name, bool* value) const;
+  bool ParseDouble(StringRef prefix, StringRef name, double* value) const;
+  bool ParseInt(StringRef prefix, StringRef name, int* value) const;
+  bool ParseLong(StringRef prefix, StringRef name, int64* value) const;
+  bool ParseString(StringRef prefix, StringRef name, string* value) const;
+
+  // Disallow copying, which would leave the values referring to the copied
+  // values of the original.
+  PropertySet(const PropertySet&) = delete;
+  void operator=(const PropertySet&) = delete;
+
+ private:
+  // Returns the value of the given property, or null if it has none.
+  const StringRef* GetValue(StringRef prefix, StringRef name) const;
+
+  const char* const* names_;
+  size_t num_names_;
+  string prefix_;
+  std::vector<StringRef> values_;
+  std::vector<bool> found_;
+  // The values set with SetValue(), which values_ refers to. A deque does not
+  // move its elements as it grows.
+  std::deque<string> copied_values_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_PROPERTY_SET_H_
@@ -0,0 +1,153 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/property_set.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/base64.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kPrefix[] = "Prefix";
+const char kBoolean[] = "Boolean";
+const char kDouble[] = "Double";
+const char kInt[] = "Int";
+const char kLong[] = "Long";
+const char kString[] = "String";
+const char* const kNames[] = {kBoolean, kDouble, kInt, kLong, kString};
+
+TEST(PropertySet, NoValues) {
+  PropertySet properties(kNames);
+  ASSERT_EQ(5u, properties.size());
+  EXPECT_STREQ(kInt, properties.name(2));
+  for (size_t i = 0; i < properties.size(); ++i) {
+    EXPECT_FALSE(properties.has_value(i));
+  }
+  string value;
+  EXPECT_FALSE(properties.ParseString(kPrefix, kString, &value));
+  EXPECT_FALSE(properties.ParseString(kPrefix, "NotInTable", &value));
+}
+
+TEST(PropertySet, ParseValues) {
+  PropertySet properties(kNames);
+  properties.SetPrefix(kPrefix);
+  properties.SetValue(0, "True");
+  properties.SetValue(1, "1.5");
+  properties.SetValue(2, "-42");
+  properties.SetValue(3, "123456789012");
+  properties.SetValue(4, "");
+
+  bool bool_value;
+  ASSERT_TRUE(properties.ParseBoolean(kPrefix, kBoolean, &bool_value));
+  EXPECT_TRUE(bool_value);
+  double double_value;
+  ASSERT_TRUE(properties.ParseDouble(kPrefix, kDouble, &double_value));
+  EXPECT_EQ(1.5, double_value);
+  int int_value;
+  ASSERT_TRUE(properties.ParseInt(kPrefix, kInt, &int_value));
+  EXPECT_EQ(-42, int_value);
+  int64 long_value;
+  ASSERT_TRUE(properties.ParseLong(kPrefix, kLong, &long_value));
+  EXPECT_EQ(123456789012LL, long_value);
+  // An empty value is still a value.
+  string string_value = "unchanged";
+  ASSERT_TRUE(properties.ParseString(kPrefix, kString, &string_value));
+  EXPECT_EQ("", string_value);
+
+  // Names are matched by content, not only by pointer.
+  const string int_name(kInt);
+  ASSERT_TRUE(properties.ParseInt(kPrefix, int_name, &int_value));
+  EXPECT_EQ(-42, int_value);
+
+  // The values are only those of the table's prefix.
+  EXPECT_FALSE(properties.ParseInt("Other", kInt, &int_value));
+  EXPECT_FALSE(properties.ParseInt("", kInt, &int_value));
+  EXPECT_FALSE(properties.ParseString("Prefi", kString, &string_value));
+}
+
+TEST(PropertySet, ParseInvalidValues) {
+  PropertySet properties(kNames);
+  properties.SetPrefix(kPrefix);
+  properties.SetValue(0, "yes");
+  properties.SetValue(1, "abc");
+  properties.SetValue(2, "1.5");
+
+  bool bool_value;
+  EXPECT_FALSE(properties.ParseBoolean(kPrefix, kBoolean, &bool_value));
+  double double_value;
+  EXPECT_FALSE(properties.ParseDouble(kPrefix, kDouble, &double_value));
+  int int_value;
+  EXPECT_FALSE(properties.ParseInt(kPrefix, kInt, &int_value));
+}
+
+TEST(PropertySet, ParseBase64Values) {
+  const char kData[] = "Data";
+  const char kInts[] = "Ints";
+  const char kFloats[] = "Floats";
+  const char* const names[] = {kData, kInts, kFloats};
+  PropertySet properties(names);
+  properties.SetPrefix(kPrefix);
+  string encoded;
+  ASSERT_TRUE(EncodeBase64("abc", &encoded));
+  properties.SetValue(0, encoded);
+  const std::vector<int> ints = {1, -2, 3};
+  ASSERT_TRUE(EncodeIntArrayBase64(ints, &encoded));
+  properties.SetValue(1, encoded);
+  const std::vector<float> floats = {1.5f, -2.25f};
+  ASSERT_TRUE(EncodeFloatArrayBase64(floats, &encoded));
+  properties.SetValue(2, encoded);
+
+  string data;
+  ASSERT_TRUE(properties.ParseBase64(kPrefix, kData, &data));
+  EXPECT_EQ("abc", data);
+  std::vector<int> int_values;
+  ASSERT_TRUE(properties.ParseIntArrayBase64(kPrefix, kInts, int_values));
+  EXPECT_EQ(ints, int_values);
+  std::vector<float> float_values;
+  ASSERT_TRUE(
+      properties.ParseFloatArrayBase64(kPrefix, kFloats, float_values));
+  EXPECT_EQ(floats, float_values);
+
+  properties.SetValue(0, "!!!");
+  EXPECT_FALSE(properties.ParseBase64(kPrefix, kData, &data));
+  EXPECT_FALSE(properties.ParseBase64("Other", kInts, &data));
+}
+
+TEST(PropertySet, SetValueRef) {
+  // A value set by reference is read in place, and one set by copy outlives
+  // the given string.
+  const char kText[] = "17";
+  PropertySet properties(kNames);
+  properties.SetPrefix(kPrefix);
+  properties.SetValueRef(2, kText);
+  {
+    const string value = "2.5";
+    properties.SetValue(1, value);
+  }
+  int int_value;
+  ASSERT_TRUE(properties.ParseInt(kPrefix, kInt, &int_value));
+  EXPECT_EQ(17, int_value);
+  double double_value;
+  ASSERT_TRUE(properties.ParseDouble(kPrefix, kDouble, &double_value));
+  EXPECT_EQ(2.5, double_value);
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
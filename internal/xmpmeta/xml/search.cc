@@ -15,12 +15,10 @@
 #include "xmpmeta/xml/search.h"
 
 #include <string>
-#include <stack>
+#include <vector>
 
 #include "glog/logging.h"
-#include "xmpmeta/xml/utils.h"
-
-using xmpmeta::xml::FromXmlChar;
+#include "xmpmeta/xml/interned_name.h"
 
 namespace xmpmeta {
 namespace xml {
@@ -57,28 +55,24 @@ xmlNodePtr DepthFirstSearch(const xmlNodePtr parent, const char* prefix,
     LOG(ERROR) << "XML node was null";
     return nullptr;
   }
-  std::stack<xmlNodePtr> node_stack;
-  node_stack.push(parent);
+  // The name is looked up once, so that each node is matched by comparing
+  // pointers.
+  const InternedName node_name(parent->doc, name);
+  PrefixMatcher prefix_matcher(prefix);
+  // One stack for the whole search. Children are pushed last to first, so
+  // that the first child is visited next.
+  std::vector<xmlNodePtr> node_stack;
+  node_stack.push_back(parent);
   while (!node_stack.empty()) {
-    const xmlNodePtr current_node = node_stack.top();
-    node_stack.pop();
-    if (strcmp(FromXmlChar(current_node->name), name) == 0) {
-      if (!prefix || strlen(prefix) == 0) {
-        return current_node;
-      }
-      if (current_node->ns && current_node->ns->prefix &&
-          strcmp(FromXmlChar(current_node->ns->prefix), prefix) == 0) {
-        return current_node;
-      }
-    }
-    std::stack<xmlNodePtr> stack_to_reverse;
-    for (xmlNodePtr child = current_node->children; child != nullptr;
-         child = child->next) {
-      stack_to_reverse.push(child);
+    const xmlNodePtr current_node = node_stack.back();
+    node_stack.pop_back();
+    if (node_name.Matches(current_node->name) &&
+        prefix_matcher.Matches(current_node->ns)) {
+      return current_node;
     }
-    while (!stack_to_reverse.empty()) {
-      node_stack.push(stack_to_reverse.top());
-      stack_to_reverse.pop();
+    for (xmlNodePtr child = current_node->last; child != nullptr;
+         child = child->prev) {
+      node_stack.push_back(child);
     }
   }
   return nullptr;
@@ -20,11 +20,14 @@
 #include <vector>
 
 #include "base/port.h"
+#include "xmpmeta/xml/string_ref.h"
 
 namespace xmpmeta {
 namespace xml {
 
 // Serializes properties for a hierarchy of objects.
+// Prefixes, names and property values are passed as StringRef, so string
+// literals and constants are not copied into temporary strings.
 // Example:
 //  BookSerializer serializer();
 //  // Serialize a list of objects.
@@ -55,13 +58,11 @@ class Serializer {
 
   // Returns a Serializer for an object that is an item in a list.
   virtual std::unique_ptr<Serializer>
-      CreateItemSerializer(const string& prefix,
-                           const string& item_name) const = 0;
+      CreateItemSerializer(StringRef prefix, StringRef item_name) const = 0;
 
   // Returns a Serializer for a list of objects.
   virtual std::unique_ptr<Serializer>
-      CreateListSerializer(const string& prefix,
-                           const string& list_name) const = 0;
+      CreateListSerializer(StringRef prefix, StringRef list_name) const = 0;
 
   // Creates a serializer from the current serializer.
   // node_ns_name is the XML namespace to which the newly created node belongs.
@@ -70,20 +71,22 @@ class Serializer {
   // node_name is the name of the new node. This paramter cannot be an empty
   // string.
   virtual std::unique_ptr<Serializer>
-      CreateSerializer(const string& node_ns_name,
-                       const string& node_name) const = 0;
+      CreateSerializer(StringRef node_ns_name, StringRef node_name) const = 0;
 
   // Serializes a property with the given prefix.
   // Example: <NodeName PropertyPrefix:PropertyName="PropertyValue" />
-  virtual bool WriteBoolProperty(const string& prefix, const string& name,
+  virtual bool WriteBoolProperty(StringRef prefix, StringRef name,
                                  bool value) const = 0;
-  virtual bool WriteProperty(const string& prefix, const string& name,
-                             const string& value) const = 0;
+  // Writes the shortest string that reads back as the same double.
+  virtual bool WriteDoubleProperty(StringRef prefix, StringRef name,
+                                   double value) const = 0;
+  virtual bool WriteProperty(StringRef prefix, StringRef name,
+                             StringRef value) const = 0;
 
   // Serializes the collection of values.
-  virtual bool WriteIntArray(const string& prefix, const string& array_name,
+  virtual bool WriteIntArray(StringRef prefix, StringRef array_name,
                              const std::vector<int>& values) const = 0;
-  virtual bool WriteDoubleArray(const string& prefix, const string& array_name,
+  virtual bool WriteDoubleArray(StringRef prefix, StringRef array_name,
                                 const std::vector<double>& values) const = 0;
 };
 
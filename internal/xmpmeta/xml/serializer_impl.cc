@@ -14,6 +14,11 @@
 
 #include "serializer_impl.h"
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
 #include <libxml/tree.h>
 
 #include "base/integral_types.h"
@@ -24,32 +29,93 @@
 
 namespace xmpmeta {
 namespace xml {
+namespace {
+
+typedef std::pair<string, xmlNsPtr> NamespaceEntry;
+
+// Orders the entries by prefix, as strings are ordered.
+bool PrefixLess(const NamespaceEntry& entry, StringRef prefix) {
+  const int result = memcmp(entry.first.data(), prefix.data(),
+                            std::min(entry.first.size(), prefix.size()));
+  return result < 0 || (result == 0 && entry.first.size() < prefix.size());
+}
+
+}  // namespace
+
+// A sorted array of the namespaces, which is searched without creating string
+// temporaries, and which is never modified after construction so that all the
+// serializers of a document can share it.
+class SerializerImpl::NamespaceTable {
+ public:
+  explicit NamespaceTable(
+      const std::unordered_map<string, xmlNsPtr>& namespaces)
+      : entries_(namespaces.begin(), namespaces.end()) {
+    // Namespaces are declared in the order of the given map.
+    for (const NamespaceEntry& entry : entries_) {
+      declaration_order_.push_back(entry.second);
+    }
+    std::sort(entries_.begin(), entries_.end());
+    rdf_ns_ = Find(XmlConst::RdfPrefix());
+  }
+
+  // Returns the namespace for the given prefix, or null if there is none.
+  xmlNsPtr Find(StringRef prefix) const {
+    const auto entry = std::lower_bound(entries_.begin(), entries_.end(),
+                                        prefix, PrefixLess);
+    if (entry == entries_.end() || StringRef(entry->first) != prefix) {
+      return nullptr;
+    }
+    return entry->second;
+  }
+
+  // Returns the RDF namespace, or null if there is none.
+  xmlNsPtr rdf_ns() const { return rdf_ns_; }
+
+  // Returns the namespaces in the order in which they are declared.
+  const std::vector<xmlNsPtr>& declaration_order() const {
+    return declaration_order_;
+  }
+
+  // Disallow copying.
+  NamespaceTable(const NamespaceTable&) = delete;
+  void operator=(const NamespaceTable&) = delete;
+
+ private:
+  std::vector<NamespaceEntry> entries_;
+  std::vector<xmlNsPtr> declaration_order_;
+  xmlNsPtr rdf_ns_;
+};
 
 // Methods specific to SerializerImpl.
 SerializerImpl::SerializerImpl(
     const std::unordered_map<string, xmlNsPtr>& namespaces, xmlNodePtr node) :
+    SerializerImpl(std::make_shared<const NamespaceTable>(namespaces), node) {}
+
+SerializerImpl::SerializerImpl(
+    const std::shared_ptr<const NamespaceTable>& namespaces, xmlNodePtr node) :
     node_(node), namespaces_(namespaces) {
   CHECK(node_ != nullptr) << "Node cannot be null";
   CHECK(node_->name != nullptr) << "Name in the XML node cannot be null";
 }
 
 bool SerializerImpl::SerializeNamespaces() {
-  if (namespaces_.empty()) {
+  const std::vector<xmlNsPtr>& namespaces = namespaces_->declaration_order();
+  if (namespaces.empty()) {
     return true;
   }
-  if (node_->ns == nullptr && !namespaces_.empty()) {
+  if (node_->ns == nullptr) {
     return false;
   }
   // Check that the namespaces all have hrefs and that there is a value
   // for the key node_name.
   // Set the namespaces in the root node.
   xmlNsPtr node_ns = node_->ns;
-  for (const auto& entry : namespaces_) {
-    CHECK(entry.second->href != nullptr) << "Namespace href cannot be null";
+  for (xmlNsPtr ns : namespaces) {
+    CHECK(ns->href != nullptr) << "Namespace href cannot be null";
     if (node_ns != nullptr) {
-      node_ns->next = entry.second;
+      node_ns->next = ns;
     }
-    node_ns = entry.second;
+    node_ns = ns;
   }
   return true;
 }
@@ -65,36 +131,44 @@ std::unique_ptr<SerializerImpl> SerializerImpl::FromDataAndSerializeNamespaces(
   return serializer;
 }
 
+bool SerializerImpl::FindNamespace(StringRef prefix, xmlNsPtr* ns) const {
+  *ns = nullptr;
+  if (prefix.empty()) {
+    return true;
+  }
+  *ns = namespaces_->Find(prefix);
+  return *ns != nullptr;
+}
+
 // Implemented methods.
 std::unique_ptr<Serializer>
-SerializerImpl::CreateSerializer(const string& node_ns_name,
-                                 const string& node_name) const {
+SerializerImpl::CreateSerializer(StringRef node_ns_name,
+                                 StringRef node_name) const {
   if (node_name.empty()) {
     LOG(ERROR) << "Node name is empty";
     return nullptr;
   }
 
-  if (namespaces_.count(node_ns_name) == 0 && !node_ns_name.empty()) {
+  xmlNsPtr node_ns;
+  if (!FindNamespace(node_ns_name, &node_ns)) {
     LOG(ERROR) << "Prefix " << node_ns_name << " not found in prefix list";
     return nullptr;
   }
 
-  xmlNodePtr new_node =
-      xmlNewNode(node_ns_name.empty() ? nullptr : namespaces_.at(node_ns_name),
-                 ToXmlChar(node_name.data()));
+  xmlNodePtr new_node = xmlNewNode(node_ns, ToXmlChar(node_name.data()));
   xmlAddChild(node_, new_node);
   return std::unique_ptr<Serializer>(new SerializerImpl(namespaces_, new_node));
 }
 
 std::unique_ptr<Serializer>
-SerializerImpl::CreateItemSerializer(const string& prefix,
-                                     const string& item_name) const {
-  if (namespaces_.count(XmlConst::RdfPrefix()) == 0 ||
-      namespaces_.at(XmlConst::RdfPrefix()) == nullptr) {
+SerializerImpl::CreateItemSerializer(StringRef prefix,
+                                     StringRef item_name) const {
+  if (namespaces_->rdf_ns() == nullptr) {
     LOG(ERROR) << "No RDF prefix namespace found";
     return nullptr;
   }
-  if (!prefix.empty() && !namespaces_.count(prefix)) {
+  xmlNsPtr item_ns;
+  if (!FindNamespace(prefix, &item_ns)) {
     LOG(ERROR) << "No namespace found for " << prefix;
     return nullptr;
   }
@@ -103,12 +177,10 @@ SerializerImpl::CreateItemSerializer(const string& prefix,
     return nullptr;
   }
 
-  xmlNsPtr rdf_prefix_ns = namespaces_.at(string(XmlConst::RdfPrefix()));
+  xmlNsPtr rdf_prefix_ns = namespaces_->rdf_ns();
   xmlNodePtr li_node =
       xmlNewNode(nullptr, ToXmlChar(XmlConst::RdfLi()));
-  xmlNodePtr new_node =
-      xmlNewNode(prefix.empty() ? nullptr : namespaces_.at(prefix),
-                 ToXmlChar(item_name.data()));
+  xmlNodePtr new_node = xmlNewNode(item_ns, ToXmlChar(item_name.data()));
   xmlSetNs(li_node, rdf_prefix_ns);
   xmlAddChild(node_, li_node);
   xmlAddChild(li_node, new_node);
@@ -116,22 +188,20 @@ SerializerImpl::CreateItemSerializer(const string& prefix,
 }
 
 std::unique_ptr<Serializer>
-SerializerImpl::CreateListSerializer(const string& prefix,
-                                     const string& list_name) const {
-  if (namespaces_.count(XmlConst::RdfPrefix()) == 0 ||
-      namespaces_.at(XmlConst::RdfPrefix()) == nullptr) {
+SerializerImpl::CreateListSerializer(StringRef prefix,
+                                     StringRef list_name) const {
+  if (namespaces_->rdf_ns() == nullptr) {
     LOG(ERROR) << "No RDF prefix namespace found";
     return nullptr;
   }
-  if (!prefix.empty() && !namespaces_.count(prefix)) {
+  xmlNsPtr list_ns;
+  if (!FindNamespace(prefix, &list_ns)) {
     LOG(ERROR) << "No namespace found for " << prefix;
     return nullptr;
   }
 
-  xmlNodePtr list_node =
-      xmlNewNode(prefix.empty() ? nullptr : namespaces_.at(prefix),
-                 ToXmlChar(list_name.data()));
-  xmlNsPtr rdf_prefix_ns = namespaces_.at(string(XmlConst::RdfPrefix()));
+  xmlNodePtr list_node = xmlNewNode(list_ns, ToXmlChar(list_name.data()));
+  xmlNsPtr rdf_prefix_ns = namespaces_->rdf_ns();
   xmlNodePtr seq_node = xmlNewNode(nullptr, ToXmlChar(XmlConst::RdfSeq()));
   xmlSetNs(seq_node, rdf_prefix_ns);
   xmlAddChild(list_node, seq_node);
@@ -139,14 +209,19 @@ SerializerImpl::CreateListSerializer(const string& prefix,
   return std::unique_ptr<Serializer>(new SerializerImpl(namespaces_, seq_node));
 }
 
-bool SerializerImpl::WriteBoolProperty(const string& prefix,
-                                       const string& name, bool value) const {
-  const string& bool_str = (value ? "true" : "false");
-  return WriteProperty(prefix, name, bool_str);
+bool SerializerImpl::WriteBoolProperty(StringRef prefix,
+                                       StringRef name, bool value) const {
+  return WriteProperty(prefix, name, value ? "true" : "false");
+}
+
+bool SerializerImpl::WriteDoubleProperty(StringRef prefix,
+                                         StringRef name, double value) const {
+  char buffer[kFastToBufferSize];
+  return WriteProperty(prefix, name, DoubleToBuffer(value, buffer));
 }
 
-bool SerializerImpl::WriteProperty(const string& prefix, const string& name,
-                                   const string& value) const {
+bool SerializerImpl::WriteProperty(StringRef prefix, StringRef name,
+                                   StringRef value) const {
   if (!strcmp(XmlConst::RdfSeq(), FromXmlChar(node_->name))) {
     LOG(ERROR) << "Cannot write a property on an rdf:Seq node";
     return false;
@@ -157,19 +232,19 @@ bool SerializerImpl::WriteProperty(const string& prefix, const string& name,
   }
 
   // Check that prefix has a corresponding namespace href.
-  if (!prefix.empty() && namespaces_.count(prefix) == 0) {
+  xmlNsPtr property_ns;
+  if (!FindNamespace(prefix, &property_ns)) {
     LOG(ERROR) << "No namespace found for prefix " << prefix;
     return false;
   }
 
   // Serialize the property in the format Prefix:Name="Value".
-  xmlSetNsProp(node_, prefix.empty() ? nullptr : namespaces_.at(prefix),
-               ToXmlChar(name.data()), ToXmlChar(value.data()));
+  xmlSetNsProp(node_, property_ns, ToXmlChar(name.data()),
+               ToXmlChar(value.data()));
   return true;
 }
 
-bool SerializerImpl::WriteIntArray(const string& prefix,
-                                   const string& array_name,
+bool SerializerImpl::WriteIntArray(StringRef prefix, StringRef array_name,
                                    const std::vector<int>& values) const {
   if (!strcmp(XmlConst::RdfSeq(), FromXmlChar(node_->name))) {
     LOG(ERROR) << "Cannot write a property on an rdf:Seq node";
@@ -179,12 +254,12 @@ bool SerializerImpl::WriteIntArray(const string& prefix,
     LOG(WARNING) << "No values to write";
     return false;
   }
-  if (namespaces_.count(XmlConst::RdfPrefix()) == 0 ||
-      namespaces_.at(XmlConst::RdfPrefix()) == nullptr) {
+  if (namespaces_->rdf_ns() == nullptr) {
     LOG(ERROR) << "No RDF prefix found";
     return false;
   }
-  if (!prefix.empty() && !namespaces_.count(prefix)) {
+  xmlNsPtr array_ns;
+  if (!FindNamespace(prefix, &array_ns)) {
     LOG(ERROR) << "No namespace found for " << prefix;
     return false;
   }
@@ -194,26 +269,26 @@ bool SerializerImpl::WriteIntArray(const string& prefix,
   }
 
   xmlNodePtr array_parent_node =
-      xmlNewNode(prefix.empty() ? nullptr : namespaces_.at(prefix),
-                 ToXmlChar(array_name.data()));
+      xmlNewNode(array_ns, ToXmlChar(array_name.data()));
   xmlAddChild(node_, array_parent_node);
 
-  xmlNsPtr rdf_prefix_ns = namespaces_.at(XmlConst::RdfPrefix());
+  xmlNsPtr rdf_prefix_ns = namespaces_->rdf_ns();
   xmlNodePtr seq_node = xmlNewNode(nullptr, ToXmlChar(XmlConst::RdfSeq()));
   xmlSetNs(seq_node, rdf_prefix_ns);
   xmlAddChild(array_parent_node, seq_node);
+  char buffer[kFastToBufferSize];
   for (int value : values) {
     xmlNodePtr li_node = xmlNewNode(nullptr, ToXmlChar(XmlConst::RdfLi()));
     xmlSetNs(li_node, rdf_prefix_ns);
     xmlAddChild(seq_node, li_node);
-    xmlNodeSetContent(li_node, ToXmlChar(std::to_string(value).c_str()));
+    FastInt32ToBufferLeft(value, buffer);
+    xmlNodeSetContent(li_node, ToXmlChar(buffer));
   }
 
   return true;
 }
 
-bool SerializerImpl::WriteDoubleArray(const string& prefix,
-                                      const string& array_name,
+bool SerializerImpl::WriteDoubleArray(StringRef prefix, StringRef array_name,
                                       const std::vector<double>& values) const {
   if (!strcmp(XmlConst::RdfSeq(), FromXmlChar(node_->name))) {
     LOG(ERROR) << "Cannot write a property on an rdf:Seq node";
@@ -223,12 +298,12 @@ bool SerializerImpl::WriteDoubleArray(const string& prefix,
     LOG(WARNING) << "No values to write";
     return false;
   }
-  if (namespaces_.count(XmlConst::RdfPrefix()) == 0 ||
-      namespaces_.at(XmlConst::RdfPrefix()) == nullptr) {
+  if (namespaces_->rdf_ns() == nullptr) {
     LOG(ERROR) << "No RDF prefix found";
     return false;
   }
-  if (!prefix.empty() && !namespaces_.count(prefix)) {
+  xmlNsPtr array_ns;
+  if (!FindNamespace(prefix, &array_ns)) {
     LOG(ERROR) << "No namespace found for " << prefix;
     return false;
   }
@@ -238,21 +313,21 @@ bool SerializerImpl::WriteDoubleArray(const string& prefix,
   }
 
   xmlNodePtr array_parent_node =
-      xmlNewNode(prefix.empty() ? nullptr : namespaces_.at(prefix),
-                 ToXmlChar(array_name.data()));
+      xmlNewNode(array_ns, ToXmlChar(array_name.data()));
   xmlAddChild(node_, array_parent_node);
 
-  xmlNsPtr rdf_prefix_ns = namespaces_.at(XmlConst::RdfPrefix());
+  xmlNsPtr rdf_prefix_ns = namespaces_->rdf_ns();
   xmlNodePtr seq_node =
       xmlNewNode(nullptr, ToXmlChar(XmlConst::RdfSeq()));
   xmlSetNs(seq_node, rdf_prefix_ns);
   xmlAddChild(array_parent_node, seq_node);
-  for (float value : values) {
+  char buffer[kFastToBufferSize];
+  for (double value : values) {
     xmlNodePtr li_node =
         xmlNewNode(nullptr, ToXmlChar(XmlConst::RdfLi()));
     xmlSetNs(li_node, rdf_prefix_ns);
     xmlAddChild(seq_node, li_node);
-    xmlNodeSetContent(li_node, ToXmlChar(SimpleFtoa(value).c_str()));
+    xmlNodeSetContent(li_node, ToXmlChar(DoubleToBuffer(value, buffer)));
   }
 
   return true;
@@ -15,6 +15,7 @@
 #ifndef XMPMETA_XML_SERIALIZER_IMPL_H_
 #define XMPMETA_XML_SERIALIZER_IMPL_H_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -122,7 +123,8 @@ class SerializerImpl : public Serializer {
   // xmlDocPtr will own all namespace and node pointers.
   // The namespaces parameter is a map of node names to full namespaces.
   // This contains all the namespaces (nodes and properties) that will be used
-  // in serialization.
+  // in serialization. It is copied once into an immutable table that is
+  // shared by all the serializers created from this one.
   // The node parameter is the caller node. This will be the node in which
   // serialization takes place in WriteProperties.
   SerializerImpl(const std::unordered_map<string, xmlNsPtr>& namespaces,
@@ -132,8 +134,8 @@ class SerializerImpl : public Serializer {
   // of objects.
   // The parent serializer must be created with CreateListSerializer.
   std::unique_ptr<Serializer>
-      CreateItemSerializer(const string& prefix,
-                           const string& item_name) const override;
+      CreateItemSerializer(StringRef prefix,
+                           StringRef item_name) const override;
 
   // Returns a new Serializer for a list of objects that correspond to an
   // rdf:Seq XML node, where each object is to be serialized as a child node of
@@ -141,15 +143,15 @@ class SerializerImpl : public Serializer {
   // The serializer is created on an rdf:Seq node, which is the child of a
   // newly created XML node with the name list_name.
   std::unique_ptr<Serializer>
-      CreateListSerializer(const string& prefix,
-                           const string& list_name) const override;
+      CreateListSerializer(StringRef prefix,
+                           StringRef list_name) const override;
 
   // Creates a serializer from the current serializer.
   // @param node_name The name of the caller node. This will be the parent of
   // any new nodes or properties set by this serializer.
   std::unique_ptr<Serializer>
-      CreateSerializer(const string& node_ns_name,
-                       const string& node_name) const override;
+      CreateSerializer(StringRef node_ns_name,
+                       StringRef node_name) const override;
 
   // Writes the property into the current node, prefixed with prefix if it
   // has a corresponding namespace href in namespaces_, fails otherwise.
@@ -157,15 +159,17 @@ class SerializerImpl : public Serializer {
   // If prefix is empty, the property will not be set on an XML namespace.
   // name must not be empty.
   // value may be empty.
-  bool WriteBoolProperty(const string& prefix, const string& name,
+  bool WriteBoolProperty(StringRef prefix, StringRef name,
                          bool value) const override;
-  bool WriteProperty(const string& prefix, const string& name,
-                     const string& value) const override;
+  bool WriteDoubleProperty(StringRef prefix, StringRef name,
+                           double value) const override;
+  bool WriteProperty(StringRef prefix, StringRef name,
+                     StringRef value) const override;
 
   // Writes the collection of numbers into a child rdf:Seq node.
-  bool WriteIntArray(const string& prefix, const string& array_name,
+  bool WriteIntArray(StringRef prefix, StringRef array_name,
                      const std::vector<int>& values) const override;
-  bool WriteDoubleArray(const string& prefix, const string& array_name,
+  bool WriteDoubleArray(StringRef prefix, StringRef array_name,
                         const std::vector<double>& values) const override;
 
   // Class-specific methods.
@@ -179,13 +183,24 @@ class SerializerImpl : public Serializer {
   void operator=(const SerializerImpl&) = delete;
 
  private:
+  // The namespaces of a document, ordered by prefix.
+  class NamespaceTable;
+
+  // Creates a serializer that shares its parent's namespace table.
+  SerializerImpl(const std::shared_ptr<const NamespaceTable>& namespaces,
+                 xmlNodePtr node);
+
   // Writes the xmlNsPtr objects in namespaces_ to node_.
-  // Modifies namespaces_ by setting each xmlNsPtr's next pointer to the
-  // subsequent entry in the collection.
+  // Modifies the namespaces by setting each xmlNsPtr's next pointer to the
+  // subsequent entry in the table.
   bool SerializeNamespaces();
 
+  // Sets ns to the namespace for the given prefix, or to null if prefix is
+  // empty. Returns false if prefix is not empty and has no namespace.
+  bool FindNamespace(StringRef prefix, xmlNsPtr* ns) const;
+
   xmlNodePtr node_;
-  std::unordered_map<string, xmlNsPtr> namespaces_;
+  std::shared_ptr<const NamespaceTable> namespaces_;
 };
 
 }  // namespace xml
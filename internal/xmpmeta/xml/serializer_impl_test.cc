@@ -202,6 +202,40 @@ TEST(SerializerImpl, CreateItemSerializer) {
   xmlFreeNode(node);
 }
 
+TEST(SerializerImpl, ChildSerializersShareNamespaces) {
+  bool add_rdf_namespace = true;
+  std::unordered_map<string, xmlNsPtr> namespaces =
+      CreateNamespaces(add_rdf_namespace);
+  std::unordered_map<string, xmlNsPtr> namespaces_copy = namespaces;
+  xmlNodePtr node = xmlNewNode(nullptr, ToXmlChar(kPrefixOne));
+  std::unique_ptr<SerializerImpl> initial_serializer(
+      new SerializerImpl(namespaces_copy, node));
+  // The serializers created below do not depend on the map or on their
+  // parent serializer.
+  namespaces_copy.clear();
+  std::unique_ptr<Serializer> list_serializer =
+      initial_serializer->CreateListSerializer(kPrefixOne, "ListName");
+  initial_serializer.reset();
+  ASSERT_NE(nullptr, list_serializer);
+
+  std::unique_ptr<Serializer> item_serializer =
+      list_serializer->CreateItemSerializer(kPrefixTwo, "ItemName");
+  ASSERT_NE(nullptr, item_serializer);
+  EXPECT_TRUE(item_serializer->WriteProperty(kPrefixThree, "Name", "Value"));
+  EXPECT_FALSE(item_serializer->WriteProperty("NoPrefix", "Name", "Value"));
+
+  xmlNodePtr item_node = DepthFirstSearch(node, kPrefixTwo, "ItemName");
+  ASSERT_NE(nullptr, item_node);
+  ASSERT_NE(nullptr, item_node->ns);
+  EXPECT_EQ(namespaces.at(kPrefixTwo), item_node->ns);
+  xmlNodePtr li_node = item_node->parent;
+  ASSERT_NE(nullptr, li_node);
+  EXPECT_EQ(namespaces.at(XmlConst::RdfPrefix()), li_node->ns);
+
+  FreeXmlNamespaces(namespaces);
+  xmlFreeNode(node);
+}
+
 TEST(SerializerImpl, WritePropertyNullChildNode) {
   bool add_rdf_namespace = false;
   std::unordered_map<string, xmlNsPtr> namespaces =
@@ -277,6 +311,39 @@ TEST(SerializerImpl, WriteProperty) {
   xmlFreeNode(node);
 }
 
+TEST(SerializerImpl, WriteDoubleProperty) {
+  bool add_rdf_namespace = false;
+  std::unordered_map<string, xmlNsPtr> namespaces =
+      CreateNamespaces(add_rdf_namespace);
+  xmlNodePtr node = xmlNewNode(nullptr, ToXmlChar(kPrefixOne));
+  SerializerImpl initial_serializer(namespaces, node);
+  std::unique_ptr<Serializer> serializer =
+      initial_serializer.CreateSerializer(kPrefixOne, kPrefixTwo);
+
+  // Written in the shortest form that reads back as the same double.
+  const char* property_name = "Name";
+  ASSERT_TRUE(serializer->WriteDoubleProperty(kPrefixTwo, property_name,
+                                              -85.32));
+  xmlNodePtr node_one = DepthFirstSearch(node, kPrefixTwo);
+  DeserializerImpl deserializer(node_one);
+  string value;
+  ASSERT_TRUE(deserializer.ParseString(kPrefixTwo, property_name, &value));
+  EXPECT_EQ("-85.32", value);
+
+  const double property_value = 1.0 / 3;
+  ASSERT_TRUE(serializer->WriteDoubleProperty(kPrefixTwo, property_name,
+                                              property_value));
+  ASSERT_TRUE(deserializer.ParseString(kPrefixTwo, property_name, &value));
+  EXPECT_EQ("0.3333333333333333", value);
+  double double_value;
+  ASSERT_TRUE(deserializer.ParseDouble(kPrefixTwo, property_name,
+                                       &double_value));
+  EXPECT_EQ(property_value, double_value);
+
+  FreeXmlNamespaces(namespaces);
+  xmlFreeNode(node);
+}
+
 TEST(SerializerImpl, WriteDoubleArrayNoRdfPrefix) {
   bool add_rdf_namespace = false;
   std::unordered_map<string, xmlNsPtr> namespaces =
@@ -476,6 +543,41 @@ TEST(SerializerImpl, WriteDoubleArray) {
   xmlFreeNode(node);
 }
 
+TEST(SerializerImpl, WriteDoubleArrayRoundTrips) {
+  bool add_rdf_namespace = true;
+  std::unordered_map<string, xmlNsPtr> namespaces =
+      CreateNamespaces(add_rdf_namespace);
+  xmlNodePtr node = xmlNewNode(nullptr, ToXmlChar(kPrefixOne));
+  SerializerImpl initial_serializer(namespaces, node);
+  std::unique_ptr<Serializer> serializer =
+      initial_serializer.CreateSerializer(kPrefixThree, kPrefixTwo);
+
+  // None of these survive a conversion to float.
+  const std::vector<double> values = { 0.1 + 0.2, -135.20341, 1e-300, 1e22 };
+  const std::vector<string> expected_strings = {
+      "0.30000000000000004", "-135.20341", "1e-300", "1e+22" };
+  const string parent_name("Parent");
+  ASSERT_TRUE(serializer->WriteDoubleArray(kPrefixTwo, parent_name, values));
+
+  xmlNodePtr seq_node = DepthFirstSearch(node, "Seq");
+  int i = 0;
+  for (xmlNodePtr li_node = GetElementAt(seq_node, i);
+       li_node != nullptr;
+       li_node = GetElementAt(seq_node, ++i)) {
+    EXPECT_EQ(expected_strings.at(i), GetLiNodeContent(li_node));
+  }
+  ASSERT_EQ(4, i);
+
+  DeserializerImpl deserializer(node);
+  std::vector<double> read_values;
+  ASSERT_TRUE(deserializer.ParseDoubleArray(kPrefixTwo, parent_name,
+                                            &read_values));
+  EXPECT_EQ(values, read_values);
+
+  FreeXmlNamespaces(namespaces);
+  xmlFreeNode(node);
+}
+
 }  // namespace
 }  // namespace xml
 }  // namespace xmpmeta
@@ -0,0 +1,543 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/stream_serializer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "glog/logging.h"
+#include "strings/numbers.h"
+#include "xmpmeta/xml/const.h"
+#include "xmpmeta/xmp_const.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kNamespacePrefix[] = "xmlns";
+
+// libxml's formatted output indents by two spaces per level, up to this many
+// levels.
+const size_t kIndentSize = 2;
+const size_t kMaxIndentLevel = 30;
+
+// Returns prefix:name, or name if prefix is empty.
+string QualifiedName(StringRef prefix, StringRef name) {
+  string qualified_name;
+  qualified_name.reserve(prefix.size() + name.size() + 1);
+  if (!prefix.empty()) {
+    qualified_name.append(prefix.data(), prefix.size());
+    qualified_name.push_back(':');
+  }
+  qualified_name.append(name.data(), name.size());
+  return qualified_name;
+}
+
+// Appends value escaped as libxml escapes text content, or attribute values if
+// attribute is true.
+void AppendEscaped(StringRef value, bool attribute, string* output) {
+  const char* const end = value.data() + value.size();
+  const char* run = value.data();
+  for (const char* c = value.data(); c != end; ++c) {
+    const char* entity;
+    switch (*c) {
+      case '&':
+        entity = "&amp;";
+        break;
+      case '<':
+        entity = "&lt;";
+        break;
+      case '>':
+        entity = "&gt;";
+        break;
+      case '\r':
+        entity = "&#13;";
+        break;
+      case '"':
+        entity = attribute ? "&quot;" : nullptr;
+        break;
+      case '\n':
+        entity = attribute ? "&#10;" : nullptr;
+        break;
+      case '\t':
+        entity = attribute ? "&#9;" : nullptr;
+        break;
+      default:
+        entity = nullptr;
+    }
+    if (entity != nullptr) {
+      output->append(run, c - run);
+      output->append(entity);
+      run = c + 1;
+    }
+  }
+  output->append(run, end - run);
+}
+
+// Orders the declared prefixes as strings are ordered.
+bool PrefixLess(const string& declared_prefix, StringRef prefix) {
+  const int result = memcmp(declared_prefix.data(), prefix.data(),
+                            std::min(declared_prefix.size(), prefix.size()));
+  return result < 0 ||
+      (result == 0 && declared_prefix.size() < prefix.size());
+}
+
+}  // namespace
+
+// Appends the text of a document to the output, keeping the stack of elements
+// that are open. An element's start tag is left open until it gets content, so
+// that properties can be added to it as attributes.
+class StreamSerializer::Writer {
+ public:
+  Writer(const std::unordered_map<string, string>& namespaces, string* output)
+      : seq_name_(QualifiedName(XmlConst::RdfPrefix(), XmlConst::RdfSeq())),
+        next_id_(0),
+        output_(output) {
+    prefixes_.reserve(namespaces.size());
+    for (const auto& entry : namespaces) {
+      prefixes_.push_back(entry.first);
+    }
+    std::sort(prefixes_.begin(), prefixes_.end());
+  }
+
+  // Returns true if prefix is empty or has a namespace.
+  bool HasNamespace(StringRef prefix) const {
+    if (prefix.empty()) {
+      return true;
+    }
+    const auto declared = std::lower_bound(prefixes_.begin(), prefixes_.end(),
+                                           prefix, PrefixLess);
+    return declared != prefixes_.end() && StringRef(*declared) == prefix;
+  }
+
+  // Adds a prefix whose namespace the caller declares.
+  void AddNamespace(StringRef prefix) {
+    const auto declared = std::lower_bound(prefixes_.begin(), prefixes_.end(),
+                                           prefix, PrefixLess);
+    if (declared == prefixes_.end() || StringRef(*declared) != prefix) {
+      prefixes_.insert(declared, prefix.ToString());
+    }
+  }
+
+  // Returns true if the element with the given id is open at the given depth.
+  bool IsOpen(size_t depth, size_t id) const {
+    return depth < elements_.size() && elements_[depth].id == id;
+  }
+
+  size_t GetId(size_t depth) const { return elements_[depth].id; }
+
+  // Returns true if the element at the given depth is an rdf:Seq.
+  bool IsSeq(size_t depth) const {
+    return depth < elements_.size() && elements_[depth].name == seq_name_;
+  }
+
+  // Returns true if attributes can still be added to the innermost element.
+  bool IsStartTagOpen() const {
+    return !elements_.empty() && elements_.back().start_tag_open;
+  }
+
+  // Opens a new child of the innermost element.
+  void Open(StringRef prefix, StringRef name) {
+    EndStartTag();
+    Indent();
+    output_->push_back('<');
+    elements_.push_back(
+        {QualifiedName(prefix, name), next_id_++, true, {}});
+    output_->append(elements_.back().name);
+  }
+
+  // Closes the elements that are deeper than the given depth.
+  void CloseDeeperThan(size_t depth) {
+    while (elements_.size() > depth + 1) {
+      Close();
+    }
+  }
+
+  void CloseAll() {
+    while (!elements_.empty()) {
+      Close();
+    }
+  }
+
+  // Adds an attribute to the start tag of the innermost element, which must
+  // still be open. If the element already has the attribute, its value is
+  // replaced, as xmlSetNsProp does.
+  void WriteAttribute(StringRef prefix, StringRef name, StringRef value) {
+    const string qualified_name = QualifiedName(prefix, name);
+    std::vector<Property>& properties = elements_.back().properties;
+    for (Property& property : properties) {
+      if (property.name != qualified_name) {
+        continue;
+      }
+      string escaped_value;
+      AppendEscaped(value, true, &escaped_value);
+      output_->replace(property.value_offset, property.value_length,
+                       escaped_value);
+      // Move the values of the attributes that follow it.
+      for (Property& other : properties) {
+        if (other.value_offset > property.value_offset) {
+          other.value_offset += escaped_value.size();
+          other.value_offset -= property.value_length;
+        }
+      }
+      property.value_length = escaped_value.size();
+      return;
+    }
+    output_->push_back(' ');
+    output_->append(qualified_name);
+    output_->append("=\"");
+    const size_t value_offset = output_->size();
+    AppendEscaped(value, true, output_);
+    properties.push_back(
+        {qualified_name, value_offset, output_->size() - value_offset});
+    output_->push_back('"');
+  }
+
+  // Writes a property of the innermost element: as an attribute while its
+  // start tag is open, and otherwise as a child that holds only text. Returns
+  // false if the property was already written and can no longer be replaced.
+  bool WriteProperty(StringRef prefix, StringRef name, StringRef value) {
+    if (IsStartTagOpen()) {
+      WriteAttribute(prefix, name, value);
+      return true;
+    }
+    const string qualified_name = QualifiedName(prefix, name);
+    std::vector<Property>& properties = elements_.back().properties;
+    for (const Property& property : properties) {
+      if (property.name == qualified_name) {
+        return false;
+      }
+    }
+    WriteTextElement(prefix, name, value);
+    properties.push_back({qualified_name, 0, 0});
+    return true;
+  }
+
+  // Declares the given namespaces on the innermost element, ordered by prefix
+  // so that the output does not depend on the order of the map.
+  void DeclareNamespaces(
+      const std::unordered_map<string, string>& namespaces) {
+    std::vector<std::pair<string, string>> sorted_namespaces(
+        namespaces.begin(), namespaces.end());
+    std::sort(sorted_namespaces.begin(), sorted_namespaces.end());
+    for (const auto& entry : sorted_namespaces) {
+      WriteAttribute(kNamespacePrefix, entry.first, entry.second);
+    }
+  }
+
+  // Writes a child of the innermost element that holds only text.
+  void WriteTextElement(StringRef prefix, StringRef name, StringRef value) {
+    EndStartTag();
+    Indent();
+    const string qualified_name = QualifiedName(prefix, name);
+    output_->push_back('<');
+    output_->append(qualified_name);
+    if (value.empty()) {
+      output_->append("/>\n");
+      return;
+    }
+    output_->push_back('>');
+    AppendEscaped(value, false, output_);
+    output_->append("</");
+    output_->append(qualified_name);
+    output_->append(">\n");
+  }
+
+  // Disallow copying.
+  Writer(const Writer&) = delete;
+  void operator=(const Writer&) = delete;
+
+ private:
+  // A property written on an element. While the start tag is open, the value
+  // of the attribute is at value_offset in the output.
+  struct Property {
+    string name;
+    size_t value_offset;
+    size_t value_length;
+  };
+
+  struct Element {
+    string name;
+    // Identifies the element among all those of the document, so that a
+    // serializer can tell that its element was closed.
+    size_t id;
+    bool start_tag_open;
+    std::vector<Property> properties;
+  };
+
+  void EndStartTag() {
+    if (IsStartTagOpen()) {
+      output_->append(">\n");
+      elements_.back().start_tag_open = false;
+    }
+  }
+
+  void Close() {
+    const Element& element = elements_.back();
+    if (element.start_tag_open) {
+      output_->append("/>\n");
+    } else {
+      Indent(elements_.size() - 1);
+      output_->append("</");
+      output_->append(element.name);
+      output_->append(">\n");
+    }
+    elements_.pop_back();
+  }
+
+  // Starts a new line for a child of the innermost element.
+  void Indent() { Indent(elements_.size()); }
+
+  void Indent(size_t level) {
+    output_->append(kIndentSize * std::min(level, kMaxIndentLevel), ' ');
+  }
+
+  // The prefixes that have a namespace, sorted so that they are looked up
+  // without creating string temporaries.
+  std::vector<string> prefixes_;
+  const string seq_name_;
+  std::vector<Element> elements_;
+  size_t next_id_;
+  string* output_;
+};
+
+StreamSerializer::StreamSerializer(const std::shared_ptr<Writer>& writer,
+                                   size_t depth)
+    : writer_(writer), depth_(depth), id_(writer->GetId(depth)) {}
+
+std::unique_ptr<StreamSerializer> StreamSerializer::FromNamespaces(
+    const std::unordered_map<string, string>& namespaces, StringRef prefix,
+    StringRef name, string* output) {
+  if (output == nullptr) {
+    LOG(ERROR) << "Output string is null";
+    return nullptr;
+  }
+  if (name.empty()) {
+    LOG(ERROR) << "Node name is empty";
+    return nullptr;
+  }
+  std::shared_ptr<Writer> writer(new Writer(namespaces, output));
+  if (!writer->HasNamespace(prefix)) {
+    LOG(ERROR) << "Prefix " << prefix << " not found in prefix list";
+    return nullptr;
+  }
+  writer->Open(prefix, name);
+  writer->DeclareNamespaces(namespaces);
+  return std::unique_ptr<StreamSerializer>(new StreamSerializer(writer, 0));
+}
+
+std::unique_ptr<StreamSerializer> StreamSerializer::FromXmpDescription(
+    const std::unordered_map<string, string>& namespaces, string* output) {
+  if (output == nullptr) {
+    LOG(ERROR) << "Output string is null";
+    return nullptr;
+  }
+  std::shared_ptr<Writer> writer(new Writer(namespaces, output));
+  writer->AddNamespace(XmpConst::NamespacePrefix());
+  writer->AddNamespace(XmlConst::RdfPrefix());
+
+  writer->Open(XmpConst::NamespacePrefix(), XmpConst::NodeName());
+  writer->WriteAttribute(kNamespacePrefix, XmpConst::NamespacePrefix(),
+                         XmpConst::Namespace());
+  writer->WriteAttribute(XmpConst::NamespacePrefix(),
+                         XmpConst::AdobePropName(),
+                         XmpConst::AdobePropValue());
+  writer->Open(XmlConst::RdfPrefix(), XmlConst::RdfNodeName());
+  writer->WriteAttribute(kNamespacePrefix, XmlConst::RdfPrefix(),
+                         XmlConst::RdfNodeNs());
+  writer->Open(XmlConst::RdfPrefix(), XmlConst::RdfDescription());
+  writer->DeclareNamespaces(namespaces);
+  // rdf:about is mandatory.
+  writer->WriteAttribute(XmlConst::RdfPrefix(), XmlConst::RdfAbout(), "");
+  return std::unique_ptr<StreamSerializer>(new StreamSerializer(writer, 2));
+}
+
+void StreamSerializer::Finish() { writer_->CloseAll(); }
+
+bool StreamSerializer::PrepareToWrite() const {
+  if (!writer_->IsOpen(depth_, id_)) {
+    LOG(ERROR) << "Cannot write to an element that was already closed";
+    return false;
+  }
+  writer_->CloseDeeperThan(depth_);
+  return true;
+}
+
+std::unique_ptr<Serializer>
+StreamSerializer::CreateSerializer(StringRef node_ns_name,
+                                   StringRef node_name) const {
+  if (node_name.empty()) {
+    LOG(ERROR) << "Node name is empty";
+    return nullptr;
+  }
+  if (!writer_->HasNamespace(node_ns_name)) {
+    LOG(ERROR) << "Prefix " << node_ns_name << " not found in prefix list";
+    return nullptr;
+  }
+  if (!PrepareToWrite()) {
+    return nullptr;
+  }
+  writer_->Open(node_ns_name, node_name);
+  return std::unique_ptr<Serializer>(new StreamSerializer(writer_, depth_ + 1));
+}
+
+std::unique_ptr<Serializer>
+StreamSerializer::CreateItemSerializer(StringRef prefix,
+                                       StringRef item_name) const {
+  if (!writer_->HasNamespace(XmlConst::RdfPrefix())) {
+    LOG(ERROR) << "No RDF prefix namespace found";
+    return nullptr;
+  }
+  if (!writer_->HasNamespace(prefix)) {
+    LOG(ERROR) << "No namespace found for " << prefix;
+    return nullptr;
+  }
+  if (!PrepareToWrite()) {
+    return nullptr;
+  }
+  if (!writer_->IsSeq(depth_)) {
+    LOG(ERROR) << "No rdf:Seq node for serializing this item";
+    return nullptr;
+  }
+
+  writer_->Open(XmlConst::RdfPrefix(), XmlConst::RdfLi());
+  writer_->Open(prefix, item_name);
+  return std::unique_ptr<Serializer>(new StreamSerializer(writer_, depth_ + 2));
+}
+
+std::unique_ptr<Serializer>
+StreamSerializer::CreateListSerializer(StringRef prefix,
+                                       StringRef list_name) const {
+  if (!writer_->HasNamespace(XmlConst::RdfPrefix())) {
+    LOG(ERROR) << "No RDF prefix namespace found";
+    return nullptr;
+  }
+  if (!writer_->HasNamespace(prefix)) {
+    LOG(ERROR) << "No namespace found for " << prefix;
+    return nullptr;
+  }
+  if (!PrepareToWrite()) {
+    return nullptr;
+  }
+
+  writer_->Open(prefix, list_name);
+  writer_->Open(XmlConst::RdfPrefix(), XmlConst::RdfSeq());
+  return std::unique_ptr<Serializer>(new StreamSerializer(writer_, depth_ + 2));
+}
+
+bool StreamSerializer::WriteBoolProperty(StringRef prefix, StringRef name,
+                                         bool value) const {
+  return WriteProperty(prefix, name, value ? "true" : "false");
+}
+
+bool StreamSerializer::WriteDoubleProperty(StringRef prefix, StringRef name,
+                                           double value) const {
+  char buffer[kFastToBufferSize];
+  return WriteProperty(prefix, name, DoubleToBuffer(value, buffer));
+}
+
+bool StreamSerializer::WriteProperty(StringRef prefix, StringRef name,
+                                     StringRef value) const {
+  if (name.empty()) {
+    LOG(ERROR) << "Property name is empty";
+    return false;
+  }
+  if (!writer_->HasNamespace(prefix)) {
+    LOG(ERROR) << "No namespace found for prefix " << prefix;
+    return false;
+  }
+  if (!PrepareToWrite()) {
+    return false;
+  }
+  if (writer_->IsSeq(depth_)) {
+    LOG(ERROR) << "Cannot write a property on an rdf:Seq node";
+    return false;
+  }
+
+  // Serialize the property in the format Prefix:Name="Value" while the start
+  // tag is open, and as a property element once the element has children.
+  if (!writer_->WriteProperty(prefix, name, value)) {
+    LOG(ERROR) << "Property " << QualifiedName(prefix, name)
+               << " was already written";
+    return false;
+  }
+  return true;
+}
+
+bool StreamSerializer::BeginArray(StringRef prefix, StringRef array_name,
+                                  size_t size) const {
+  if (size == 0) {
+    LOG(WARNING) << "No values to write";
+    return false;
+  }
+  if (!writer_->HasNamespace(XmlConst::RdfPrefix())) {
+    LOG(ERROR) << "No RDF prefix found";
+    return false;
+  }
+  if (!writer_->HasNamespace(prefix)) {
+    LOG(ERROR) << "No namespace found for " << prefix;
+    return false;
+  }
+  if (array_name.empty()) {
+    LOG(ERROR) << "Parent name cannot be empty";
+    return false;
+  }
+  if (!PrepareToWrite()) {
+    return false;
+  }
+  if (writer_->IsSeq(depth_)) {
+    LOG(ERROR) << "Cannot write a property on an rdf:Seq node";
+    return false;
+  }
+
+  writer_->Open(prefix, array_name);
+  writer_->Open(XmlConst::RdfPrefix(), XmlConst::RdfSeq());
+  return true;
+}
+
+void StreamSerializer::EndArray() const { writer_->CloseDeeperThan(depth_); }
+
+bool StreamSerializer::WriteIntArray(StringRef prefix, StringRef array_name,
+                                     const std::vector<int>& values) const {
+  if (!BeginArray(prefix, array_name, values.size())) {
+    return false;
+  }
+  char buffer[kFastToBufferSize];
+  for (int value : values) {
+    FastInt32ToBufferLeft(value, buffer);
+    writer_->WriteTextElement(XmlConst::RdfPrefix(), XmlConst::RdfLi(), buffer);
+  }
+  EndArray();
+  return true;
+}
+
+bool StreamSerializer::WriteDoubleArray(
+    StringRef prefix, StringRef array_name,
+    const std::vector<double>& values) const {
+  if (!BeginArray(prefix, array_name, values.size())) {
+    return false;
+  }
+  char buffer[kFastToBufferSize];
+  for (double value : values) {
+    writer_->WriteTextElement(XmlConst::RdfPrefix(), XmlConst::RdfLi(),
+                              DoubleToBuffer(value, buffer));
+  }
+  EndArray();
+  return true;
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
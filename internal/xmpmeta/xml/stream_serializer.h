@@ -0,0 +1,136 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_STREAM_SERIALIZER_H_
+#define XMPMETA_XML_STREAM_SERIALIZER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/port.h"
+#include "xmpmeta/xml/serializer.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// Writes RDF/XML text straight into a string, without building the libxml
+// tree that SerializerImpl writes into. The text is laid out and escaped as
+// libxml's formatted output of the same tree, so the two can be used
+// interchangeably.
+//
+// Elements are written in the order in which they are created. An element is
+// closed when a sibling or an ancestor's next child is created, or when Finish
+// is called, after which its serializer can no longer be written to. Elements
+// therefore have to be serialized depth first, which is what the Serialize
+// methods of the XDM elements do.
+// Properties are written as attributes until a child is created on the
+// serializer. A property written after that is written as a property element,
+// <Prefix:Name>Value</Prefix:Name>, which RDF readers treat the same way.
+// Writing a property again replaces its value while it is an attribute of an
+// open start tag, and fails after that.
+//
+// Example:
+//   string xmp;
+//   std::unique_ptr<StreamSerializer> serializer =
+//       StreamSerializer::FromXmpDescription(namespaces, &xmp);
+//   std::unique_ptr<Serializer> device_serializer =
+//       serializer->CreateSerializer("", "Device");
+//   device_serializer->WriteProperty("Device", "Revision", "1.0");
+//   serializer->Finish();
+class StreamSerializer : public Serializer {
+ public:
+  // Returns a serializer on a new root element prefix:name, or name if prefix
+  // is empty, which declares the given namespaces. The namespaces parameter
+  // is a map of prefixes to hrefs, and must contain every prefix that will be
+  // used in serialization. The RDF namespace must be present in it if
+  // CreateItemSerializer, CreateListSerializer or the array methods will be
+  // called. The text is appended to output, which must outlive the
+  // serializer. Returns null if prefix has no namespace.
+  static std::unique_ptr<StreamSerializer> FromNamespaces(
+      const std::unordered_map<string, string>& namespaces, StringRef prefix,
+      StringRef name, string* output);
+
+  // Returns a serializer on the rdf:Description element of a new XMP section,
+  // <x:xmpmeta><rdf:RDF><rdf:Description rdf:about="">, which declares the
+  // given namespaces. The text written is the same as the serialization of
+  // a section created by CreateXmpData, without the XML declaration.
+  static std::unique_ptr<StreamSerializer> FromXmpDescription(
+      const std::unordered_map<string, string>& namespaces, string* output);
+
+  // Closes all the open elements of the document. Must be called once on the
+  // root serializer, after which no serializer of the document can be used.
+  void Finish();
+
+  // Returns a new Serializer for an object that is part of an rdf:Seq list
+  // of objects.
+  // The parent serializer must be created with CreateListSerializer.
+  std::unique_ptr<Serializer>
+      CreateItemSerializer(StringRef prefix,
+                           StringRef item_name) const override;
+
+  // Returns a new Serializer on the rdf:Seq child of a new list_name element.
+  std::unique_ptr<Serializer>
+      CreateListSerializer(StringRef prefix,
+                           StringRef list_name) const override;
+
+  // Returns a new Serializer on a new child element.
+  std::unique_ptr<Serializer>
+      CreateSerializer(StringRef node_ns_name,
+                       StringRef node_name) const override;
+
+  // Writes the property into the current element, prefixed with prefix if it
+  // is not empty. Fails if prefix has no namespace or name is empty.
+  bool WriteBoolProperty(StringRef prefix, StringRef name,
+                         bool value) const override;
+  bool WriteDoubleProperty(StringRef prefix, StringRef name,
+                           double value) const override;
+  bool WriteProperty(StringRef prefix, StringRef name,
+                     StringRef value) const override;
+
+  // Writes the collection of numbers into a child rdf:Seq element.
+  bool WriteIntArray(StringRef prefix, StringRef array_name,
+                     const std::vector<int>& values) const override;
+  bool WriteDoubleArray(StringRef prefix, StringRef array_name,
+                        const std::vector<double>& values) const override;
+
+  // Disallow copying.
+  StreamSerializer(const StreamSerializer&) = delete;
+  void operator=(const StreamSerializer&) = delete;
+
+ private:
+  // The state shared by all the serializers of a document.
+  class Writer;
+
+  StreamSerializer(const std::shared_ptr<Writer>& writer, size_t depth);
+
+  // Returns true if this serializer's element is still open, and closes its
+  // open descendants so that new content can be written to it.
+  bool PrepareToWrite() const;
+
+  // Checks the array arguments and writes the start of the array elements.
+  bool BeginArray(StringRef prefix, StringRef array_name, size_t size) const;
+  void EndArray() const;
+
+  std::shared_ptr<Writer> writer_;
+  // The depth of this serializer's element, and its id in the writer.
+  size_t depth_;
+  size_t id_;
+};
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_STREAM_SERIALIZER_H_
@@ -0,0 +1,267 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/stream_serializer.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/search.h"
+#include "xmpmeta/xml/serializer_impl.h"
+#include "xmpmeta/xml/utils.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+const char kNamespaceHref[] = "http://somehref.com";
+const char kPrefixOne[] = "Name";
+const char kPrefixTwo[] = "NodeOne";
+const char kEscapedValue[] = "a<b> & \"c\"\n\td\r";
+
+std::unordered_map<string, string> CreateNamespaces() {
+  std::unordered_map<string, string> namespaces;
+  namespaces.emplace(XmlConst::RdfPrefix(), XmlConst::RdfNodeNs());
+  namespaces.emplace(kPrefixOne, kNamespaceHref);
+  namespaces.emplace(kPrefixTwo, kNamespaceHref);
+  return namespaces;
+}
+
+// Writes a hierarchy with every kind of content, in the same order as the
+// Serialize methods of the XDM elements.
+void SerializeHierarchy(const Serializer& serializer) {
+  ASSERT_TRUE(serializer.WriteProperty(kPrefixOne, "Text", kEscapedValue));
+  ASSERT_TRUE(serializer.WriteBoolProperty(kPrefixOne, "Bool", true));
+  ASSERT_TRUE(serializer.WriteDoubleProperty(kPrefixOne, "Double", 1.25));
+  ASSERT_TRUE(serializer.WriteProperty("", "NoPrefix", ""));
+
+  std::unique_ptr<Serializer> child =
+      serializer.CreateSerializer(kPrefixOne, "Child");
+  ASSERT_NE(nullptr, child);
+  ASSERT_TRUE(child->WriteProperty(kPrefixTwo, "Name", "child"));
+  std::unique_ptr<Serializer> empty_child =
+      child->CreateSerializer(kPrefixTwo, "Empty");
+  ASSERT_NE(nullptr, empty_child);
+
+  std::unique_ptr<Serializer> list =
+      serializer.CreateListSerializer(kPrefixOne, "List");
+  ASSERT_NE(nullptr, list);
+  for (int i = 0; i < 2; i++) {
+    std::unique_ptr<Serializer> item =
+        list->CreateItemSerializer(kPrefixTwo, "Item");
+    ASSERT_NE(nullptr, item);
+    ASSERT_TRUE(item->WriteProperty(kPrefixTwo, "Index", i == 0 ? "0" : "1"));
+    ASSERT_TRUE(item->WriteIntArray(kPrefixTwo, "Ints", {i, -7}));
+  }
+
+  ASSERT_TRUE(serializer.WriteIntArray(kPrefixOne, "Ints", {0, 1, -2}));
+  ASSERT_TRUE(
+      serializer.WriteDoubleArray(kPrefixOne, "Doubles", {0.1, -3, 1e-20}));
+}
+
+TEST(StreamSerializer, FromNamespacesInvalidArguments) {
+  string output;
+  EXPECT_EQ(nullptr,
+            StreamSerializer::FromNamespaces(CreateNamespaces(), "", "Root",
+                                             nullptr));
+  EXPECT_EQ(nullptr,
+            StreamSerializer::FromNamespaces(CreateNamespaces(), "", "",
+                                             &output));
+  EXPECT_EQ(nullptr,
+            StreamSerializer::FromNamespaces(CreateNamespaces(), "NoPrefix",
+                                             "Root", &output));
+  EXPECT_EQ(nullptr,
+            StreamSerializer::FromXmpDescription(CreateNamespaces(), nullptr));
+}
+
+TEST(StreamSerializer, WritesSameTextAsSerializerImpl) {
+  // Declare the namespaces in the order that StreamSerializer uses.
+  xmlDocPtr doc = xmlNewDoc(ToXmlChar(XmlConst::Version()));
+  xmlNodePtr root = xmlNewNode(nullptr, ToXmlChar("Root"));
+  xmlDocSetRootElement(doc, root);
+  const std::unordered_map<string, string> namespaces = CreateNamespaces();
+  std::unordered_map<string, xmlNsPtr> xml_namespaces;
+  for (const char* prefix : {kPrefixOne, kPrefixTwo, XmlConst::RdfPrefix()}) {
+    xml_namespaces.emplace(
+        prefix, xmlNewNs(root, ToXmlChar(namespaces.at(prefix).c_str()),
+                         ToXmlChar(prefix)));
+  }
+  SerializerImpl tree_serializer(xml_namespaces, root);
+  SerializeHierarchy(tree_serializer);
+  string expected = XmlDocToString(doc);
+  xmlFreeDoc(doc);
+  // Remove the XML declaration.
+  expected.erase(0, expected.find('\n') + 1);
+
+  string output;
+  std::unique_ptr<StreamSerializer> serializer =
+      StreamSerializer::FromNamespaces(namespaces, "", "Root", &output);
+  ASSERT_NE(nullptr, serializer);
+  SerializeHierarchy(*serializer);
+  serializer->Finish();
+  EXPECT_EQ(expected, output);
+}
+
+TEST(StreamSerializer, FromXmpDescription) {
+  std::unordered_map<string, string> namespaces;
+  namespaces.emplace(kPrefixOne, kNamespaceHref);
+  string output;
+  std::unique_ptr<StreamSerializer> serializer =
+      StreamSerializer::FromXmpDescription(namespaces, &output);
+  ASSERT_NE(nullptr, serializer);
+  ASSERT_TRUE(serializer->WriteProperty(kPrefixOne, "Mime", "image/jpeg"));
+  std::unique_ptr<Serializer> list =
+      serializer->CreateListSerializer(kPrefixOne, "List");
+  ASSERT_NE(nullptr, list);
+  serializer->Finish();
+
+  const string expected =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+      "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "    <rdf:Description xmlns:Name=\"http://somehref.com\" rdf:about=\"\""
+      " Name:Mime=\"image/jpeg\">\n"
+      "      <Name:List>\n"
+      "        <rdf:Seq/>\n"
+      "      </Name:List>\n"
+      "    </rdf:Description>\n"
+      "  </rdf:RDF>\n"
+      "</x:xmpmeta>\n";
+  EXPECT_EQ(expected, output);
+}
+
+TEST(StreamSerializer, PropertyAfterChildIsReadBack) {
+  string output;
+  std::unique_ptr<StreamSerializer> serializer =
+      StreamSerializer::FromNamespaces(CreateNamespaces(), "", "Root", &output);
+  ASSERT_NE(nullptr, serializer);
+  ASSERT_TRUE(serializer->WriteProperty(kPrefixOne, "First", kEscapedValue));
+  std::unique_ptr<Serializer> child =
+      serializer->CreateSerializer(kPrefixOne, "Child");
+  ASSERT_NE(nullptr, child);
+  ASSERT_TRUE(serializer->WriteProperty(kPrefixOne, "Second", kEscapedValue));
+  serializer->Finish();
+
+  xmlDocPtr doc = xmlReadMemory(output.data(), output.size(), nullptr,
+                                nullptr, 0);
+  ASSERT_NE(nullptr, doc);
+  DeserializerImpl deserializer(xmlDocGetRootElement(doc));
+  string value;
+  ASSERT_TRUE(deserializer.ParseString(kPrefixOne, "First", &value));
+  EXPECT_EQ(kEscapedValue, value);
+  ASSERT_TRUE(deserializer.ParseString(kPrefixOne, "Second", &value));
+  EXPECT_EQ(kEscapedValue, value);
+  EXPECT_NE(nullptr, deserializer.CreateDeserializer(kPrefixOne, "Child"));
+  xmlFreeDoc(doc);
+}
+
+TEST(StreamSerializer, RepeatedPropertyReplacesAttribute) {
+  string output;
+  std::unique_ptr<StreamSerializer> serializer =
+      StreamSerializer::FromNamespaces(CreateNamespaces(), "", "Root", &output);
+  ASSERT_NE(nullptr, serializer);
+  std::unique_ptr<Serializer> child =
+      serializer->CreateSerializer(kPrefixOne, "Child");
+  ASSERT_NE(nullptr, child);
+  ASSERT_TRUE(child->WriteProperty(kPrefixOne, "First", "1"));
+  ASSERT_TRUE(child->WriteProperty(kPrefixOne, "Second", "2"));
+  EXPECT_TRUE(child->WriteProperty(kPrefixOne, "First", kEscapedValue));
+  EXPECT_TRUE(child->WriteProperty(kPrefixOne, "Second", ""));
+  EXPECT_TRUE(child->WriteProperty(kPrefixTwo, "First", "3"));
+
+  // Once the start tag is closed, properties can no longer be replaced.
+  ASSERT_NE(nullptr, child->CreateSerializer(kPrefixOne, "Grandchild"));
+  EXPECT_FALSE(child->WriteProperty(kPrefixOne, "First", "4"));
+  EXPECT_TRUE(child->WriteProperty(kPrefixOne, "Third", "5"));
+  EXPECT_FALSE(child->WriteProperty(kPrefixOne, "Third", "6"));
+  serializer->Finish();
+
+  EXPECT_EQ("<Root xmlns:Name=\"http://somehref.com\""
+            " xmlns:NodeOne=\"http://somehref.com\""
+            " xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+            "  <Name:Child Name:First=\"a&lt;b&gt; &amp; &quot;c&quot;&#10;"
+            "&#9;d&#13;\" Name:Second=\"\" NodeOne:First=\"3\">\n"
+            "    <Name:Grandchild/>\n"
+            "    <Name:Third>5</Name:Third>\n"
+            "  </Name:Child>\n"
+            "</Root>\n",
+            output);
+}
+
+TEST(StreamSerializer, ClosedElementCannotBeWritten) {
+  string output;
+  std::unique_ptr<StreamSerializer> serializer =
+      StreamSerializer::FromNamespaces(CreateNamespaces(), "", "Root", &output);
+  ASSERT_NE(nullptr, serializer);
+  std::unique_ptr<Serializer> first =
+      serializer->CreateSerializer(kPrefixOne, "First");
+  ASSERT_NE(nullptr, first);
+  std::unique_ptr<Serializer> second =
+      serializer->CreateSerializer(kPrefixOne, "Second");
+  ASSERT_NE(nullptr, second);
+
+  EXPECT_FALSE(first->WriteProperty(kPrefixOne, "Name", "Value"));
+  EXPECT_EQ(nullptr, first->CreateSerializer(kPrefixOne, "Child"));
+  EXPECT_TRUE(second->WriteProperty(kPrefixOne, "Name", "Value"));
+
+  serializer->Finish();
+  EXPECT_FALSE(second->WriteProperty(kPrefixOne, "Name", "Value"));
+  EXPECT_FALSE(serializer->WriteProperty(kPrefixOne, "Name", "Value"));
+  EXPECT_EQ("<Root xmlns:Name=\"http://somehref.com\""
+            " xmlns:NodeOne=\"http://somehref.com\""
+            " xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+            "  <Name:First/>\n"
+            "  <Name:Second Name:Name=\"Value\"/>\n"
+            "</Root>\n",
+            output);
+}
+
+TEST(StreamSerializer, ListErrors) {
+  std::unordered_map<string, string> namespaces = CreateNamespaces();
+  string output;
+  std::unique_ptr<StreamSerializer> serializer =
+      StreamSerializer::FromNamespaces(namespaces, "", "Root", &output);
+  ASSERT_NE(nullptr, serializer);
+
+  // Items can only be created on lists, and lists have no properties.
+  EXPECT_EQ(nullptr, serializer->CreateItemSerializer(kPrefixOne, "Item"));
+  std::unique_ptr<Serializer> list =
+      serializer->CreateListSerializer(kPrefixOne, "List");
+  ASSERT_NE(nullptr, list);
+  EXPECT_FALSE(list->WriteProperty(kPrefixOne, "Name", "Value"));
+  EXPECT_FALSE(list->WriteIntArray(kPrefixOne, "Ints", {1}));
+  EXPECT_EQ(nullptr, list->CreateItemSerializer("NoPrefix", "Item"));
+  EXPECT_NE(nullptr, list->CreateItemSerializer(kPrefixOne, "Item"));
+  EXPECT_FALSE(serializer->WriteIntArray(kPrefixOne, "Ints", {}));
+
+  // Lists and arrays need the RDF namespace.
+  namespaces.erase(XmlConst::RdfPrefix());
+  string other_output;
+  serializer =
+      StreamSerializer::FromNamespaces(namespaces, "", "Root", &other_output);
+  ASSERT_NE(nullptr, serializer);
+  EXPECT_EQ(nullptr, serializer->CreateListSerializer(kPrefixOne, "List"));
+  EXPECT_FALSE(serializer->WriteDoubleArray(kPrefixOne, "Doubles", {1.0}));
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
@@ -0,0 +1,70 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XMPMETA_XML_STRING_REF_H_
+#define XMPMETA_XML_STRING_REF_H_
+
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#include "base/port.h"
+
+namespace xmpmeta {
+namespace xml {
+
+// A read-only reference to a null-terminated string, which is not copied.
+// It converts implicitly from string literals, const char* and string, so
+// that the prefixes, names and values passed to the Serializer and
+// Deserializer do not need string temporaries. Unlike a general string view,
+// c_str() can be passed straight to libxml.
+// The referenced string must outlive the StringRef.
+class StringRef {
+ public:
+  StringRef() : data_(""), size_(0) {}
+  // A null pointer is treated as the empty string.
+  StringRef(const char* str)  // NOLINT(runtime/explicit)
+      : data_(str != nullptr ? str : ""), size_(strlen(data_)) {}
+  StringRef(const string& str)  // NOLINT(runtime/explicit)
+      : data_(str.c_str()), size_(str.size()) {}
+
+  const char* c_str() const { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  string ToString() const { return string(data_, size_); }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+inline bool operator==(const StringRef& lhs, const StringRef& rhs) {
+  return lhs.size() == rhs.size() &&
+         memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+inline bool operator!=(const StringRef& lhs, const StringRef& rhs) {
+  return !(lhs == rhs);
+}
+
+inline std::ostream& operator<<(std::ostream& out, const StringRef& str) {
+  return out.write(str.data(), str.size());
+}
+
+}  // namespace xml
+}  // namespace xmpmeta
+
+#endif  // XMPMETA_XML_STRING_REF_H_
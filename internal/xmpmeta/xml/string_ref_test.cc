@@ -0,0 +1,108 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xml/string_ref.h"
+
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace xmpmeta {
+namespace xml {
+namespace {
+
+TEST(StringRef, FromLiteral) {
+  const StringRef ref("Device");
+  EXPECT_EQ(6u, ref.size());
+  EXPECT_FALSE(ref.empty());
+  EXPECT_STREQ("Device", ref.c_str());
+  EXPECT_EQ("Device", ref.ToString());
+}
+
+TEST(StringRef, FromCharPointer) {
+  const char text[] = "Camera";
+  const char* pointer = text;
+  const StringRef ref(pointer);
+  // The text is referenced, not copied.
+  EXPECT_EQ(text, ref.data());
+  EXPECT_EQ(6u, ref.size());
+  EXPECT_EQ('\0', ref.data()[ref.size()]);
+  EXPECT_EQ("Camera", ref.ToString());
+}
+
+TEST(StringRef, FromNullPointer) {
+  const char* pointer = nullptr;
+  const StringRef ref(pointer);
+  EXPECT_TRUE(ref.empty());
+  EXPECT_EQ(0u, ref.size());
+  ASSERT_NE(nullptr, ref.data());
+  EXPECT_EQ('\0', ref.data()[0]);
+  EXPECT_EQ("", ref.ToString());
+}
+
+TEST(StringRef, FromString) {
+  const string text = "Profile";
+  const StringRef ref(text);
+  EXPECT_EQ(text.data(), ref.data());
+  EXPECT_EQ(text.size(), ref.size());
+  EXPECT_EQ('\0', ref.data()[ref.size()]);
+  EXPECT_EQ(text, ref.ToString());
+
+  // The size of the string is kept, even past a null character.
+  const string with_null("a\0b", 3);
+  const StringRef null_ref(with_null);
+  EXPECT_EQ(3u, null_ref.size());
+  EXPECT_EQ(with_null, null_ref.ToString());
+}
+
+TEST(StringRef, Empty) {
+  EXPECT_TRUE(StringRef("").empty());
+  EXPECT_TRUE(StringRef(string()).empty());
+  EXPECT_EQ(0u, StringRef("").size());
+  EXPECT_EQ('\0', StringRef(string()).data()[0]);
+}
+
+TEST(StringRef, Equality) {
+  const string text = "GImage";
+  EXPECT_TRUE(StringRef("GImage") == StringRef(text));
+  EXPECT_FALSE(StringRef("GImage") != StringRef(text));
+  EXPECT_TRUE(StringRef("GImage") != StringRef("GAudio"));
+  EXPECT_FALSE(StringRef("GImage") == StringRef("GAudio"));
+  EXPECT_TRUE(StringRef("") == StringRef(string()));
+  EXPECT_TRUE(StringRef("") != StringRef("GImage"));
+}
+
+TEST(StringRef, EqualityWithPrefix) {
+  // A string is not equal to one that it is a prefix of, in either order.
+  EXPECT_FALSE(StringRef("GImage") == StringRef("GImageData"));
+  EXPECT_FALSE(StringRef("GImageData") == StringRef("GImage"));
+  EXPECT_TRUE(StringRef("GImage") != StringRef("GImageData"));
+  EXPECT_TRUE(StringRef("GImageData") != StringRef("GImage"));
+
+  // The whole size of a string is compared, even past a null character.
+  const string with_null("GImage\0Data", 11);
+  EXPECT_TRUE(StringRef(with_null) != StringRef("GImage"));
+  EXPECT_TRUE(StringRef(with_null) == StringRef(string("GImage\0Data", 11)));
+}
+
+TEST(StringRef, Output) {
+  std::ostringstream out;
+  out << StringRef("Device") << ':' << StringRef(string("Revision"));
+  EXPECT_EQ("Device:Revision", out.str());
+}
+
+}  // namespace
+}  // namespace xml
+}  // namespace xmpmeta
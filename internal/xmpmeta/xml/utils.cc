@@ -17,6 +17,7 @@
 #include "base/port.h"
 #include "glog/logging.h"
 #include "xmpmeta/xml/const.h"
+#include "xmpmeta/xml/interned_name.h"
 #include "xmpmeta/xml/search.h"
 
 namespace xmpmeta {
@@ -49,10 +50,11 @@ xmlNodePtr GetElementAt(xmlNodePtr node, int index) {
     LOG(ERROR) << "Node is not an rdf:Seq node, was " << node_name;
     return nullptr;
   }
+  const InternedName li(node->doc, XmlConst::RdfLi());
   int i = 0;
   for (xmlNodePtr child = node->children; child != nullptr && i <= index;
        child = child->next) {
-    if (strcmp(FromXmlChar(child->name), XmlConst::RdfLi())) {
+    if (!li.Matches(child->name)) {
       // This is not an rdf:li node. This can occur because the node's content
       // is also treated as a node, and these should be ignored.
       continue;
@@ -65,6 +67,28 @@ xmlNodePtr GetElementAt(xmlNodePtr node, int index) {
   return nullptr;
 }
 
+std::vector<xmlNodePtr> GetLiElements(xmlNodePtr node) {
+  std::vector<xmlNodePtr> li_nodes;
+  if (node == nullptr) {
+    LOG(ERROR) << "Node was null";
+    return li_nodes;
+  }
+  if (strcmp(FromXmlChar(node->name), XmlConst::RdfSeq())) {
+    LOG(ERROR) << "Node is not an rdf:Seq node, was "
+               << FromXmlChar(node->name);
+    return li_nodes;
+  }
+  const InternedName li(node->doc, XmlConst::RdfLi());
+  for (xmlNodePtr child = node->children; child != nullptr;
+       child = child->next) {
+    // Skip the node's content, which is also treated as a node.
+    if (li.Matches(child->name)) {
+      li_nodes.push_back(child);
+    }
+  }
+  return li_nodes;
+}
+
 const string GetLiNodeContent(xmlNodePtr node) {
   string value;
   if (node == nullptr || strcmp(FromXmlChar(node->name),
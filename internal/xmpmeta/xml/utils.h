@@ -16,6 +16,7 @@
 #define XMPMETA_XML_UTILS_H_
 
 #include <string>
+#include <vector>
 
 #include <libxml/tree.h>
 
@@ -49,6 +50,10 @@ xmlNodePtr GetFirstSeqElement(xmlNodePtr parent);
 // not an rdf:Seq node.
 xmlNodePtr GetElementAt(xmlNodePtr node, int index);
 
+// Returns the rdf:li nodes in the given rdf:Seq node, in order.
+// Returns an empty vector if {@code node} is null or is not an rdf:Seq node.
+std::vector<xmlNodePtr> GetLiElements(xmlNodePtr node);
+
 // Returns the value in an rdf:li node. This is for a node whose value
 // does not have a name, e.g. <rdf:li>value</rdf:li>.
 // If the given rdf:li node has a nested node, it returns the string
@@ -161,6 +161,24 @@ TEST(XmlUtils, GetListElementAndContents) {
   ASSERT_TRUE(string("") != GetLiNodeContent(li_node));
 }
 
+TEST(XmlUtils, GetLiElements) {
+  const string in_filename = TempFileAbsolutePath(kInFile);
+  CreateMetadataFile(in_filename);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(in_filename, true, &xmp_data));
+  xmlNodePtr seq_node = GetFirstSeqElement(xmp_data.StandardSection());
+  ASSERT_NE(nullptr, seq_node);
+
+  const std::vector<xmlNodePtr> li_nodes = GetLiElements(seq_node);
+  ASSERT_EQ(3u, li_nodes.size());
+  for (size_t i = 0; i < li_nodes.size(); ++i) {
+    EXPECT_EQ(GetElementAt(seq_node, i), li_nodes[i]);
+  }
+  EXPECT_TRUE(GetLiElements(GetFirstDescriptionElement(
+      xmp_data.StandardSection())).empty());
+  EXPECT_TRUE(GetLiElements(nullptr).empty());
+}
+
 TEST(XmlUtils, GetContentsFromNonListNode) {
   // Create the metadata.
   const string in_filename = TempFileAbsolutePath(kInFile);
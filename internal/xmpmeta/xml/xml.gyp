@@ -43,8 +43,13 @@
       'sources': [
         '<(xml_dir)/const.cc',
         '<(xml_dir)/deserializer_impl.cc',
+        '<(xml_dir)/interned_name.cc',
+        '<(xml_dir)/node_index.cc',
+        '<(xml_dir)/property_scanner.cc',
+        '<(xml_dir)/property_set.cc',
         '<(xml_dir)/search.cc',
         '<(xml_dir)/serializer_impl.cc',
+        '<(xml_dir)/stream_serializer.cc',
         '<(xml_dir)/utils.cc',
       ],
     },
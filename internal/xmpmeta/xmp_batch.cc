@@ -0,0 +1,201 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xmp_batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <libxml/parser.h>
+
+#include "glog/logging.h"
+#include "xmpmeta/byte_source.h"
+#include "xmpmeta/gimage.h"
+#include "xmpmeta/gpano.h"
+#include "xmpmeta/xmp_parser.h"
+
+namespace xmpmeta {
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Returns the seconds elapsed since start.
+double SecondsSince(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// The indices of the files assigned to one worker. The owner takes files from
+// the front, and idle workers steal them from the back.
+class WorkQueue {
+ public:
+  void PushBack(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    indices_.push_back(index);
+  }
+
+  bool PopFront(size_t* index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (indices_.empty()) {
+      return false;
+    }
+    *index = indices_.front();
+    indices_.pop_front();
+    return true;
+  }
+
+  bool PopBack(size_t* index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (indices_.empty()) {
+      return false;
+    }
+    *index = indices_.back();
+    indices_.pop_back();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::deque<size_t> indices_;
+};
+
+// Reports whether the JPEG data in source has GPano and GImage metadata,
+// scanning the standard packet for the few properties needed instead of
+// building a tree of it.
+void ScanXmpPresence(ByteSource* source, BatchFileResult* result) {
+  string xmp_packet;
+  if (!ReadStandardXmpPacket(source, &xmp_packet)) {
+    return;
+  }
+  result->success = true;
+  PanoMetaData pano_meta_data;
+  result->has_gpano = GPano::ParsePanoMetaData(
+      xmp_packet.data(), xmp_packet.size(), &pano_meta_data);
+  result->has_gimage = GImage::IsPresent(xmp_packet.data(), xmp_packet.size());
+}
+
+// Reads the XMP of the JPEG data in source into result.
+void ReadXmp(ByteSource* source, const BatchOptions& options,
+             BatchFileResult* result) {
+  std::unique_ptr<XmpData> xmp_data(new XmpData());
+  ExtendedXmp extended = options.lazy_extended ? ExtendedXmp::kLazy
+                                               : ExtendedXmp::kParse;
+  if (options.skip_extended) {
+    extended = ExtendedXmp::kSkip;
+  }
+  if (ReadXmpFromSource(source, extended, xmp_data.get(), nullptr)) {
+    result->success = true;
+    result->has_gpano = GPano::FromXmp(*xmp_data) != nullptr;
+    result->has_gimage = GImage::IsPresent(*xmp_data);
+    result->xmp_data = std::move(xmp_data);
+  }
+}
+
+// Reads the XMP of one file into result.
+void ExtractXmpFromFile(const string& path, const BatchOptions& options,
+                        BatchFileResult* result) {
+  const Clock::time_point start = Clock::now();
+  std::unique_ptr<ByteSource> source;
+  if (!HasJpegExtension(path)) {
+    LOG(WARNING) << "XMP parse: only JPEG file is supported";
+  } else {
+    // Positioned reads fetch only the metadata, and unlike memory-mapping do
+    // not contend on the address space of the process across threads.
+    source = ByteSource::FromFile(path);
+  }
+  if (source != nullptr) {
+    if (options.presence_only) {
+      ScanXmpPresence(source.get(), result);
+    } else {
+      ReadXmp(source.get(), options, result);
+    }
+  }
+  result->seconds = SecondsSince(start);
+}
+
+// Processes files until no worker has any left. No work is added once the
+// workers start, so a worker stops when it finds every queue empty.
+void RunWorker(size_t worker, const std::vector<string>& paths,
+               const BatchOptions& options,
+               std::vector<std::unique_ptr<WorkQueue>>* queues,
+               std::vector<BatchFileResult>* results) {
+  const size_t num_queues = queues->size();
+  size_t index;
+  while (true) {
+    bool has_work = (*queues)[worker]->PopFront(&index);
+    for (size_t i = 1; !has_work && i < num_queues; ++i) {
+      has_work = (*queues)[(worker + i) % num_queues]->PopBack(&index);
+    }
+    if (!has_work) {
+      return;
+    }
+    ExtractXmpFromFile(paths[index], options, &(*results)[index]);
+  }
+}
+
+}  // namespace
+
+BatchResult ExtractXmpBatch(const std::vector<string>& paths,
+                            const BatchOptions& options) {
+  const Clock::time_point start = Clock::now();
+  BatchResult batch_result;
+  batch_result.files.resize(paths.size());
+  if (paths.empty()) {
+    return batch_result;
+  }
+
+  size_t num_threads = options.num_threads > 0 ?
+      options.num_threads : std::thread::hardware_concurrency();
+  num_threads = std::max<size_t>(1, std::min(num_threads, paths.size()));
+
+  // Give each worker a contiguous block of files to start with, so that files
+  // from the same directory tend to be read by the same thread.
+  std::vector<std::unique_ptr<WorkQueue>> queues(num_threads);
+  for (size_t worker = 0; worker < num_threads; ++worker) {
+    queues[worker].reset(new WorkQueue());
+    const size_t begin = worker * paths.size() / num_threads;
+    const size_t end = (worker + 1) * paths.size() / num_threads;
+    for (size_t index = begin; index < end; ++index) {
+      queues[worker]->PushBack(index);
+    }
+  }
+
+  // libxml2 must be initialized before it is used from several threads.
+  xmlInitParser();
+  std::vector<std::thread> threads;
+  for (size_t worker = 1; worker < num_threads; ++worker) {
+    threads.emplace_back(RunWorker, worker, std::cref(paths),
+                         std::cref(options), &queues, &batch_result.files);
+  }
+  // The calling thread is the first worker.
+  RunWorker(0, paths, options, &queues, &batch_result.files);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (const BatchFileResult& result : batch_result.files) {
+    if (result.success) {
+      ++batch_result.num_succeeded;
+    }
+    batch_result.total_file_seconds += result.seconds;
+    batch_result.max_file_seconds =
+        std::max(batch_result.max_file_seconds, result.seconds);
+  }
+  batch_result.wall_seconds = SecondsSince(start);
+  return batch_result;
+}
+
+}  // namespace xmpmeta
@@ -0,0 +1,172 @@
+// Copyright 2016 The XMPMeta Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xmpmeta/xmp_batch.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "xmpmeta/file.h"
+#include "xmpmeta/test_util.h"
+#include "xmpmeta/test_xmp_creator.h"
+#include "xmpmeta/xml/deserializer_impl.h"
+#include "xmpmeta/xml/utils.h"
+
+using xmpmeta::xml::DeserializerImpl;
+using xmpmeta::xml::GetFirstDescriptionElement;
+
+namespace xmpmeta {
+namespace {
+
+const char kXmpBody[] =
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+    "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+    "    <rdf:Description rdf:about=\"\"\n"
+    "      xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\"\n"
+    "      GImage:Mime=\"image/jpeg\"/>\n"
+    "  </rdf:RDF>\n"
+    "</x:xmpmeta>\n";
+
+const int kNumCopies = 20;
+
+// Returns kNumCopies of a VR photo, a JPEG with only GImage metadata and a
+// missing file, in that order.
+std::vector<string> GetTestPaths() {
+  const string gimage_path = TempFileAbsolutePath("batch_gimage.jpg");
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  TestXmpCreator::WriteJPEGFile(gimage_path, standard_xmp);
+
+  std::vector<string> paths;
+  for (int i = 0; i < kNumCopies; ++i) {
+    paths.push_back(TestFileAbsolutePath("left_with_xmp.jpg"));
+    paths.push_back(gimage_path);
+    paths.push_back(TempFileAbsolutePath("batch_missing.jpg"));
+  }
+  return paths;
+}
+
+TEST(XmpBatch, ExtractXmpBatch) {
+  const std::vector<string> paths = GetTestPaths();
+  BatchOptions options;
+  options.num_threads = 4;
+  const BatchResult result = ExtractXmpBatch(paths, options);
+
+  ASSERT_EQ(paths.size(), result.files.size());
+  EXPECT_EQ(2 * kNumCopies, result.num_succeeded);
+  for (size_t i = 0; i < paths.size(); i += 3) {
+    const BatchFileResult& vr_photo = result.files[i];
+    ASSERT_TRUE(vr_photo.success);
+    ASSERT_NE(nullptr, vr_photo.xmp_data);
+    EXPECT_NE(nullptr, vr_photo.xmp_data->ExtendedSection());
+    EXPECT_TRUE(vr_photo.has_gpano);
+    EXPECT_TRUE(vr_photo.has_gimage);
+
+    const BatchFileResult& gimage = result.files[i + 1];
+    ASSERT_TRUE(gimage.success);
+    ASSERT_NE(nullptr, gimage.xmp_data);
+    DeserializerImpl deserializer(
+        GetFirstDescriptionElement(gimage.xmp_data->StandardSection()));
+    string mime;
+    ASSERT_TRUE(deserializer.ParseString("GImage", "Mime", &mime));
+    EXPECT_EQ("image/jpeg", mime);
+    EXPECT_FALSE(gimage.has_gpano);
+    EXPECT_TRUE(gimage.has_gimage);
+
+    const BatchFileResult& missing = result.files[i + 2];
+    EXPECT_FALSE(missing.success);
+    EXPECT_EQ(nullptr, missing.xmp_data);
+  }
+  EXPECT_GE(result.total_file_seconds, result.max_file_seconds);
+  EXPECT_GT(result.wall_seconds, 0);
+}
+
+TEST(XmpBatch, ExtractXmpBatchPresenceOnly) {
+  const std::vector<string> paths = GetTestPaths();
+  BatchOptions options;
+  options.presence_only = true;
+  const BatchResult result = ExtractXmpBatch(paths, options);
+
+  ASSERT_EQ(paths.size(), result.files.size());
+  EXPECT_EQ(2 * kNumCopies, result.num_succeeded);
+  for (size_t i = 0; i < paths.size(); i += 3) {
+    EXPECT_EQ(nullptr, result.files[i].xmp_data);
+    EXPECT_TRUE(result.files[i].has_gpano);
+    EXPECT_TRUE(result.files[i].has_gimage);
+    EXPECT_EQ(nullptr, result.files[i + 1].xmp_data);
+    EXPECT_FALSE(result.files[i + 1].has_gpano);
+    EXPECT_TRUE(result.files[i + 1].has_gimage);
+    EXPECT_FALSE(result.files[i + 2].success);
+  }
+}
+
+TEST(XmpBatch, ExtractXmpBatchLazyExtended) {
+  const std::vector<string> paths = GetTestPaths();
+  BatchOptions options;
+  options.lazy_extended = true;
+  const BatchResult result = ExtractXmpBatch(paths, options);
+
+  ASSERT_EQ(paths.size(), result.files.size());
+  EXPECT_EQ(2 * kNumCopies, result.num_succeeded);
+  for (size_t i = 0; i < paths.size(); i += 3) {
+    ASSERT_NE(nullptr, result.files[i].xmp_data);
+    EXPECT_NE(nullptr, result.files[i].xmp_data->ExtendedSection());
+    ASSERT_NE(nullptr, result.files[i + 1].xmp_data);
+    EXPECT_EQ(nullptr, result.files[i + 1].xmp_data->ExtendedSection());
+  }
+}
+
+TEST(XmpBatch, ExtractXmpBatchRequiresJpegExtension) {
+  // A JPEG file is read, as by ReadXmpHeader, only if it is named as one.
+  string jpeg_contents;
+  ReadFileToStringOrDie(TestFileAbsolutePath("left_with_xmp.jpg"),
+                        &jpeg_contents);
+  const string path = TempFileAbsolutePath("batch_vr_photo.png");
+  WriteStringToFileOrDie(jpeg_contents, path);
+  const std::vector<string> paths(1, path);
+  BatchOptions options;
+  EXPECT_EQ(0, ExtractXmpBatch(paths, options).num_succeeded);
+  options.presence_only = true;
+  const BatchResult result = ExtractXmpBatch(paths, options);
+  EXPECT_EQ(0, result.num_succeeded);
+  EXPECT_FALSE(result.files[0].has_gpano);
+}
+
+TEST(XmpBatch, ExtractXmpBatchPresenceOnlyMalformedXmp) {
+  // The packet is scanned as a tree would be parsed, so malformed XMP does not
+  // report GImage metadata.
+  const string path = TempFileAbsolutePath("batch_malformed.jpg");
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(
+      string(kXmpBody, sizeof(kXmpBody) - 20)));
+  TestXmpCreator::WriteJPEGFile(path, standard_xmp);
+  BatchOptions options;
+  options.presence_only = true;
+  const BatchResult result =
+      ExtractXmpBatch(std::vector<string>(1, path), options);
+  ASSERT_EQ(1u, result.files.size());
+  EXPECT_FALSE(result.files[0].has_gpano);
+  EXPECT_FALSE(result.files[0].has_gimage);
+}
+
+TEST(XmpBatch, ExtractXmpBatchEmpty) {
+  const BatchResult result =
+      ExtractXmpBatch(std::vector<string>(), BatchOptions());
+  EXPECT_TRUE(result.files.empty());
+  EXPECT_EQ(0, result.num_succeeded);
+}
+
+}  // namespace
+}  // namespace xmpmeta
@@ -29,14 +29,43 @@ void XmpData::Reset() {
     xmlFreeDoc(xmp_extended_);
     xmp_extended_ = nullptr;
   }
+  extended_loader_ = nullptr;
+  extended_loaded_.reset();
 }
 
 const xmlDocPtr XmpData::StandardSection() const { return xmp_; }
 
 xmlDocPtr* XmpData::MutableStandardSection() { return &xmp_; }
 
-const xmlDocPtr XmpData::ExtendedSection() const { return xmp_extended_; }
+const xmlDocPtr XmpData::ExtendedSection() const {
+  LoadExtendedSection();
+  return xmp_extended_;
+}
+
+xmlDocPtr* XmpData::MutableExtendedSection() {
+  LoadExtendedSection();
+  return &xmp_extended_;
+}
 
-xmlDocPtr* XmpData::MutableExtendedSection() { return &xmp_extended_; }
+void XmpData::SetExtendedSectionLoader(
+    const std::function<xmlDocPtr()>& loader) {
+  if (xmp_extended_) {
+    xmlFreeDoc(xmp_extended_);
+    xmp_extended_ = nullptr;
+  }
+  extended_loader_ = loader;
+  extended_loaded_.reset(new std::once_flag());
+}
+
+void XmpData::LoadExtendedSection() const {
+  if (extended_loaded_ == nullptr) {
+    return;
+  }
+  std::call_once(*extended_loaded_, [this] {
+    xmp_extended_ = extended_loader_();
+    // Release whatever the loader holds on to, such as the file data.
+    extended_loader_ = nullptr;
+  });
+}
 
 }  // namespace xmpmeta
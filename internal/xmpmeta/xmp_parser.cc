@@ -16,13 +16,18 @@
 
 #include <algorithm>
 #include <cstring>
+#include <memory>
 #include <stack>
 
+#include <libxml/parser.h>
+
 #include "glog/logging.h"
+#include "strings/ascii_ctype.h"
 #include "strings/case.h"
 #include "strings/numbers.h"
 #include "strings/util.h"
 #include "xmpmeta/base64.h"
+#include "xmpmeta/file.h"
 #include "xmpmeta/jpeg_io.h"
 #include "xmpmeta/xmp_const.h"
 #include "xmpmeta/xml/const.h"
@@ -36,6 +41,7 @@ using xmpmeta::xml::DepthFirstSearch;
 using xmpmeta::xml::DeserializerImpl;
 using xmpmeta::xml::FromXmlChar;
 using xmpmeta::xml::GetFirstDescriptionElement;
+using xmpmeta::xml::ToXmlChar;
 using xmpmeta::xml::XmlConst;
 
 namespace xmpmeta {
@@ -43,6 +49,8 @@ namespace {
 
 const char kJpgExtension[] = "jpg";
 const char kJpegExtension[] = "jpeg";
+// Name of the processing instructions that wrap an XMP packet.
+const char kXmpPacketName[] = "xpacket";
 
 bool BoolStringToBool(const string& bool_str, bool* value) {
   if (StringCaseEqual(bool_str, "true")) {
@@ -63,11 +71,11 @@ bool ConvertStringPropertyToType(const string& string_property, T* value);
 // Gets the end of the XMP meta content. If there is no packet wrapper, returns
 // data.length, otherwise returns 1 + the position of last '>' without '?'
 // before it. Usually the packet wrapper end is "<?xpacket end="w"?>.
-size_t GetXmpContentEnd(const string& data) {
-  if (data.empty()) {
+size_t GetXmpContentEnd(const char* data, size_t size) {
+  if (size == 0) {
     return 0;
   }
-  for (size_t i = data.size() - 1; i >= 1; --i) {
+  for (size_t i = size - 1; i >= 1; --i) {
     if (data[i] == '>') {
       if (data[i - 1] != '?') {
         return i + 1;
@@ -76,28 +84,74 @@ size_t GetXmpContentEnd(const string& data) {
   }
   // It should not reach here for a valid XMP meta.
   LOG(WARNING) << "Failed to find the end of the XMP meta content.";
-  return data.size();
+  return size;
+}
+
+// Removes the XMP packet wrapper processing instructions, which are not part
+// of the metadata, so that they are not written out again with it.
+void RemoveXmpPacketWrapper(xmlDocPtr doc) {
+  xmlNodePtr node = doc->children;
+  while (node != nullptr) {
+    xmlNodePtr next = node->next;
+    if (node->type == XML_PI_NODE &&
+        xmlStrEqual(node->name, ToXmlChar(kXmpPacketName))) {
+      xmlUnlinkNode(node);
+      xmlFreeNode(node);
+    }
+    node = next;
+  }
+}
+
+// Returns true if the section's data starts with the given prefix.
+bool SectionHasPrefix(const SectionView& section, const string& prefix) {
+  return section.length >= prefix.size() &&
+         std::equal(prefix.begin(), prefix.end(), section.data);
+}
+
+// Returns views of the given sections, which must outlive the views.
+std::vector<SectionView> ToSectionViews(const std::vector<Section>& sections) {
+  std::vector<SectionView> views(sections.size());
+  for (size_t i = 0; i < sections.size(); ++i) {
+    views[i].marker = sections[i].marker;
+    views[i].is_image_section = sections[i].is_image_section;
+    views[i].length = sections[i].data.size();
+    views[i].data = sections[i].data.data();
+  }
+  return views;
+}
+
+// Points content at the XML content of the given standard XMP section, past
+// the XMP header and without the trailing packet wrapper.
+bool GetStandardXmpContent(const SectionView& section, const char** content,
+                           size_t* content_length) {
+  const size_t end = GetXmpContentEnd(section.data, section.length);
+  // Increment header length by 1 for the null termination.
+  const size_t header_length = strlen(XmpConst::Header()) + 1;
+  // Check for integer underflow before subtracting.
+  if (header_length >= end) {
+    LOG(ERROR) << "Invalid content length: "
+               << static_cast<int>(end - header_length);
+    return false;
+  }
+  *content_length = end - header_length;
+  // header_length is guaranteed to be <= section.length due to the if
+  // condition above. If this contract changes we must add an additonal
+  // check.
+  *content = &section.data[header_length];
+  return true;
 }
 
 // Parses the first valid XMP section. Any other valid XMP section will be
 // ignored.
-bool ParseFirstValidXMPSection(const std::vector<Section>& sections,
+bool ParseFirstValidXMPSection(const std::vector<SectionView>& sections,
                                XmpData* xmp) {
-  for (const Section& section : sections) {
-    if (HasPrefixString(section.data, XmpConst::Header())) {
-      const size_t end = GetXmpContentEnd(section.data);
-      // Increment header length by 1 for the null termination.
-      const size_t header_length = strlen(XmpConst::Header()) + 1;
-      // Check for integer underflow before subtracting.
-      if (header_length >= end) {
-        LOG(ERROR) << "Invalid content length: "
-                   << static_cast<int>(end - header_length);
+  for (const SectionView& section : sections) {
+    if (SectionHasPrefix(section, XmpConst::Header())) {
+      const char* content_start;
+      size_t content_length;
+      if (!GetStandardXmpContent(section, &content_start, &content_length)) {
         return false;
       }
-      const size_t content_length = end - header_length;
-      // header_length is guaranteed to be <= data.size due to the if condition
-      // above. If this contract changes we must add an additonal check.
-      const char* content_start = &section.data[header_length];
       // xmlReadMemory requires an int. Before casting size_t to int we must
       // check for integer overflow.
       if (content_length > INT_MAX) {
@@ -111,96 +165,507 @@ bool ParseFirstValidXMPSection(const std::vector<Section>& sections,
         LOG(WARNING) << "Failed to parse standard section.";
         return false;
       }
+      RemoveXmpPacketWrapper(xmp->StandardSection());
       return true;
     }
   }
   return false;
 }
 
-// Collects the extended XMP sections with the given name into a string. Other
-// sections will be ignored.
-string GetExtendedXmpSections(const std::vector<Section>& sections,
-                              const string& section_name) {
+// Reads a big-endian 4-byte integer.
+uint32 Read4ByteInt(const char* data) {
+  const uint8* bytes = reinterpret_cast<const uint8*>(data);
+  return static_cast<uint32>(bytes[0]) << 24 |
+         static_cast<uint32>(bytes[1]) << 16 |
+         static_cast<uint32>(bytes[2]) << 8 | bytes[3];
+}
+
+// A chunk of the extended XMP, and where it belongs in the whole.
+struct ExtendedXmpChunk {
+  const char* data;
+  size_t length;
+  size_t total_length;
+  size_t offset;
+};
+
+// Returns true if the chunks, sorted by offset, exactly cover the declared
+// total length. Removes chunks that repeat an earlier one, which can be left
+// behind when the XMP of a file is rewritten.
+bool ChunksCoverTotalLength(std::vector<ExtendedXmpChunk>* chunks) {
+  const size_t total_length = chunks->front().total_length;
+  size_t end = 0;
+  std::vector<ExtendedXmpChunk> unique_chunks;
+  for (const ExtendedXmpChunk& chunk : *chunks) {
+    if (chunk.total_length != total_length) {
+      LOG(WARNING) << "Extended XMP chunks declare different total lengths";
+      return false;
+    }
+    if (!unique_chunks.empty() &&
+        chunk.offset == unique_chunks.back().offset &&
+        chunk.length == unique_chunks.back().length) {
+      continue;
+    }
+    if (chunk.offset != end) {
+      LOG(WARNING) << "Extended XMP chunk at offset " << chunk.offset
+                   << (chunk.offset < end ? " overlaps" : " leaves a gap after")
+                   << " the data ending at " << end;
+      return false;
+    }
+    end += chunk.length;
+    unique_chunks.push_back(chunk);
+  }
+  if (end != total_length) {
+    LOG(WARNING) << "Extended XMP chunks hold " << end << " bytes, but "
+                 << total_length << " were declared";
+    return false;
+  }
+  chunks->swap(unique_chunks);
+  return true;
+}
+
+// Collects the chunks of the extended XMP sections with the given name, in
+// the order of the offsets declared in their headers. Other sections will be
+// ignored. If the offsets do not exactly cover the declared total length,
+// the chunks are kept in file order instead. The chunks point into the
+// sections' data.
+bool GetExtendedXmpChunks(const std::vector<SectionView>& sections,
+                          const string& section_name,
+                          std::vector<ExtendedXmpChunk>* chunks) {
   string extended_header = XmpConst::ExtensionHeader();
   extended_header += '\0' + section_name;
   // section_name is dynamically extracted from the xml file and can have an
   // arbitrary size. Check for integer overflow before addition.
   if (extended_header.size() > SIZE_MAX - XmpConst::ExtensionHeaderOffset()) {
-    return "";
+    return false;
   }
   const size_t section_start_offset =
       extended_header.size() + XmpConst::ExtensionHeaderOffset();
 
-  // Compute the size of the buffer to parse the extended sections.
-  std::vector<const Section*> xmp_sections;
-  std::vector<size_t> xmp_end_offsets;
-  size_t buffer_size = 0;
-  for (const Section& section : sections) {
-    if (extended_header.empty() ||
-        HasPrefixString(section.data, extended_header)) {
-      const size_t end_offset = section.data.size();
-      const size_t section_size = end_offset - section_start_offset;
-      if (end_offset < section_start_offset ||
-          section_size > SIZE_MAX - buffer_size) {
-        return "";
+  for (const SectionView& section : sections) {
+    if (extended_header.empty() || SectionHasPrefix(section, extended_header)) {
+      if (section.length < section_start_offset) {
+        return false;
       }
-      buffer_size += section_size;
-      xmp_sections.push_back(&section);
-      xmp_end_offsets.push_back(end_offset);
+      ExtendedXmpChunk chunk;
+      chunk.data = &section.data[section_start_offset];
+      chunk.length = section.length - section_start_offset;
+      chunk.total_length = Read4ByteInt(&section.data[extended_header.size()]);
+      chunk.offset = Read4ByteInt(&section.data[extended_header.size() + 4]);
+      chunks->push_back(chunk);
     }
   }
+  if (chunks->empty()) {
+    return false;
+  }
+
+  // Chunks are usually in order already, in which case this does not move
+  // them.
+  std::vector<ExtendedXmpChunk> ordered_chunks(*chunks);
+  std::stable_sort(ordered_chunks.begin(), ordered_chunks.end(),
+                   [](const ExtendedXmpChunk& a, const ExtendedXmpChunk& b) {
+                     return a.offset < b.offset;
+                   });
+  if (ChunksCoverTotalLength(&ordered_chunks)) {
+    chunks->swap(ordered_chunks);
+  } else {
+    LOG(WARNING) << "Reassembling extended XMP chunks in file order";
+  }
+  return true;
+}
 
-  // Copy all the relevant sections' data into a buffer.
-  string buffer(buffer_size, '\0');
-  if (buffer.size() != buffer_size) {
-    return "";
+// Parses the extended XMP from its chunks. The chunks are fed to an
+// incremental parser one at a time rather than joined first, so the extended
+// XMP is never held in memory twice. Returns null on failure.
+xmlDocPtr ParseExtendedXmpChunks(const std::vector<ExtendedXmpChunk>& chunks) {
+  xmlParserCtxtPtr context =
+      xmlCreatePushParserCtxt(nullptr, nullptr, nullptr, 0, nullptr);
+  if (context == nullptr) {
+    LOG(WARNING) << "Failed to create a parser for extended sections.";
+    return nullptr;
+  }
+  xmlCtxtUseOptions(context, XML_PARSE_HUGE);
+  bool success = true;
+  // Each chunk is smaller than a JPEG section, so its length fits in an int.
+  for (const ExtendedXmpChunk& chunk : chunks) {
+    if (xmlParseChunk(context, chunk.data, static_cast<int>(chunk.length),
+                      0) != 0) {
+      success = false;
+      break;
+    }
   }
-  size_t offset = 0;
-  for (int i = 0; i < xmp_sections.size(); ++i) {
-    const Section* section = xmp_sections[i];
-    const size_t length = xmp_end_offsets[i] - section_start_offset;
-    std::copy_n(&section->data[section_start_offset], length, &buffer[offset]);
-    offset += length;
+  success = success && xmlParseChunk(context, nullptr, 0, 1) == 0 &&
+      context->wellFormed;
+  xmlDocPtr doc = nullptr;
+  if (success) {
+    doc = context->myDoc;
+  } else if (context->myDoc != nullptr) {
+    xmlFreeDoc(context->myDoc);
   }
-  return buffer;
+  context->myDoc = nullptr;
+  xmlFreeParserCtxt(context);
+  if (doc == nullptr) {
+    LOG(WARNING) << "Failed to parse extended sections.";
+  }
+  return doc;
 }
 
 // Parses the extended XMP sections with the given name. All other sections
 // will be ignored.
-bool ParseExtendedXmpSections(const std::vector<Section>& sections,
+bool ParseExtendedXmpSections(const std::vector<SectionView>& sections,
                               const string& section_name, XmpData* xmp_data) {
-  const string extended_sections =
-      GetExtendedXmpSections(sections, section_name);
-  // xmlReadMemory requires an int. Before casting size_t to int we must check
-  // for integer overflow.
-  if (extended_sections.size() > INT_MAX) {
-    LOG(WARNING) << "Extended sections too large, size: "
-                 << extended_sections.size();
+  std::vector<ExtendedXmpChunk> chunks;
+  if (!GetExtendedXmpChunks(sections, section_name, &chunks)) {
+    LOG(WARNING) << "Failed to find extended sections.";
     return false;
   }
-  *xmp_data->MutableExtendedSection() =
-      xmlReadMemory(extended_sections.data(),
-                    static_cast<int>(extended_sections.size()), nullptr,
-                    nullptr, XML_PARSE_HUGE);
-  if (xmp_data->ExtendedSection() == nullptr) {
-    LOG(WARNING) << "Failed to parse extended sections.";
+  *xmp_data->MutableExtendedSection() = ParseExtendedXmpChunks(chunks);
+  return xmp_data->ExtendedSection() != nullptr;
+}
+
+// Locates the extended XMP sections with the given name, and sets up xmp_data
+// to parse them on the first access to its extended section. data_owner keeps
+// the sections' data alive until then.
+bool SetUpLazyExtendedXmpSections(const std::vector<SectionView>& sections,
+                                  const string& section_name,
+                                  const std::shared_ptr<const void>& data_owner,
+                                  XmpData* xmp_data) {
+  std::vector<ExtendedXmpChunk> chunks;
+  if (!GetExtendedXmpChunks(sections, section_name, &chunks)) {
+    LOG(WARNING) << "Failed to find extended sections.";
     return false;
   }
+  xmp_data->SetExtendedSectionLoader([chunks, data_owner]() {
+    return ParseExtendedXmpChunks(chunks);
+  });
   return true;
 }
 
-// Extracts a XmpData from a JPEG image stream.
-bool ExtractXmpMeta(const bool skip_extended, std::istream* file,
-                    XmpData* xmp_data) {
-  CHECK_NOTNULL(xmp_data)->Reset();
+// Gets the name of the extended XMP sections, which is declared in the
+// standard section. Returns false if there are no extended sections.
+bool GetExtensionName(const XmpData& xmp_data, string* extension_name) {
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.StandardSection()));
+  return deserializer.ParseString(XmpConst::HasExtensionPrefix(),
+                                  XmpConst::HasExtension(), extension_name);
+}
+
+// Reads the extended XMP a character at a time across its chunks.
+class ChunkCursor {
+ public:
+  explicit ChunkCursor(const std::vector<ExtendedXmpChunk>* chunks)
+      : chunks_(chunks), chunk_(0), offset_(0) {
+    SkipEmptyChunks();
+  }
+
+  bool AtEnd() const { return chunk_ == chunks_->size(); }
+
+  // Returns the current character. Must not be called at the end.
+  char Get() const { return (*chunks_)[chunk_].data[offset_]; }
+
+  void Advance() {
+    ++offset_;
+    SkipEmptyChunks();
+  }
+
+  void SkipSpaces() {
+    while (!AtEnd() && ascii_isspace(Get())) {
+      Advance();
+    }
+  }
 
+  // Advances past the given text if it comes next, otherwise stays put.
+  bool Consume(const char* text, size_t length) {
+    ChunkCursor lookahead = *this;
+    for (size_t i = 0; i < length; ++i) {
+      if (lookahead.AtEnd() || lookahead.Get() != text[i]) {
+        return false;
+      }
+      lookahead.Advance();
+    }
+    *this = lookahead;
+    return true;
+  }
+
+  // Adds the text up to the given terminator to blob as one segment per
+  // chunk. Returns false if there is no terminator, or if the text holds an
+  // entity reference, which would have to be expanded.
+  bool CollectUntil(char terminator, BlobRef* blob) {
+    for (; chunk_ < chunks_->size(); ++chunk_, offset_ = 0) {
+      const ExtendedXmpChunk& chunk = (*chunks_)[chunk_];
+      const char* start = chunk.data + offset_;
+      const size_t remaining = chunk.length - offset_;
+      const char* end =
+          static_cast<const char*>(memchr(start, terminator, remaining));
+      const size_t length = end != nullptr ? end - start : remaining;
+      if (memchr(start, '&', length) != nullptr) {
+        LOG(WARNING) << "Entity references in blobs are not supported.";
+        return false;
+      }
+      if (length > 0) {
+        blob->AddSegment(start, length);
+      }
+      if (end != nullptr) {
+        offset_ += length;
+        Advance();
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  void SkipEmptyChunks() {
+    while (chunk_ < chunks_->size() &&
+           offset_ == (*chunks_)[chunk_].length) {
+      ++chunk_;
+      offset_ = 0;
+    }
+  }
+
+  const std::vector<ExtendedXmpChunk>* chunks_;
+  size_t chunk_;
+  size_t offset_;
+};
+
+// Finds the value of the first occurrence of the given qualified property
+// name in the extended XMP chunks, either as an attribute,
+// name="value", or as an element, <name>value</name>. Like the
+// deserializer, this matches the namespace prefix as written.
+bool FindPropertyText(const std::vector<ExtendedXmpChunk>& chunks,
+                      const string& property, BlobRef* blob) {
+  ChunkCursor cursor(&chunks);
+  char previous = '\0';
+  while (!cursor.AtEnd()) {
+    const char c = cursor.Get();
+    cursor.Advance();
+    if (c == property[0] && (previous == '<' || ascii_isspace(previous))) {
+      ChunkCursor match = cursor;
+      if (match.Consume(property.data() + 1, property.size() - 1)) {
+        match.SkipSpaces();
+        if (previous == '<') {
+          if (match.Consume(">", 1)) {
+            return match.CollectUntil('<', blob);
+          }
+        } else if (match.Consume("=", 1)) {
+          match.SkipSpaces();
+          if (!match.AtEnd() && (match.Get() == '"' || match.Get() == '\'')) {
+            const char quote = match.Get();
+            match.Advance();
+            return match.CollectUntil(quote, blob);
+          }
+        }
+      }
+    }
+    previous = c;
+  }
+  return false;
+}
+
+// Returns true if the text referenced by blob is its own value in XML: it
+// holds no markup, entity or character reference, or character that is not
+// allowed in XML text, so that parsing it would give back the same text, save
+// for the normalization of whitespace. This holds for base64 data.
+bool IsVerbatimText(const BlobRef& blob) {
+  for (const BlobRef::Segment& segment : blob.Segments()) {
+    for (size_t i = 0; i < segment.length; ++i) {
+      const char c = segment.data[i];
+      // ']' could start the "]]>" that is not allowed in text.
+      if (c == '<' || c == '&' || c == ']' ||
+          ((c < ' ' || c > '~') && !ascii_isspace(c))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Stands in for the value of the property when the extended XMP is parsed by
+// BlobIsParsedValue, so that the parser never holds the value itself.
+const char kValueMarker[] = "x";
+
+// The state of BlobIsParsedValue while libxml2 calls back into it.
+struct BlobCheckState {
+  const char* prefix = nullptr;
+  const char* name = nullptr;
+  // Depth of the current element, and of the first rdf:Description element
+  // once it is found.
+  int depth = 0;
+  int description_depth = 0;
+  bool description_done = false;
+  // Depth of the property element while its text is being read.
+  int property_depth = 0;
+  bool found = false;
+  // The start of the value of the property. Whether the value is longer than
+  // the marker is all that matters, so no more of it is kept.
+  string value;
+  bool value_too_long = false;
+};
+
+// Returns true if the given prefix and name are those of the property. As in
+// the deserializer, an empty property prefix matches any prefix.
+bool IsProperty(const BlobCheckState& state, const xmlChar* prefix,
+                const xmlChar* name) {
+  if (strcmp(FromXmlChar(name), state.name) != 0) {
+    return false;
+  }
+  return state.prefix[0] == '\0' ||
+         (prefix != nullptr && strcmp(FromXmlChar(prefix), state.prefix) == 0);
+}
+
+void AppendToCheckedValue(BlobCheckState* state, const char* text,
+                          size_t length) {
+  if (state->value_too_long || length > sizeof(kValueMarker) - 1 -
+                                            state->value.size()) {
+    state->value_too_long = true;
+    return;
+  }
+  state->value.append(text, length);
+}
+
+void BlobCheckStartElement(void* ctx, const xmlChar* localname,
+                           const xmlChar* prefix, const xmlChar* /* uri */,
+                           int /* num_namespaces */,
+                           const xmlChar** /* namespaces */,
+                           int num_attributes, int /* num_defaulted */,
+                           const xmlChar** attributes) {
+  BlobCheckState* state = static_cast<BlobCheckState*>(ctx);
+  ++state->depth;
+  if (state->found || state->description_done) {
+    return;
+  }
+  if (state->description_depth == 0) {
+    // Like GetFirstDescriptionElement, match on the local name only.
+    if (strcmp(FromXmlChar(localname), XmlConst::RdfDescription()) != 0) {
+      return;
+    }
+    state->description_depth = state->depth;
+    // Each attribute is given as its local name, prefix, URI, and the start
+    // and end of its value.
+    for (int i = 0; i < num_attributes; ++i) {
+      const xmlChar** attribute = &attributes[i * 5];
+      if (IsProperty(*state, attribute[1], attribute[0])) {
+        state->found = true;
+        AppendToCheckedValue(state, FromXmlChar(attribute[3]),
+                             attribute[4] - attribute[3]);
+        return;
+      }
+    }
+  }
+  // Otherwise the value is the text of the first element of that name in the
+  // rdf:Description, as found by DepthFirstSearch.
+  if (IsProperty(*state, prefix, localname)) {
+    state->found = true;
+    state->property_depth = state->depth;
+  }
+}
+
+void BlobCheckEndElement(void* ctx, const xmlChar* /* localname */,
+                         const xmlChar* /* prefix */,
+                         const xmlChar* /* uri */) {
+  BlobCheckState* state = static_cast<BlobCheckState*>(ctx);
+  if (state->depth == state->property_depth) {
+    state->property_depth = 0;
+  }
+  if (state->depth == state->description_depth) {
+    state->description_done = true;
+  }
+  --state->depth;
+}
+
+// Receives text and CDATA sections. As with xmlNodeGetContent, all the text
+// within the property element is part of its value.
+void BlobCheckCharacters(void* ctx, const xmlChar* text, int length) {
+  BlobCheckState* state = static_cast<BlobCheckState*>(ctx);
+  if (state->property_depth > 0) {
+    AppendToCheckedValue(state, FromXmlChar(text), length);
+  }
+}
+
+// Returns true if blob references exactly the value of the property as an XML
+// parser reads it from the chunks, with the lookup rules of the deserializer:
+// an attribute of the first rdf:Description element, or else the text of the
+// first element of that name within it. This rules out text that only looks
+// like the property to FindPropertyText, e.g. within a comment, and values
+// whose text differs from what is written, e.g. in a CDATA section.
+// The chunks are parsed with a SAX parser, so no XML tree is built, and the
+// text of blob is replaced with kValueMarker, so that libxml2 does not hold
+// the value in memory: only its characters are checked, in place.
+bool BlobIsParsedValue(const std::vector<ExtendedXmpChunk>& chunks,
+                       const string& prefix, const string& name,
+                       const BlobRef& blob) {
+  if (!IsVerbatimText(blob)) {
+    return false;
+  }
+  xmlSAXHandler handler;
+  memset(&handler, 0, sizeof(handler));
+  handler.initialized = XML_SAX2_MAGIC;
+  handler.startElementNs = BlobCheckStartElement;
+  handler.endElementNs = BlobCheckEndElement;
+  handler.characters = BlobCheckCharacters;
+  handler.ignorableWhitespace = BlobCheckCharacters;
+  handler.cdataBlock = BlobCheckCharacters;
+
+  BlobCheckState state;
+  state.prefix = prefix.c_str();
+  state.name = name.c_str();
+  xmlParserCtxtPtr context =
+      xmlCreatePushParserCtxt(&handler, &state, nullptr, 0, nullptr);
+  if (context == nullptr) {
+    LOG(WARNING) << "Failed to create a parser for extended sections.";
+    return false;
+  }
+  xmlCtxtUseOptions(context, XML_PARSE_HUGE);
+  // Feeds the text from start to end, other than that of the blob's
+  // segments, which FindPropertyText gives in order and one per chunk.
+  const std::vector<BlobRef::Segment>& segments = blob.Segments();
+  size_t segment = 0;
+  bool success = true;
+  auto parse = [context, &success](const char* data, size_t length) {
+    success = success && (length == 0 ||
+                          xmlParseChunk(context, data,
+                                        static_cast<int>(length), 0) == 0);
+  };
+  for (const ExtendedXmpChunk& chunk : chunks) {
+    const char* start = chunk.data;
+    const char* const end = chunk.data + chunk.length;
+    while (segment < segments.size() && segments[segment].data >= start &&
+           segments[segment].data + segments[segment].length <= end) {
+      parse(start, segments[segment].data - start);
+      if (segment == 0) {
+        parse(kValueMarker, sizeof(kValueMarker) - 1);
+      }
+      start = segments[segment].data + segments[segment].length;
+      ++segment;
+    }
+    parse(start, end - start);
+  }
+  // As in ParseExtendedXmpChunks, the whole XMP must be well formed.
+  success = success && segment == segments.size() &&
+      xmlParseChunk(context, nullptr, 0, 1) == 0 && context->wellFormed;
+  xmlFreeParserCtxt(context);
+  const string expected_value = segments.empty() ? "" : kValueMarker;
+  return success && state.found && !state.value_too_long &&
+         state.value == expected_value;
+}
+
+// Returns the options for parsing only the sections that may contain XMP.
+ParseOptions GetXmpParseOptions(const bool skip_extended) {
   ParseOptions parse_options;
   parse_options.read_meta_only = true;
   if (skip_extended) {
     parse_options.section_header = XmpConst::Header();
     parse_options.section_header_return_first = true;
   }
-  const std::vector<Section> sections = Parse(parse_options, file);
+  return parse_options;
+}
+
+// Populates a XmpData from the XMP sections of a JPEG image. If data_owner is
+// not null, the extended section is parsed lazily, and data_owner keeps the
+// sections' data alive until it is.
+bool ExtractXmpMetaFromSections(const bool skip_extended,
+                                const std::vector<SectionView>& sections,
+                                const std::shared_ptr<const void>& data_owner,
+                                XmpData* xmp_data) {
   if (sections.empty()) {
     LOG(WARNING) << "No sections found.";
     return false;
@@ -214,13 +679,14 @@ bool ExtractXmpMeta(const bool skip_extended, std::istream* file,
     return true;
   }
   string extension_name;
-  DeserializerImpl deserializer(
-      GetFirstDescriptionElement(xmp_data->StandardSection()));
-  if (!deserializer.ParseString(XmpConst::HasExtensionPrefix(),
-                                XmpConst::HasExtension(), &extension_name)) {
+  if (!GetExtensionName(*xmp_data, &extension_name)) {
     // No extended sections present, so nothing to parse.
     return true;
   }
+  if (data_owner != nullptr) {
+    return SetUpLazyExtendedXmpSections(sections, extension_name, data_owner,
+                                        xmp_data);
+  }
   if (!ParseExtendedXmpSections(sections, extension_name, xmp_data)) {
     LOG(WARNING) << "Extended sections present, but could not be parsed.";
     return false;
@@ -228,6 +694,41 @@ bool ExtractXmpMeta(const bool skip_extended, std::istream* file,
   return true;
 }
 
+// Extracts a XmpData from a JPEG image stream.
+bool ExtractXmpMeta(const bool skip_extended, std::istream* file,
+                    XmpData* xmp_data) {
+  CHECK_NOTNULL(xmp_data)->Reset();
+  const std::vector<Section> sections =
+      Parse(GetXmpParseOptions(skip_extended), file);
+  return ExtractXmpMetaFromSections(skip_extended, ToSectionViews(sections),
+                                    nullptr, xmp_data);
+}
+
+// Extracts a XmpData from a JPEG image held in memory, without copying it.
+bool ExtractXmpMeta(const bool skip_extended, const uint8* buffer,
+                    size_t size, XmpData* xmp_data) {
+  CHECK_NOTNULL(xmp_data)->Reset();
+  return ExtractXmpMetaFromSections(
+      skip_extended,
+      ParseSectionViews(GetXmpParseOptions(skip_extended), buffer, size),
+      nullptr, xmp_data);
+}
+
+// Extracts a XmpData from a JPEG image in a byte source, reading only the
+// ranges that hold the XMP sections and the headers of the sections before
+// them. If lazy_extended is true, the sections are kept to parse the extended
+// section from on first access.
+bool ExtractXmpMeta(const bool skip_extended, const bool lazy_extended,
+                    ByteSource* source, std::vector<ByteRange>* fetched_ranges,
+                    XmpData* xmp_data) {
+  CHECK_NOTNULL(xmp_data)->Reset();
+  std::shared_ptr<std::vector<Section>> sections(new std::vector<Section>(
+      Parse(GetXmpParseOptions(skip_extended), source, fetched_ranges)));
+  return ExtractXmpMetaFromSections(
+      skip_extended, ToSectionViews(*sections),
+      lazy_extended ? sections : nullptr, xmp_data);
+}
+
 // Extracts the specified string attribute.
 bool GetStringProperty(const xmlNodePtr node, const char* prefix,
                        const char* property, string* value) {
@@ -285,8 +786,7 @@ bool ConvertStringPropertyToType<bool>(const string& string_property,
 template <>
 bool ConvertStringPropertyToType<double>(const string& string_property,
                                          double* value) {
-  *value = std::stod(string_property);
-  return true;
+  return safe_strtod(string_property, value);
 }
 
 template <>
@@ -298,33 +798,102 @@ bool ConvertStringPropertyToType<int>(const string& string_property,
 template <>
 bool ConvertStringPropertyToType<int64>(const string& string_property,
                                        int64* value) {
-  *value = std::stol(string_property);
-  return true;
+  return safe_strto64(string_property, value);
 }
 
 }  // namespace
 
 bool ReadXmpHeader(const string& filename, const bool skip_extended,
                    XmpData* xmp_data) {
-  const string& lower_filename = strings::ToLower(filename);
-  if (!HasSuffixString(lower_filename, kJpgExtension) &&
-      !HasSuffixString(lower_filename, kJpegExtension)) {
+  return ReadXmpHeader(filename, skip_extended ? ExtendedXmp::kSkip
+                                               : ExtendedXmp::kParse,
+                       xmp_data);
+}
+
+bool ReadXmpHeader(const string& filename, ExtendedXmp extended,
+                   XmpData* xmp_data) {
+  if (!HasJpegExtension(filename)) {
     LOG(WARNING) << "XMP parse: only JPEG file is supported";
     return false;
   }
 
-  std::ifstream file(filename.c_str(), std::ios::binary);
-  if (!file.is_open()) {
+  // Map the file rather than streaming it, so that only the pages holding
+  // the APPn sections are read.
+  std::shared_ptr<MemoryMappedFile> file = MemoryMappedFile::FromFile(filename);
+  if (file == nullptr) {
     LOG(WARNING) << " Could not read file: " << filename;
     return false;
   }
-  return ExtractXmpMeta(skip_extended, &file, xmp_data);
+  const bool skip_extended = extended == ExtendedXmp::kSkip;
+  CHECK_NOTNULL(xmp_data)->Reset();
+  // When parsing lazily, the file stays mapped until the extended section is
+  // parsed.
+  return ExtractXmpMetaFromSections(
+      skip_extended,
+      ParseSectionViews(GetXmpParseOptions(skip_extended), file->data(),
+                        file->size()),
+      extended == ExtendedXmp::kLazy ? file : nullptr, xmp_data);
 }
 
 bool ReadXmpFromMemory(const string& jpeg_contents, const bool skip_extended,
                        XmpData* xmp_data) {
-  std::istringstream stream(jpeg_contents);
-  return ExtractXmpMeta(skip_extended, &stream, xmp_data);
+  return ExtractXmpMeta(skip_extended,
+                        reinterpret_cast<const uint8*>(jpeg_contents.data()),
+                        jpeg_contents.size(), xmp_data);
+}
+
+bool ReadXmpFromMemory(const uint8* buffer, size_t size,
+                       const bool skip_extended, XmpData* xmp_data) {
+  return ExtractXmpMeta(skip_extended, buffer, size, xmp_data);
+}
+
+bool HasJpegExtension(const string& filename) {
+  const string lower_filename = strings::ToLower(filename);
+  return HasSuffixString(lower_filename, kJpgExtension) ||
+         HasSuffixString(lower_filename, kJpegExtension);
+}
+
+bool FindStandardXmpPacket(const uint8* buffer, size_t size,
+                           const char** xmp_packet, size_t* xmp_packet_length) {
+  const bool kSkipExtended = true;
+  for (const SectionView& section : ParseSectionViews(
+           GetXmpParseOptions(kSkipExtended), buffer, size)) {
+    if (SectionHasPrefix(section, XmpConst::Header())) {
+      return GetStandardXmpContent(section, xmp_packet, xmp_packet_length);
+    }
+  }
+  LOG(WARNING) << "No XMP section found.";
+  return false;
+}
+
+bool FindExtendedXmpBlob(const uint8* buffer, size_t size,
+                         const XmpData& xmp_data, const string& prefix,
+                         const string& name, BlobRef* blob) {
+  blob->Clear();
+  string extension_name;
+  if (!GetExtensionName(xmp_data, &extension_name)) {
+    LOG(WARNING) << "No extended sections present.";
+    return false;
+  }
+  const bool kSkipExtended = false;
+  std::vector<ExtendedXmpChunk> chunks;
+  if (!GetExtendedXmpChunks(
+          ParseSectionViews(GetXmpParseOptions(kSkipExtended), buffer, size),
+          extension_name, &chunks)) {
+    LOG(WARNING) << "Failed to find extended sections.";
+    return false;
+  }
+  if (!FindPropertyText(chunks, prefix + ":" + name, blob)) {
+    blob->Clear();
+    return false;
+  }
+  if (!BlobIsParsedValue(chunks, prefix, name, *blob)) {
+    LOG(WARNING) << "The value of " << prefix << ":" << name
+                 << " cannot be referenced in place.";
+    blob->Clear();
+    return false;
+  }
+  return true;
 }
 
 bool ReadXmpHeader(std::istream* input_stream, bool skip_extended,
@@ -332,4 +901,39 @@ bool ReadXmpHeader(std::istream* input_stream, bool skip_extended,
   return ExtractXmpMeta(skip_extended, input_stream, xmp_data);
 }
 
+bool ReadXmpFromSource(ByteSource* source, bool skip_extended,
+                       XmpData* xmp_data,
+                       std::vector<ByteRange>* fetched_ranges) {
+  return ReadXmpFromSource(
+      source, skip_extended ? ExtendedXmp::kSkip : ExtendedXmp::kParse,
+      xmp_data, fetched_ranges);
+}
+
+bool ReadXmpFromSource(ByteSource* source, ExtendedXmp extended,
+                       XmpData* xmp_data,
+                       std::vector<ByteRange>* fetched_ranges) {
+  return ExtractXmpMeta(extended == ExtendedXmp::kSkip,
+                        extended == ExtendedXmp::kLazy, source,
+                        fetched_ranges, xmp_data);
+}
+
+bool ReadStandardXmpPacket(ByteSource* source, string* xmp_packet) {
+  const bool kSkipExtended = true;
+  const std::vector<Section> sections =
+      Parse(GetXmpParseOptions(kSkipExtended), source, nullptr);
+  for (const SectionView& section : ToSectionViews(sections)) {
+    if (SectionHasPrefix(section, XmpConst::Header())) {
+      const char* content;
+      size_t content_length;
+      if (!GetStandardXmpContent(section, &content, &content_length)) {
+        return false;
+      }
+      xmp_packet->assign(content, content_length);
+      return true;
+    }
+  }
+  LOG(WARNING) << "No XMP section found.";
+  return false;
+}
+
 }  // namespace xmpmeta
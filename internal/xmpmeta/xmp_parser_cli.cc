@@ -30,7 +30,6 @@
 
 #include "gflags/gflags.h"
 #include "glog/logging.h"
-#include "xmpmeta/file.h"
 #include "xmpmeta/gaudio.h"
 #include "xmpmeta/gimage.h"
 #include "xmpmeta/gpano.h"
@@ -43,12 +42,12 @@ DEFINE_string(input, "", "Jpeg file to be parsed.");
 DEFINE_string(output_image, "", "Jpeg file for the right eye image.");
 DEFINE_string(output_audio, "", "Audio file if present.");
 
+using xmpmeta::ExtractGAudioToFile;
+using xmpmeta::ExtractGImageToFile;
 using xmpmeta::PanoMetaData;
 using xmpmeta::GAudio;
-using xmpmeta::GImage;
 using xmpmeta::GPano;
 using xmpmeta::ReadXmpHeader;
-using xmpmeta::WriteStringToFileOrDie;
 using xmpmeta::XmpData;
 
 // Prints the PanoMetaData to the log.
@@ -67,11 +66,11 @@ int main(int argc, char** argv) {
   InitGoogle(argv[0], &argc, &argv, true);
   QCHECK(!FLAGS_input.empty());
 
-  // Parse the XMP.
+  // Parse the standard XMP. The extended XMP is only needed for the image and
+  // audio, which are decoded straight from the file.
   XmpData xmp;
-  const bool skip_extended =
-      FLAGS_output_image.empty() && FLAGS_output_audio.empty();
-  QCHECK(ReadXmpHeader(FLAGS_input, skip_extended, &xmp));
+  const bool kSkipExtended = true;
+  QCHECK(ReadXmpHeader(FLAGS_input, kSkipExtended, &xmp));
 
   // Print the PanoMetaData.
   auto gpano = CHECK_NOTNULL(GPano::FromXmp(xmp));
@@ -79,15 +78,13 @@ int main(int argc, char** argv) {
 
   // Optionally decode and save the right image.
   if (!FLAGS_output_image.empty()) {
-    auto gimage = CHECK_NOTNULL(GImage::FromXmp(xmp));
-    WriteStringToFileOrDie(gimage->GetData(), FLAGS_output_image);
+    QCHECK(ExtractGImageToFile(FLAGS_input, FLAGS_output_image));
   }
 
   // Optionally decode and save the audio (if it exists).
   if (!FLAGS_output_audio.empty()) {
-    auto gaudio = GAudio::FromXmp(xmp);
-    if (gaudio != nullptr) {
-      WriteStringToFileOrDie(gaudio->GetData(), FLAGS_output_audio);
+    if (GAudio::IsPresent(xmp)) {
+      QCHECK(ExtractGAudioToFile(FLAGS_input, FLAGS_output_audio));
     } else {
       LOG(WARNING) << "Pano does not appear to have audio";
     }
@@ -14,13 +14,18 @@
 
 #include "xmpmeta/xmp_parser.h"
 
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "base/port.h"
 #include "gtest/gtest.h"
+#include "xmpmeta/byte_source.h"
+#include "xmpmeta/file.h"
 #include "xmpmeta/test_util.h"
 #include "xmpmeta/test_xmp_creator.h"
+#include "xmpmeta/xmp_const.h"
 #include "xmpmeta/xml/const.h"
 #include "xmpmeta/xml/deserializer_impl.h"
 #include "xmpmeta/xml/utils.h"
@@ -114,6 +119,47 @@ const char* kXmpBodyWithFalseBooleanCamelCase =
     "  </rdf:RDF>\n"
     "</x:xmpmeta>\n";
 
+// Splits kXmpExtensionBody into num_chunks extended sections whose headers
+// hold the real total length and chunk offsets, and returns the sections in
+// the given order of chunk indices.
+std::vector<string> CreateExtensionXmpChunks(
+    int num_chunks, const std::vector<int>& order) {
+  const string body = kXmpExtensionBody;
+  std::vector<string> sections;
+  for (int i : order) {
+    const int start = body.size() * i / num_chunks;
+    const int end = body.size() * (i + 1) / num_chunks;
+    string section = XmpConst::ExtensionHeader();
+    section.push_back(0);
+    section.append("123ABC");
+    for (const int value : {static_cast<int>(body.size()), start}) {
+      section.push_back(static_cast<char>((value >> 24) & 0xff));
+      section.push_back(static_cast<char>((value >> 16) & 0xff));
+      section.push_back(static_cast<char>((value >> 8) & 0xff));
+      section.push_back(static_cast<char>(value & 0xff));
+    }
+    section.append(body.substr(start, end - start));
+    sections.push_back(section);
+  }
+  return sections;
+}
+
+// Reads the extended XMP from a JPEG with the given extended sections.
+bool ReadExtendedXmpData(const std::vector<string>& extended_sections,
+                         string* data) {
+  std::vector<string> xmp_sections(extended_sections);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  XmpData xmp_data;
+  if (!ReadXmpFromMemory(TestXmpCreator::MakeJPEGFileContents(xmp_sections),
+                         false, &xmp_data)) {
+    return false;
+  }
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.ExtendedSection()));
+  return deserializer.ParseString("GImage", "Data", data);
+}
+
 TEST(XmpParser, ReadValidStandardXmp) {
   const string filename = TempFileAbsolutePath("test.jpg");
   std::vector<string> standard_xmp;
@@ -265,5 +311,278 @@ TEST(XmpParser, ReadExtendedXmp) {
   ASSERT_EQ(string("9865"), value);
 }
 
+TEST(XmpParser, ReadExtendedXmpFromMemoryBuffer) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(reinterpret_cast<const uint8*>(contents.data()),
+                                contents.size(), false, &xmp_data));
+
+  string value;
+  DeserializerImpl std_deserializer(
+      GetFirstDescriptionElement(xmp_data.StandardSection()));
+  ASSERT_TRUE(std_deserializer.ParseString("GImage", "Mime", &value));
+  EXPECT_EQ(string("image/jpeg"), value);
+  DeserializerImpl ext_deserializer(
+      GetFirstDescriptionElement(xmp_data.ExtendedSection()));
+  ASSERT_TRUE(ext_deserializer.ParseString("GImage", "Data", &value));
+  EXPECT_EQ(string("9865"), value);
+}
+
+TEST(XmpParser, ReadExtendedXmpFromByteSource) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  string contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+  const size_t metadata_size = contents.size();
+  // Add a large image, which should never be fetched.
+  contents.append(1 << 20, '\0');
+  const string filename = TempFileAbsolutePath("byte_source.jpg");
+  WriteStringToFileOrDie(contents, filename);
+
+  // Serve the reads from the file, as a stand-in for remote range reads.
+  std::shared_ptr<ByteSource> file = ByteSource::FromFile(filename);
+  ASSERT_NE(nullptr, file);
+  std::unique_ptr<ByteSource> source = ByteSource::FromReader(
+      file->Size(), [file](size_t offset, size_t length, char* buffer) {
+        return file->ReadAt(offset, length, buffer);
+      });
+  XmpData xmp_data;
+  std::vector<ByteRange> fetched_ranges;
+  ASSERT_TRUE(ReadXmpFromSource(source.get(), false, &xmp_data,
+                                &fetched_ranges));
+
+  string value;
+  DeserializerImpl std_deserializer(
+      GetFirstDescriptionElement(xmp_data.StandardSection()));
+  ASSERT_TRUE(std_deserializer.ParseString("GImage", "Mime", &value));
+  EXPECT_EQ(string("image/jpeg"), value);
+  DeserializerImpl ext_deserializer(
+      GetFirstDescriptionElement(xmp_data.ExtendedSection()));
+  ASSERT_TRUE(ext_deserializer.ParseString("GImage", "Data", &value));
+  EXPECT_EQ(string("9865"), value);
+
+  ASSERT_FALSE(fetched_ranges.empty());
+  EXPECT_EQ(0u, fetched_ranges[0].offset);
+  const ByteRange& last_range = fetched_ranges.back();
+  EXPECT_LE(last_range.offset + last_range.length, metadata_size + 4096);
+}
+
+TEST(XmpParser, ReadExtendedXmpChunksOutOfOrder) {
+  string value;
+  ASSERT_TRUE(ReadExtendedXmpData(CreateExtensionXmpChunks(3, {2, 0, 1}),
+                                  &value));
+  EXPECT_EQ(string("9865"), value);
+}
+
+TEST(XmpParser, ReadExtendedXmpRepeatedChunks) {
+  string value;
+  ASSERT_TRUE(ReadExtendedXmpData(CreateExtensionXmpChunks(2, {0, 1, 0, 1}),
+                                  &value));
+  EXPECT_EQ(string("9865"), value);
+}
+
+TEST(XmpParser, ReadExtendedXmpMissingChunk) {
+  string value;
+  EXPECT_FALSE(ReadExtendedXmpData(CreateExtensionXmpChunks(3, {0, 2}),
+                                   &value));
+}
+
+// Locates GImage:Data in the extended XMP built from the given body, split
+// into num_chunks sections.
+bool FindGImageData(const string& extension_body, int num_chunks,
+                    BlobRef* blob, string* contents) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(
+          num_chunks, kXmpExtensionHeaderPart2, extension_body.c_str());
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  *contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+  const uint8* buffer = reinterpret_cast<const uint8*>(contents->data());
+  XmpData xmp_data;
+  if (!ReadXmpFromMemory(buffer, contents->size(), true, &xmp_data)) {
+    return false;
+  }
+  return FindExtendedXmpBlob(buffer, contents->size(), xmp_data, "GImage",
+                             "Data", blob);
+}
+
+TEST(XmpParser, FindExtendedXmpBlob) {
+  const string attribute_body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+      " GImage:DataSize=\"3\" GImage:Data = 'YWJjZGVm'/>"
+      "</rdf:RDF></x:xmpmeta>";
+  const string element_body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\">"
+      "<GImage:Data>\n  YWJj\n  ZGVm\n</GImage:Data>"
+      "</rdf:Description></rdf:RDF></x:xmpmeta>";
+
+  for (const string& body : {attribute_body, element_body}) {
+    // Split the text over several sections.
+    for (int num_chunks : {1, 5, 40}) {
+      BlobRef blob;
+      string contents;
+      ASSERT_TRUE(FindGImageData(body, num_chunks, &blob, &contents))
+          << num_chunks << " " << body;
+      string decoded;
+      ASSERT_TRUE(blob.DecodeToString(&decoded));
+      EXPECT_EQ("abcdef", decoded);
+    }
+  }
+}
+
+TEST(XmpParser, FindExtendedXmpBlobNotFound) {
+  const string entity_body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+      " GImage:Data=\"YWJj&#10;ZGVm\"/>"
+      "</rdf:RDF></x:xmpmeta>";
+  BlobRef blob;
+  string contents;
+  EXPECT_FALSE(FindGImageData(entity_body, 2, &blob, &contents));
+  EXPECT_TRUE(blob.Segments().empty());
+  EXPECT_FALSE(FindGImageData(kXmpMalformedBody, 2, &blob, &contents));
+
+  // The text of a CDATA section differs from its value.
+  const string cdata_body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description"
+      " xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\">"
+      "<GImage:Data><![CDATA[aGVsbG8=]]></GImage:Data>"
+      "</rdf:Description></rdf:RDF></x:xmpmeta>";
+  EXPECT_FALSE(FindGImageData(cdata_body, 2, &blob, &contents));
+  EXPECT_TRUE(blob.Segments().empty());
+
+  // Text in a comment, or in an element other than the first rdf:Description,
+  // is not the property.
+  const string comment_body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<!-- GImage:Data=\"Ym9ndXM=\" -->"
+      "<rdf:Description xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+      " GImage:Data=\"aGVsbG8=\"/>"
+      "</rdf:RDF></x:xmpmeta>";
+  EXPECT_FALSE(FindGImageData(comment_body, 2, &blob, &contents));
+  const string later_description_body =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+      "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+      "<rdf:Description rdf:about=\"\"/>"
+      "<rdf:Description xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\""
+      " GImage:Data=\"Ym9ndXM=\"/>"
+      "</rdf:RDF></x:xmpmeta>";
+  EXPECT_FALSE(FindGImageData(later_description_body, 2, &blob, &contents));
+}
+
+TEST(XmpParser, ReadExtendedXmpLazily) {
+  const string filename = TempFileAbsolutePath("test.jpg");
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  TestXmpCreator::WriteJPEGFile(filename, xmp_sections);
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, ExtendedXmp::kLazy, &xmp_data));
+  ASSERT_NE(nullptr, xmp_data.StandardSection());
+
+  // All threads see the same extended section, which is parsed only once.
+  const int kNumThreads = 4;
+  std::vector<xmlDocPtr> extended_sections(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&xmp_data, &extended_sections, i] {
+      extended_sections[i] = xmp_data.ExtendedSection();
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  ASSERT_NE(nullptr, extended_sections[0]);
+  for (const xmlDocPtr extended_section : extended_sections) {
+    EXPECT_EQ(extended_sections[0], extended_section);
+  }
+
+  string value;
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.ExtendedSection()));
+  ASSERT_TRUE(deserializer.ParseString("GImage", "Data", &value));
+  EXPECT_EQ(string("9865"), value);
+}
+
+TEST(XmpParser, ReadExtendedXmpLazilyFromByteSource) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string contents = TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+
+  XmpData xmp_data;
+  {
+    // The source is not needed once it has been read.
+    std::unique_ptr<ByteSource> source = ByteSource::FromMemory(
+        reinterpret_cast<const uint8*>(contents.data()), contents.size());
+    ASSERT_TRUE(ReadXmpFromSource(source.get(), ExtendedXmp::kLazy,
+                                  &xmp_data, nullptr));
+  }
+  string value;
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(xmp_data.ExtendedSection()));
+  ASSERT_TRUE(deserializer.ParseString("GImage", "Data", &value));
+  EXPECT_EQ(string("9865"), value);
+}
+
+TEST(XmpParser, ReadExtendedXmpLazilyWithoutExtendedSection) {
+  const char kXmpBodyWithoutExtension[] =
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\" x:xmptk=\"Adobe XMP\">\n"
+      "  <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "    <rdf:Description rdf:about=\"\"\n"
+      "      xmlns:GImage=\"http://ns.google.com/photos/1.0/image/\"\n"
+      "      GImage:Mime=\"image/jpeg\"/>\n"
+      "  </rdf:RDF>\n"
+      "</x:xmpmeta>\n";
+  const string filename = TempFileAbsolutePath("test.jpg");
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(
+      TestXmpCreator::CreateStandardXmpString(kXmpBodyWithoutExtension));
+  TestXmpCreator::WriteJPEGFile(filename, standard_xmp);
+
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, ExtendedXmp::kLazy, &xmp_data));
+  EXPECT_NE(nullptr, xmp_data.StandardSection());
+  EXPECT_EQ(nullptr, xmp_data.ExtendedSection());
+}
+
+TEST(XmpParser, ReadExtendedXmpLazilyMalformed) {
+  const string filename = TempFileAbsolutePath("test.jpg");
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(2, kXmpExtensionHeaderPart2,
+                                                kXmpMalformedBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  TestXmpCreator::WriteJPEGFile(filename, xmp_sections);
+
+  // Reading succeeds, since the extended section is found, but it cannot be
+  // parsed.
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, ExtendedXmp::kLazy, &xmp_data));
+  EXPECT_EQ(nullptr, xmp_data.ExtendedSection());
+  EXPECT_FALSE(ReadXmpHeader(filename, ExtendedXmp::kParse, &xmp_data));
+}
+
 }  // namespace
 }  // namespace xmpmeta
@@ -14,8 +14,10 @@
 
 #include "xmpmeta/xmp_writer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -24,7 +26,7 @@
 #include <libxml/xmlstring.h>
 
 #include "glog/logging.h"
-#include "strings/util.h"
+#include "xmpmeta/file.h"
 #include "xmpmeta/jpeg_io.h"
 #include "xmpmeta/md5.h"
 #include "xmpmeta/xmp_const.h"
@@ -44,7 +46,18 @@ const char kXmlStartTag = '<';
 
 const char kCEmptyString[] = "\x00";
 const int kXmlDumpFormat = 1;
-const int kInvalidIndex = -1;
+
+// Size of the blocks used to copy section data between streams.
+const size_t kCopyBufferSize = 64 * 1024;
+
+// XMP packet wrapper, which allows the packet to be padded with whitespace.
+// The begin attribute holds the UTF-8 byte order mark.
+const char kXmpPacketBegin[] =
+    "<?xpacket begin=\"\xEF\xBB\xBF\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?>\n";
+// The "w" marks the packet as writeable in place.
+const char kXmpPacketEnd[] = "<?xpacket end=\"w\"?>";
+// Padding is split into lines of this length, including the newline.
+const size_t kXmpPaddingLineLength = 100;
 
 // Creates the outer rdf:RDF node for XMP.
 xmlNodePtr CreateXmpRdfNode() {
@@ -96,11 +109,11 @@ xmlDocPtr CreateXmpSection() {
   return xmp_meta;
 }
 
-void WriteIntTo4Bytes(int integer, std::ostream* output_stream) {
-  output_stream->put((integer >> 24) & 0xff);
-  output_stream->put((integer >> 16) & 0xff);
-  output_stream->put((integer >> 8) & 0xff);
-  output_stream->put(integer & 0xff);
+void AppendIntAs4Bytes(int integer, string* output) {
+  output->push_back(static_cast<char>((integer >> 24) & 0xff));
+  output->push_back(static_cast<char>((integer >> 16) & 0xff));
+  output->push_back(static_cast<char>((integer >> 8) & 0xff));
+  output->push_back(static_cast<char>(integer & 0xff));
 }
 
 // Serializes an XML document to a string.
@@ -111,7 +124,6 @@ void SerializeMeta(const xmlDocPtr parent, string* serialized_value) {
     return;
   }
 
-  std::ostringstream serialized_stream;
   xmlChar* xml_doc_contents;
   int doc_size = 0;
   xmlDocDumpFormatMemoryEnc(parent, &xml_doc_contents, &doc_size,
@@ -124,10 +136,9 @@ void SerializeMeta(const xmlDocPtr parent, string* serialized_value) {
   const int xmp_start_idx =
       static_cast<int>(strchr(&xml_doc_string[2],
                               kXmlStartTag) - xml_doc_string) - 1;
-  serialized_stream.write(&xml_doc_string[xmp_start_idx],
-                          doc_size - xmp_start_idx);
+  serialized_value->assign(&xml_doc_string[xmp_start_idx],
+                           doc_size - xmp_start_idx);
   xmlFree(xml_doc_contents);
-  *serialized_value = serialized_stream.str();
 }
 
 // TODO(miraleung): Switch to different library for Android if needed.
@@ -137,11 +148,11 @@ const string GetGUID(const string& to_hash) {
 
 // Creates the standard XMP section.
 void CreateStandardSectionXmpString(const string& buffer, string* value) {
-  std::ostringstream data_stream;
-  data_stream.write(XmpConst::Header(), strlen(XmpConst::Header()));
-  data_stream.write(kCEmptyString, 1);
-  data_stream.write(buffer.c_str(), buffer.length());
-  *value = data_stream.str();
+  const size_t header_length = strlen(XmpConst::Header());
+  value->reserve(header_length + 1 + buffer.length());
+  value->assign(XmpConst::Header(), header_length);
+  value->append(kCEmptyString, 1);
+  value->append(buffer);
 }
 
 // Creates the extended XMP section.
@@ -156,67 +167,31 @@ void CreateExtendedSections(const string& buffer,
   const int overhead = header_length + XmpConst::ExtensionHeaderOffset();
   const int num_sections =
       buffer_length / (XmpConst::ExtendedMaxBufferSize() - overhead) + 1;
+  extended_sections->reserve(extended_sections->size() + num_sections);
   for (int i = 0, position = 0; i < num_sections; ++i) {
     const int section_size =
         std::min(static_cast<int>(buffer_length - position + overhead),
                  XmpConst::ExtendedMaxBufferSize());
     const int bytes_from_buffer = section_size - overhead;
 
+    // Build the section in place, in a buffer of its final size.
+    extended_sections->push_back(Section(string()));
+    string* data = &extended_sections->back().data;
+    data->reserve(section_size);
+
     // Header and GUID.
-    std::ostringstream data_stream;
-    data_stream.write(XmpConst::ExtensionHeader(),
-                      strlen(XmpConst::ExtensionHeader()));
-    data_stream.write(kCEmptyString, 1);
-    data_stream.write(guid.c_str(), guid.length());
+    data->append(XmpConst::ExtensionHeader());
+    data->append(kCEmptyString, 1);
+    data->append(guid);
 
     // Total buffer length.
-    WriteIntTo4Bytes(buffer_length, &data_stream);
+    AppendIntAs4Bytes(buffer_length, data);
     // Current position.
-    WriteIntTo4Bytes(position, &data_stream);
+    AppendIntAs4Bytes(position, data);
     // Data
-    data_stream.write(&buffer[position], bytes_from_buffer);
+    data->append(buffer, position, bytes_from_buffer);
     position += bytes_from_buffer;
-
-    extended_sections->push_back(Section(data_stream.str()));
-  }
-}
-
-int InsertStandardXMPSection(const string& buffer,
-                             std::vector<Section>* sections) {
-    if (buffer.length() > XmpConst::MaxBufferSize()) {
-    LOG(WARNING) << "The standard XMP section (at size " << buffer.length()
-                 << ") cannot have a size larger than "
-                 << XmpConst::MaxBufferSize() << " bytes";
-    return kInvalidIndex;
   }
-  string value;
-  CreateStandardSectionXmpString(buffer, &value);
-  Section xmp_section(value);
-  // If we can find the old XMP section, replace it with the new one
-  for (int index = 0; index < sections->size(); ++index) {
-    if (sections->at(index).IsMarkerApp1() &&
-        HasPrefixString(sections->at(index).data, XmpConst::Header())) {
-      // Replace with the new XMP data.
-      sections->at(index) = xmp_section;
-      return index;
-    }
-  }
-  // If the first section is EXIF, insert XMP data after it.
-  // Otherwise, make XMP data the first section.
-  const int position =
-      (!sections->empty() && sections->at(0).IsMarkerApp1()) ? 1 : 0;
-  sections->emplace(sections->begin() + position, xmp_section);
-  return position;
-}
-
-// Position is the index in the Section vector where the extended sections
-// will be inserted.
-void InsertExtendedXMPSections(const string& buffer, int position,
-                               std::vector<Section>* sections) {
-  std::vector<Section> extended_sections;
-  CreateExtendedSections(buffer, &extended_sections);
-  sections->insert(sections->begin() + position, extended_sections.begin(),
-                  extended_sections.end());
 }
 
 // Returns true if the respective sections in xmp_data and their serialized
@@ -236,25 +211,65 @@ bool XmpSectionsAndSerializedDataValid(const XmpData& xmp_data,
   return is_valid;
 }
 
-// Updates a list of JPEG sections with serialized XMP data.
-bool UpdateSections(const string& main_buffer, const string& extended_buffer,
-                    std::vector<Section>* sections) {
+// Returns the size of an XMP packet holding the given serialized XMP, without
+// any padding.
+size_t GetXmpPacketSize(const string& buffer) {
+  return strlen(kXmpPacketBegin) + buffer.length() + strlen(kXmpPacketEnd);
+}
+
+// Wraps serialized XMP in an XMP packet with padding_size bytes of whitespace
+// before the trailer.
+string CreateXmpPacket(const string& buffer, size_t padding_size) {
+  string packet;
+  packet.reserve(GetXmpPacketSize(buffer) + padding_size);
+  packet.append(kXmpPacketBegin);
+  packet.append(buffer);
+  // The padding ends with a newline, so the trailer is on a line of its own.
+  for (size_t i = 0; i < padding_size; ++i) {
+    const bool end_of_line = (i % kXmpPaddingLineLength ==
+                              kXmpPaddingLineLength - 1) ||
+                             i == padding_size - 1;
+    packet.push_back(end_of_line ? '\n' : ' ');
+  }
+  packet.append(kXmpPacketEnd);
+  return packet;
+}
+
+// Creates the JPEG sections for the serialized XMP data: the standard section
+// followed by the extended sections, if any. If padding_size is not zero, the
+// standard section is wrapped in an XMP packet with up to that much padding.
+bool CreateXmpSections(const string& main_buffer, const string& extended_buffer,
+                       size_t padding_size,
+                       std::vector<Section>* xmp_sections) {
   if (main_buffer.empty()) {
     LOG(WARNING) << "Main section was empty";
     return false;
   }
-
-  // Update the list of sections with the new standard XMP section.
-  const int main_index = InsertStandardXMPSection(main_buffer, sections);
-  if (main_index < 0) {
-    LOG(WARNING) << "Could not find a valid index for inserting the "
-                 << "standard sections";
+  const size_t standard_size = padding_size > 0 ?
+      GetXmpPacketSize(main_buffer) : main_buffer.length();
+  const size_t max_standard_size =
+      static_cast<size_t>(XmpConst::MaxBufferSize());
+  if (standard_size > max_standard_size) {
+    LOG(WARNING) << "The standard XMP section (at size " << standard_size
+                 << ") cannot have a size larger than " << max_standard_size
+                 << " bytes";
     return false;
   }
+  string value;
+  if (padding_size > 0) {
+    // Reduce the padding to what fits in the section.
+    padding_size =
+        std::min(padding_size, max_standard_size - standard_size);
+    CreateStandardSectionXmpString(CreateXmpPacket(main_buffer, padding_size),
+                                   &value);
+  } else {
+    CreateStandardSectionXmpString(main_buffer, &value);
+  }
+  xmp_sections->push_back(Section(value));
 
-  // Insert the extended section right after the main section.
+  // The extended sections come right after the standard section.
   if (!extended_buffer.empty()) {
-    InsertExtendedXMPSections(extended_buffer, main_index + 1, sections);
+    CreateExtendedSections(extended_buffer, xmp_sections);
   }
   return true;
 }
@@ -275,6 +290,110 @@ void LinkXmpStandardAndExtendedSections(const string& extended_buffer,
                ToXmlChar(XmpConst::HasExtension()));
 }
 
+// Serializes the standard and extended sections of the XMP data, linking
+// them if there is an extended section.
+bool SerializeXmpData(const XmpData& xmp_data, string* main_buffer,
+                      string* extended_buffer) {
+  if (xmp_data.ExtendedSection() != nullptr) {
+    SerializeMeta(xmp_data.ExtendedSection(), extended_buffer);
+    LinkXmpStandardAndExtendedSections(*extended_buffer,
+                                       xmp_data.StandardSection());
+  }
+  SerializeMeta(xmp_data.StandardSection(), main_buffer);
+  return XmpSectionsAndSerializedDataValid(xmp_data, *main_buffer,
+                                           *extended_buffer);
+}
+
+// Serializes the XMP data into the JPEG sections that hold it.
+bool SerializeXmpSections(const XmpData& xmp_data, size_t padding_size,
+                          std::vector<Section>* xmp_sections) {
+  string main_buffer;
+  string extended_buffer;
+  return SerializeXmpData(xmp_data, &main_buffer, &extended_buffer) &&
+      CreateXmpSections(main_buffer, extended_buffer, padding_size,
+                        xmp_sections);
+}
+
+// Tests a condition on the data of an input section.
+typedef std::function<bool(const SectionIndex&)> SectionPredicate;
+// Appends bytes to the output; returns false on failure.
+typedef std::function<bool(const char*, size_t)> ByteWriter;
+// Appends the data of the given input section to the output; returns false
+// on failure.
+typedef std::function<bool(const SectionIndex&)> SectionCopier;
+
+// Returns the index of the input section at which the XMP sections are
+// written, and sets replace to true if that section is the old standard XMP
+// section. is_standard_xmp returns true if the data of the given input section
+// starts with the standard XMP header.
+size_t GetXmpSectionsPosition(const std::vector<SectionIndex>& sections,
+                              const SectionPredicate& is_standard_xmp,
+                              bool* replace) {
+  // If we can find the old XMP section, replace it with the new one.
+  for (size_t index = 0; index < sections.size(); ++index) {
+    if (sections[index].IsMarkerApp1() && is_standard_xmp(sections[index])) {
+      *replace = true;
+      return index;
+    }
+  }
+  // If the first section is EXIF, insert XMP data after it.
+  // Otherwise, make XMP data the first section.
+  *replace = false;
+  return (!sections.empty() && sections[0].IsMarkerApp1()) ? 1 : 0;
+}
+
+// Writes the input JPEG, described by sections, with the XMP sections in
+// place of its standard XMP section, as found by is_standard_xmp (see
+// GetXmpSectionsPosition). Only the section headers are rebuilt; the data of
+// the input sections is passed through by copy_section_data.
+bool WriteJpegWithXmpSections(const std::vector<SectionIndex>& sections,
+                              const std::vector<Section>& xmp_sections,
+                              const SectionPredicate& is_standard_xmp,
+                              const ByteWriter& write,
+                              const SectionCopier& copy_section_data) {
+  bool replace;
+  const size_t position =
+      GetXmpSectionsPosition(sections, is_standard_xmp, &replace);
+
+  const string start_of_image = GetStartOfImageMarker();
+  if (!write(start_of_image.data(), start_of_image.size())) {
+    return false;
+  }
+  for (size_t index = 0; index <= sections.size(); ++index) {
+    if (index == position) {
+      for (const Section& section : xmp_sections) {
+        const string header = GetSectionHeader(
+            section.marker, section.is_image_section, section.data.length());
+        if (!write(header.data(), header.size()) ||
+            !write(section.data.data(), section.data.length())) {
+          return false;
+        }
+      }
+      if (replace) {
+        continue;
+      }
+    }
+    if (index == sections.size()) {
+      break;
+    }
+    const SectionIndex& section = sections[index];
+    const string header = GetSectionHeader(
+        section.marker, section.IsImageSection(), section.length);
+    if (!write(header.data(), header.size()) || !copy_section_data(section)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the length bytes at data start with the standard XMP
+// header.
+bool HasXmpHeader(const char* data, size_t length) {
+  const size_t header_length = strlen(XmpConst::Header());
+  return length >= header_length &&
+      memcmp(data, XmpConst::Header(), header_length) == 0;
+}
+
 }  // namespace
 
 std::unique_ptr<XmpData> CreateXmpData(bool create_extended) {
@@ -288,59 +407,211 @@ std::unique_ptr<XmpData> CreateXmpData(bool create_extended) {
 
 bool WriteLeftEyeAndXmpMeta(const string& left_data, const string& filename,
                             const XmpData& xmp_data) {
-  std::istringstream input_jpeg_stream(left_data);
-
-  // Get a list of sections from the input stream.
-  ParseOptions parse_options;
-  std::vector<Section> sections = Parse(parse_options, &input_jpeg_stream);
+  // Get a list of sections from the input data, which is not copied.
+  const std::vector<SectionIndex> sections = IndexSections(
+      reinterpret_cast<const uint8*>(left_data.data()), left_data.size());
 
-  string extended_buffer;
-  if (xmp_data.ExtendedSection() != nullptr) {
-    SerializeMeta(xmp_data.ExtendedSection(), &extended_buffer);
-    LinkXmpStandardAndExtendedSections(extended_buffer,
-                                       xmp_data.StandardSection());
-  }
-  string main_buffer;
-  SerializeMeta(xmp_data.StandardSection(), &main_buffer);
-
-  // Update the input sections with the XMP data.
-  if (!XmpSectionsAndSerializedDataValid(xmp_data, main_buffer, extended_buffer)
-      || !UpdateSections(main_buffer, extended_buffer, &sections)) {
+  std::vector<Section> xmp_sections;
+  if (!SerializeXmpSections(xmp_data, 0, &xmp_sections)) {
     return false;
   }
 
   // Write the sections to the output stream.
   std::ofstream output_jpeg_stream;
-  output_jpeg_stream.open(filename, std::ostream::out);
-  WriteSections(sections, &output_jpeg_stream);
+  output_jpeg_stream.open(filename, std::ostream::out | std::ostream::binary);
+  auto is_standard_xmp = [&left_data](const SectionIndex& section) {
+    return HasXmpHeader(left_data.data() + section.file_offset,
+                        section.length);
+  };
+  auto write = [&output_jpeg_stream](const char* data, size_t size) {
+    output_jpeg_stream.write(data, size);
+    return output_jpeg_stream.good();
+  };
+  auto copy_section_data = [&](const SectionIndex& section) {
+    return write(left_data.data() + section.file_offset, section.length);
+  };
+  const bool success = WriteJpegWithXmpSections(
+      sections, xmp_sections, is_standard_xmp, write, copy_section_data);
   output_jpeg_stream.close();
-  return true;
+  return success;
 }
 
 bool AddXmpMetaToJpegStream(std::istream* input_jpeg_stream,
                             const XmpData& xmp_data,
                             std::ostream* output_jpeg_stream) {
-  // Get a list of sections from the input stream.
-  ParseOptions parse_options;
-  std::vector<Section> sections = Parse(parse_options, input_jpeg_stream);
+  return AddXmpMetaToJpegStream(input_jpeg_stream, xmp_data, XmpWriteOptions(),
+                                output_jpeg_stream);
+}
 
-  string extended_buffer;
-  if (xmp_data.ExtendedSection() != nullptr) {
-    SerializeMeta(xmp_data.ExtendedSection(), &extended_buffer);
-    LinkXmpStandardAndExtendedSections(extended_buffer,
-                                       xmp_data.StandardSection());
+bool AddXmpMetaToJpegStream(std::istream* input_jpeg_stream,
+                            const XmpData& xmp_data,
+                            const XmpWriteOptions& options,
+                            std::ostream* output_jpeg_stream) {
+  // Get the locations of the sections in the input stream, so that their data
+  // can be copied to the output without holding the whole image in memory.
+  const std::streamoff start = input_jpeg_stream->tellg();
+  const std::vector<SectionIndex> sections =
+      IndexSections(input_jpeg_stream);
+
+  std::vector<Section> xmp_sections;
+  if (!SerializeXmpSections(xmp_data, options.padding_size, &xmp_sections)) {
+    return false;
+  }
+
+  std::vector<char> buffer(kCopyBufferSize);
+  const size_t header_length = strlen(XmpConst::Header());
+  auto is_standard_xmp = [&](const SectionIndex& section) {
+    if (section.length < header_length) {
+      return false;
+    }
+    input_jpeg_stream->clear();
+    input_jpeg_stream->seekg(
+        start + static_cast<std::streamoff>(section.file_offset));
+    input_jpeg_stream->read(buffer.data(), header_length);
+    return input_jpeg_stream->good() &&
+        HasXmpHeader(buffer.data(), header_length);
+  };
+  auto write = [output_jpeg_stream](const char* data, size_t size) {
+    output_jpeg_stream->write(data, size);
+    return output_jpeg_stream->good();
+  };
+  auto copy_section_data = [&](const SectionIndex& section) {
+    input_jpeg_stream->clear();
+    input_jpeg_stream->seekg(
+        start + static_cast<std::streamoff>(section.file_offset));
+    for (size_t remaining = section.length; remaining > 0;) {
+      const size_t length = std::min(remaining, buffer.size());
+      input_jpeg_stream->read(buffer.data(), length);
+      if (!input_jpeg_stream->good() || !write(buffer.data(), length)) {
+        return false;
+      }
+      remaining -= length;
+    }
+    return true;
+  };
+  return WriteJpegWithXmpSections(sections, xmp_sections, is_standard_xmp,
+                                  write, copy_section_data);
+}
+
+bool AddXmpMetaToJpegFile(const string& input_filename,
+                          const XmpData& xmp_data,
+                          const string& output_filename) {
+  return AddXmpMetaToJpegFile(input_filename, xmp_data, XmpWriteOptions(),
+                              output_filename);
+}
+
+bool AddXmpMetaToJpegFile(const string& input_filename,
+                          const XmpData& xmp_data,
+                          const XmpWriteOptions& options,
+                          const string& output_filename) {
+  // Only the section headers and the start of the APP1 sections are read
+  // through the mapping; the rest of the file is copied by the kernel.
+  std::unique_ptr<MemoryMappedFile> input_file =
+      MemoryMappedFile::FromFile(input_filename);
+  if (input_file == nullptr) {
+    return false;
+  }
+  const std::vector<SectionIndex> sections =
+      IndexSections(input_file->data(), input_file->size());
+  if (sections.empty()) {
+    LOG(ERROR) << "No JPEG sections found in " << input_filename;
+    return false;
   }
+
+  std::vector<Section> xmp_sections;
+  if (!SerializeXmpSections(xmp_data, options.padding_size, &xmp_sections)) {
+    return false;
+  }
+
+  std::unique_ptr<FileRangeWriter> output_file =
+      FileRangeWriter::Create(input_filename, output_filename);
+  if (output_file == nullptr) {
+    return false;
+  }
+  const char* input_data = reinterpret_cast<const char*>(input_file->data());
+  auto is_standard_xmp = [input_data](const SectionIndex& section) {
+    return HasXmpHeader(input_data + section.file_offset, section.length);
+  };
+  auto write = [&output_file](const char* data, size_t size) {
+    return output_file->Write(data, size);
+  };
+  auto copy_section_data = [&output_file](const SectionIndex& section) {
+    return output_file->CopyRange(section.file_offset, section.length);
+  };
+  // The section headers and the XMP sections are gathered by the writer, and
+  // written with one call before each range of the input is copied. The
+  // output file is only replaced once all of it has been written.
+  return WriteJpegWithXmpSections(sections, xmp_sections, is_standard_xmp,
+                                  write, copy_section_data) &&
+      output_file->Commit();
+}
+
+bool UpdateXmpInPlace(const string& filename, const XmpData& xmp_data) {
+  std::unique_ptr<MemoryMappedFile> file = MemoryMappedFile::FromFile(filename);
+  if (file == nullptr) {
+    return false;
+  }
+  const char* file_data = reinterpret_cast<const char*>(file->data());
+  const std::vector<SectionIndex> sections =
+      IndexSections(file->data(), file->size());
+
   string main_buffer;
-  SerializeMeta(xmp_data.StandardSection(), &main_buffer);
+  string extended_buffer;
+  if (!SerializeXmpData(xmp_data, &main_buffer, &extended_buffer)) {
+    return false;
+  }
+  // The extended sections are named by the hash of their contents, so they
+  // are unchanged only if the file already has sections with that name.
+  string extended_header;
+  if (!extended_buffer.empty()) {
+    extended_header = XmpConst::ExtensionHeader();
+    extended_header += '\0' + GetGUID(extended_buffer);
+  }
 
-  // Update the input sections with the XMP data.
-  if (!XmpSectionsAndSerializedDataValid(xmp_data, main_buffer, extended_buffer)
-      || !UpdateSections(main_buffer, extended_buffer, &sections)) {
+  const SectionIndex* standard_section = nullptr;
+  bool has_extended_sections = extended_header.empty();
+  for (const SectionIndex& section : sections) {
+    if (!section.IsMarkerApp1()) {
+      continue;
+    }
+    const char* data = file_data + section.file_offset;
+    if (standard_section == nullptr && HasXmpHeader(data, section.length)) {
+      standard_section = &section;
+    } else if (!has_extended_sections &&
+               section.length >= extended_header.size() &&
+               memcmp(data, extended_header.data(),
+                      extended_header.size()) == 0) {
+      has_extended_sections = true;
+    }
+  }
+  if (standard_section == nullptr) {
+    LOG(WARNING) << "No standard XMP section to update in " << filename;
+    return false;
+  }
+  if (!has_extended_sections) {
+    LOG(WARNING) << "The extended XMP sections of " << filename
+                 << " changed and cannot be updated in place";
     return false;
   }
 
-  WriteSections(sections, output_jpeg_stream);
-  return true;
+  // The new packet is padded to the exact size of the old section.
+  const size_t header_size = strlen(XmpConst::Header()) + 1;
+  const size_t packet_size = GetXmpPacketSize(main_buffer);
+  if (header_size + packet_size > standard_section->length) {
+    LOG(WARNING) << "The standard XMP section (at size "
+                 << header_size + packet_size << ") does not fit in the "
+                 << standard_section->length << " bytes available in "
+                 << filename;
+    return false;
+  }
+  string value;
+  CreateStandardSectionXmpString(
+      CreateXmpPacket(main_buffer,
+                      standard_section->length - header_size - packet_size),
+      &value);
+  const size_t offset = standard_section->file_offset;
+  file.reset();
+  return WriteStringToFileAt(value, offset, filename);
 }
 
 }  // namespace xmpmeta
@@ -14,7 +14,11 @@
 
 #include "xmpmeta/xmp_writer.h"
 
+#include <unistd.h>
+
+#include <cstdio>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -22,6 +26,7 @@
 
 #include "base/port.h"
 #include "xmpmeta/file.h"
+#include "xmpmeta/jpeg_io.h"
 #include "xmpmeta/test_util.h"
 #include "xmpmeta/test_xmp_creator.h"
 #include "xmpmeta/xmp_const.h"
@@ -464,6 +469,170 @@ std::vector<string> standard_xmp;
                                      "new_file.jpg", xmp_data));
 }
 
+TEST(XmpWriter, AddXmpMetaToJpegStreamReplacesStandardXmp) {
+  std::vector<string> xmp_sections =
+      TestXmpCreator::CreateExtensionXmpStrings(1, kXmpExtensionHeaderPart2,
+                                                kXmpExtensionBody);
+  xmp_sections.insert(xmp_sections.begin(),
+                      TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string input_data =
+      TestXmpCreator::MakeJPEGFileContents(xmp_sections);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(input_data, false, &xmp_data));
+
+  std::istringstream input_stream(input_data);
+  std::ostringstream output_stream;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&input_stream, xmp_data, &output_stream));
+
+  // The old standard section is replaced, the new extended section follows it,
+  // and the remaining sections are passed through unchanged.
+  std::istringstream output_data(output_stream.str());
+  const std::vector<Section> sections = Parse(ParseOptions(), &output_data);
+  ASSERT_EQ(4u, sections.size());
+  EXPECT_EQ(0u, sections[0].data.find(XmpConst::Header()));
+  EXPECT_EQ(0u, sections[1].data.find(XmpConst::ExtensionHeader()));
+  EXPECT_EQ(TestXmpCreator::CreateExtensionXmpStrings(
+                1, kXmpExtensionHeaderPart2, kXmpExtensionBody)[0],
+            sections[2].data);
+  EXPECT_TRUE(sections[3].is_image_section);
+  EXPECT_EQ(TestXmpCreator::GetFakeJpegPayload().substr(2), sections[3].data);
+
+  XmpData new_xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(output_stream.str(), true, &new_xmp_data));
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(new_xmp_data.StandardSection()));
+  string value;
+  ASSERT_TRUE(deserializer.ParseString(kPrefix, kMimeName, &value));
+  EXPECT_EQ(string(kMimeValue), value);
+}
+
+TEST(XmpWriter, AddXmpMetaToJpegFile) {
+  const string in_filename = TempFileAbsolutePath(kInFile);
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  TestXmpCreator::WriteJPEGFile(in_filename, standard_xmp);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(in_filename, true, &xmp_data));
+
+  const string out_filename = TempFileAbsolutePath(kOutFile);
+  ASSERT_TRUE(AddXmpMetaToJpegFile(in_filename, xmp_data, out_filename));
+
+  // The output matches that of the stream writer.
+  string input_data;
+  ReadFileToStringOrDie(in_filename, &input_data);
+  std::istringstream input_stream(input_data);
+  std::ostringstream output_stream;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&input_stream, xmp_data, &output_stream));
+  string output_data;
+  ReadFileToStringOrDie(out_filename, &output_data);
+  EXPECT_EQ(output_stream.str(), output_data);
+
+  EXPECT_FALSE(AddXmpMetaToJpegFile(in_filename, xmp_data, in_filename));
+  EXPECT_FALSE(AddXmpMetaToJpegFile(TempFileAbsolutePath("missing.jpg"),
+                                    xmp_data, out_filename));
+
+  // A link to the input is the input, and is left unchanged.
+  const string link_filename = TempFileAbsolutePath("link.jpg");
+  remove(link_filename.c_str());
+  ASSERT_EQ(0, symlink(in_filename.c_str(), link_filename.c_str()));
+  EXPECT_FALSE(AddXmpMetaToJpegFile(in_filename, xmp_data, link_filename));
+  string link_data;
+  ReadFileToStringOrDie(link_filename, &link_data);
+  EXPECT_EQ(input_data, link_data);
+}
+
+TEST(XmpWriter, AddXmpMetaToJpegStreamWithPadding) {
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  const string input_data = TestXmpCreator::MakeJPEGFileContents(standard_xmp);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(input_data, true, &xmp_data));
+
+  XmpWriteOptions options;
+  options.padding_size = 2048;
+  std::istringstream input_stream(input_data);
+  std::ostringstream output_stream;
+  ASSERT_TRUE(AddXmpMetaToJpegStream(&input_stream, xmp_data, options,
+                                     &output_stream));
+
+  std::istringstream output_data(output_stream.str());
+  const std::vector<Section> sections = Parse(ParseOptions(), &output_data);
+  ASSERT_EQ(2u, sections.size());
+  const string& xmp_section = sections[0].data;
+  EXPECT_EQ(0u, xmp_section.find(XmpConst::Header()));
+  EXPECT_NE(string::npos, xmp_section.find("<?xpacket begin="));
+  EXPECT_EQ(xmp_section.size() - strlen("<?xpacket end=\"w\"?>"),
+            xmp_section.rfind("<?xpacket end=\"w\"?>"));
+  EXPECT_NE(string::npos, xmp_section.find(string(99, ' ') + "\n"));
+
+  // The packet wrapper and padding are not part of the parsed XMP.
+  XmpData new_xmp_data;
+  ASSERT_TRUE(ReadXmpFromMemory(output_stream.str(), true, &new_xmp_data));
+  EXPECT_EQ(xml::XmlDocToString(xmp_data.StandardSection()),
+            xml::XmlDocToString(new_xmp_data.StandardSection()));
+}
+
+TEST(XmpWriter, UpdateXmpInPlace) {
+  const string in_filename = TempFileAbsolutePath(kInFile);
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  TestXmpCreator::WriteJPEGFile(in_filename, standard_xmp);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(in_filename, true, &xmp_data));
+  const string out_filename = TempFileAbsolutePath(kOutFile);
+  XmpWriteOptions options;
+  options.padding_size = 1024;
+  ASSERT_TRUE(
+      AddXmpMetaToJpegFile(in_filename, xmp_data, options, out_filename));
+  string old_contents;
+  ReadFileToStringOrDie(out_filename, &old_contents);
+
+  // Change a property and update the file in place.
+  xmlNodePtr description_node =
+      GetFirstDescriptionElement(xmp_data.StandardSection());
+  xmlNsPtr ns = xmlSearchNs(xmp_data.StandardSection(), description_node,
+                            ToXmlChar(kPrefix));
+  ASSERT_NE(nullptr, ns);
+  xmlSetNsProp(description_node, ns, ToXmlChar(kMimeName),
+               ToXmlChar("image/png"));
+  ASSERT_TRUE(UpdateXmpInPlace(out_filename, xmp_data));
+
+  string new_contents;
+  ReadFileToStringOrDie(out_filename, &new_contents);
+  ASSERT_EQ(old_contents.size(), new_contents.size());
+  const string payload = TestXmpCreator::GetFakeJpegPayload();
+  EXPECT_EQ(payload, new_contents.substr(new_contents.size() - payload.size()));
+
+  XmpData new_xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(out_filename, true, &new_xmp_data));
+  DeserializerImpl deserializer(
+      GetFirstDescriptionElement(new_xmp_data.StandardSection()));
+  string value;
+  ASSERT_TRUE(deserializer.ParseString(kPrefix, kMimeName, &value));
+  EXPECT_EQ("image/png", value);
+}
+
+TEST(XmpWriter, UpdateXmpInPlaceDoesNotFit) {
+  const string filename = TempFileAbsolutePath(kInFile);
+  std::vector<string> standard_xmp;
+  standard_xmp.push_back(TestXmpCreator::CreateStandardXmpString(kXmpBody));
+  TestXmpCreator::WriteJPEGFile(filename, standard_xmp);
+  XmpData xmp_data;
+  ASSERT_TRUE(ReadXmpHeader(filename, true, &xmp_data));
+  string old_contents;
+  ReadFileToStringOrDie(filename, &old_contents);
+
+  // The section has no padding, so there is no room for the packet wrapper.
+  EXPECT_FALSE(UpdateXmpInPlace(filename, xmp_data));
+  string new_contents;
+  ReadFileToStringOrDie(filename, &new_contents);
+  EXPECT_EQ(old_contents, new_contents);
+
+  // Files without a standard XMP section cannot be updated in place either.
+  TestXmpCreator::WriteJPEGFile(filename, std::vector<string>());
+  EXPECT_FALSE(UpdateXmpInPlace(filename, xmp_data));
+}
+
 TEST(XmpWriter, WriteXmpStandardXmpLimit) {
   const string out_filename = TempFileAbsolutePath(kOutFile);
   int xmp_max_payload_size =  XmpConst::MaxBufferSize()
@@ -44,12 +44,16 @@
       ],
       'sources': [
         '<(xmpmeta_dir)/base64.cc',
+        '<(xmpmeta_dir)/blob_ref.cc',
+        '<(xmpmeta_dir)/byte_source.cc',
+        '<(xmpmeta_dir)/file.cc',
         '<(xmpmeta_dir)/gaudio.cc',
         '<(xmpmeta_dir)/gimage.cc',
         '<(xmpmeta_dir)/gpano.cc',
         '<(xmpmeta_dir)/jpeg_io.cc',
         '<(xmpmeta_dir)/md5.cc',
         '<(xmpmeta_dir)/vr_photo_writer.cc',
+        '<(xmpmeta_dir)/xmp_batch.cc',
         '<(xmpmeta_dir)/xmp_const.cc',
         '<(xmpmeta_dir)/xmp_data.cc',
         '<(xmpmeta_dir)/xmp_parser.cc',